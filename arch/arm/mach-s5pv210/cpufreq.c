@@ -311,6 +311,7 @@ static int s5pv210_target(struct cpufreq_policy *policy,
 			  unsigned int relation)
 {
 	unsigned long reg;
+	unsigned long g3d_div = 0;
 	unsigned int index;
 	unsigned int pll_changing = 0;
 	unsigned int bus_speed_changing = 0;
@@ -414,8 +415,11 @@ static int s5pv210_target(struct cpufreq_policy *policy,
 		/*
 		 * 1. Temporary Change divider for MFC and G3D
 		 * SCLKA2M(200/1=200)->(200/4=50)Mhz
+		 * The G3D divider may have been lowered by the SGX DVFS
+		 * driver; remember it so step 8 puts it back.
 		 */
 		reg = __raw_readl(S5P_CLK_DIV2);
+		g3d_div = reg & S5P_CLKDIV2_G3D_MASK;
 		reg &= ~(S5P_CLKDIV2_G3D_MASK | S5P_CLKDIV2_MFC_MASK);
 		reg |= (3 << S5P_CLKDIV2_G3D_SHIFT) |
 			(3 << S5P_CLKDIV2_MFC_SHIFT);
@@ -547,11 +551,11 @@ static int s5pv210_target(struct cpufreq_policy *policy,
 
 		/*
 		 * 8. Change divider for MFC and G3D
-		 * (200/4=50)->(200/1=200)Mhz
+		 * (200/4=50)->(200/1=200)Mhz, G3D back to what it was
 		 */
 		reg = __raw_readl(S5P_CLK_DIV2);
 		reg &= ~(S5P_CLKDIV2_G3D_MASK | S5P_CLKDIV2_MFC_MASK);
-		reg |= (clkdiv_val[index][10] << S5P_CLKDIV2_G3D_SHIFT) |
+		reg |= g3d_div |
 			(clkdiv_val[index][9] << S5P_CLKDIV2_MFC_SHIFT);
 		__raw_writel(reg, S5P_CLK_DIV2);
 
@@ -177,13 +177,7 @@ static int check_power_clock_gating(void)
 #ifdef CONFIG_S5P_INTERNAL_DMA
 static int check_idmapos(void)
 {
-	dma_addr_t src;
-
-	i2sdma_getpos(&src);
-	src = src & 0x3FFF;
-	src = 0x4000 - src;
-
-	return src < 0x150;
+	return i2sdma_bytes_to_irq() < 0x150;
 }
 #endif
 
@@ -21,5 +21,5 @@ extern int s5p_get_lowpower_lock(void);
 
 extern int  s5pv210_didle_save(unsigned long *saveblk);
 extern void s5pv210_didle_resume(void);
-extern void i2sdma_getpos(dma_addr_t *src);
+extern unsigned int i2sdma_bytes_to_irq(void);
 extern unsigned int get_rtc_cnt(void);
@@ -299,6 +299,8 @@ static struct s3cfb_lcd s6e63m0 = {
 #else
 	.freq = 60,
 #endif
+	/* not checked for flicker below .freq yet, see min_refresh in sysfs */
+	.min_freq = 0,
 
 	.timing = {
 		.h_fp = 16,
@@ -0,0 +1,54 @@
+/* linux/arch/arm/plat-s5p/include/plat/media-buf.h
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Shared physical buffer handles for the S5P multimedia devices
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+*/
+
+#ifndef _S5P_MEDIA_BUF_H
+#define _S5P_MEDIA_BUF_H
+
+#include <linux/types.h>
+
+#define S5P_MEDIA_BUF_MAX_PLANES	3
+
+struct file;
+
+struct s5p_media_buf_plane {
+	dma_addr_t	paddr;
+	size_t		size;
+};
+
+/*
+ * A buffer handed from one multimedia block to another by physical
+ * address, so that e.g. a decoded MFC frame can be scanned out by FIMC
+ * or FIMD without a copy. The exporter owns the memory and allocates
+ * this descriptor; userspace only ever sees a file descriptor for it.
+ * When the last reference to that file goes away, release() is called
+ * and must free the descriptor.
+ *
+ * cpu_cached tells the importer whether the exporter may hand the same
+ * memory to the CPU through a cacheable mapping. When it is clear the
+ * importer can skip cache maintenance entirely.
+ */
+struct s5p_media_buf {
+	const char			*exporter;
+	unsigned int			nr_planes;
+	struct s5p_media_buf_plane	plane[S5P_MEDIA_BUF_MAX_PLANES];
+	bool				cpu_cached;
+
+	void				(*release)(struct s5p_media_buf *buf);
+	void				*priv;
+
+	struct file			*file;
+};
+
+extern int s5p_media_buf_export(struct s5p_media_buf *buf);
+extern struct s5p_media_buf *s5p_media_buf_get(int fd);
+extern void s5p_media_buf_put(struct s5p_media_buf *buf);
+
+#endif /* _S5P_MEDIA_BUF_H */
@@ -0,0 +1,109 @@
+/* linux/arch/arm/plat-s5p/media-buf.c
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Shared physical buffer handles for the S5P multimedia devices
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/err.h>
+#include <linux/fs.h>
+#include <linux/file.h>
+#include <linux/anon_inodes.h>
+#include <linux/atomic.h>
+
+#include <plat/media-buf.h>
+
+static atomic_t s5p_media_buf_count = ATOMIC_INIT(0);
+
+static int s5p_media_buf_release(struct inode *inode, struct file *file)
+{
+	struct s5p_media_buf *buf = file->private_data;
+
+	atomic_dec(&s5p_media_buf_count);
+	buf->release(buf);
+
+	return 0;
+}
+
+static const struct file_operations s5p_media_buf_fops = {
+	.owner		= THIS_MODULE,
+	.release	= s5p_media_buf_release,
+};
+
+/*
+ * Wrap @buf in a new file and install it in the caller's fd table.
+ * On success the file owns @buf and @buf->release() runs once every
+ * reference (the fd and any s5p_media_buf_get()) has been dropped.
+ * On failure nothing is released and the caller still owns @buf.
+ */
+int s5p_media_buf_export(struct s5p_media_buf *buf)
+{
+	struct file *file;
+	unsigned int i;
+	int fd;
+
+	if (!buf->release || buf->nr_planes == 0 ||
+	    buf->nr_planes > S5P_MEDIA_BUF_MAX_PLANES)
+		return -EINVAL;
+
+	for (i = 0; i < buf->nr_planes; i++) {
+		if (!buf->plane[i].paddr || !buf->plane[i].size)
+			return -EINVAL;
+	}
+
+	fd = get_unused_fd_flags(O_CLOEXEC);
+	if (fd < 0)
+		return fd;
+
+	file = anon_inode_getfile("s5p-media-buf", &s5p_media_buf_fops,
+				  buf, O_RDWR);
+	if (IS_ERR(file)) {
+		put_unused_fd(fd);
+		return PTR_ERR(file);
+	}
+
+	buf->file = file;
+	atomic_inc(&s5p_media_buf_count);
+	fd_install(fd, file);
+
+	pr_debug("%s: %s exported %u plane(s) at 0x%08x as fd %d (%d live)\n",
+		 __func__, buf->exporter, buf->nr_planes, buf->plane[0].paddr,
+		 fd, atomic_read(&s5p_media_buf_count));
+
+	return fd;
+}
+EXPORT_SYMBOL(s5p_media_buf_export);
+
+/*
+ * Take a reference on the buffer behind @fd. The importer must hold it
+ * for as long as the hardware may access the planes, and drop it with
+ * s5p_media_buf_put() afterwards.
+ */
+struct s5p_media_buf *s5p_media_buf_get(int fd)
+{
+	struct file *file;
+
+	file = fget(fd);
+	if (!file)
+		return ERR_PTR(-EBADF);
+
+	if (file->f_op != &s5p_media_buf_fops) {
+		fput(file);
+		return ERR_PTR(-EINVAL);
+	}
+
+	return file->private_data;
+}
+EXPORT_SYMBOL(s5p_media_buf_get);
+
+void s5p_media_buf_put(struct s5p_media_buf *buf)
+{
+	fput(buf->file);
+}
+EXPORT_SYMBOL(s5p_media_buf_put);
@@ -4783,7 +4783,8 @@ CommonBridgeInit(IMG_VOID)
 }
 
 IMG_INT BridgedDispatchKM(PVRSRV_PER_PROCESS_DATA * psPerProc,
-					  PVRSRV_BRIDGE_PACKAGE   * psBridgePackageKM)
+					  PVRSRV_BRIDGE_PACKAGE   * psBridgePackageKM,
+					  IMG_VOID                * pvBridgeData)
 {
 	IMG_VOID   * psBridgeIn;
 	IMG_VOID   * psBridgeOut;
@@ -4843,12 +4844,7 @@ IMG_INT BridgedDispatchKM(PVRSRV_PER_PROCESS_DATA * psPerProc,
 #if defined(__linux__)
 	{
 		
-		SYS_DATA *psSysData;
-
-		SysAcquireData(&psSysData);
-
-		
-		psBridgeIn = ((ENV_DATA *)psSysData->pvEnvSpecificData)->pvBridgeData;
+		psBridgeIn = pvBridgeData;
 		psBridgeOut = (IMG_PVOID)((IMG_PBYTE)psBridgeIn + PVRSRV_MAX_BRIDGE_IN_SIZE);
 
 		
@@ -4880,6 +4876,8 @@ IMG_INT BridgedDispatchKM(PVRSRV_PER_PROCESS_DATA * psPerProc,
 		}
 	}
 #else
+	PVR_UNREFERENCED_PARAMETER(pvBridgeData);
+
 	psBridgeIn  = psBridgePackageKM->pvParamIn;
 	psBridgeOut = psBridgePackageKM->pvParamOut;
 #endif
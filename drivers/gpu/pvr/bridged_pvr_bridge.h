@@ -222,7 +222,8 @@ extern PVRSRV_BRIDGE_GLOBAL_STATS g_BridgeGlobalStats;
 PVRSRV_ERROR CommonBridgeInit(IMG_VOID);
 
 IMG_INT BridgedDispatchKM(PVRSRV_PER_PROCESS_DATA * psPerProc,
-					  PVRSRV_BRIDGE_PACKAGE   * psBridgePackageKM);
+					  PVRSRV_BRIDGE_PACKAGE   * psBridgePackageKM,
+					  IMG_VOID                * pvBridgeData);
 
 #if defined (__cplusplus)
 }
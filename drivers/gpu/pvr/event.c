@@ -49,6 +49,7 @@
 #include <asm/hardirq.h>
 #include <linux/spinlock.h>
 #include <linux/timer.h>
+#include <linux/ktime.h>
 #include <linux/capability.h>
 #include <linux/sched.h>
 #include <asm/uaccess.h>
@@ -255,6 +256,8 @@ PVRSRV_ERROR LinuxEventObjectSignal(IMG_HANDLE hOSEventObjectList)
 PVRSRV_ERROR LinuxEventObjectWait(IMG_HANDLE hOSEventObject, IMG_UINT32 ui32MSTimeout)
 {
 	IMG_UINT32 ui32TimeStamp;
+	PVRSRV_LINUX_MUTEX *psProcessLock;
+	ktime_t sDropped;
 	DEFINE_WAIT(sWait);
 
 	PVRSRV_LINUX_EVENT_OBJECT *psLinuxEventObject = (PVRSRV_LINUX_EVENT_OBJECT *) hOSEventObject;
@@ -271,11 +274,24 @@ PVRSRV_ERROR LinuxEventObjectWait(IMG_HANDLE hOSEventObject, IMG_UINT32 ui32MSTi
 			break;
 		}
 
+		psProcessLock = gpsPVRSRVProcessLock;
+		if (psProcessLock != IMG_NULL)
+		{
+			gpsPVRSRVProcessLock = IMG_NULL;
+			LinuxUnLockMutex(psProcessLock);
+		}
 		LinuxUnLockMutex(&gPVRSRVLock);		
 
+		sDropped = ktime_get();
 		ui32TimeOutJiffies = (IMG_UINT32)schedule_timeout((IMG_INT32)ui32TimeOutJiffies);
 		
 		LinuxLockMutex(&gPVRSRVLock);
+		gui32PVRSRVLockDroppedus += (IMG_UINT32)ktime_us_delta(ktime_get(), sDropped);
+		if (psProcessLock != IMG_NULL)
+		{
+			LinuxLockMutex(psProcessLock);
+			gpsPVRSRVProcessLock = psProcessLock;
+		}
 #if defined(DEBUG)
 		psLinuxEventObject->ui32Stats++;
 #endif			
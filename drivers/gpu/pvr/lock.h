@@ -29,4 +29,7 @@
 
 extern PVRSRV_LINUX_MUTEX gPVRSRVLock;
 
+extern PVRSRV_LINUX_MUTEX *gpsPVRSRVProcessLock;
+extern IMG_UINT32 gui32PVRSRVLockDroppedus;
+
 #endif 
@@ -41,6 +41,10 @@
 #include <linux/slab.h>
 #include <linux/highmem.h>
 #include <linux/sched.h>
+#include <linux/spinlock.h>
+#if defined(__arm__)
+#include <asm/cacheflush.h>
+#endif
 
 #include "img_defs.h"
 #include "services.h"
@@ -172,6 +176,189 @@ static void ProcSeqStartstopDebugMutex(struct seq_file *sfile,IMG_BOOL start);
 
 static LinuxKMemCache *psLinuxMemAreaCache;
 
+#if !defined(PVR_LINUX_PAGE_POOL_MAX_PAGES)
+#define PVR_LINUX_PAGE_POOL_MAX_PAGES		1024
+#endif
+
+#if !defined(PVR_LINUX_PAGE_POOL_FLUSH_ALL_PAGES)
+#define PVR_LINUX_PAGE_POOL_FLUSH_ALL_PAGES	64
+#endif
+
+/*
+ * Pages freed from LINUX_MEM_AREA_ALLOC_PAGES areas are kept here, clean in
+ * the CPU caches, so that the next allocation doesn't go back to the page
+ * allocator or need a cache invalidate when it is mapped uncached.
+ */
+typedef struct _LINUX_PAGE_POOL_STATS
+{
+    IMG_UINT32 ui32Hits;
+    IMG_UINT32 ui32Misses;
+    IMG_UINT32 ui32PagesPooled;
+    IMG_UINT32 ui32PagesOverflowed;
+    IMG_UINT32 ui32PagesShrunk;
+    IMG_UINT32 ui32PageCleans;
+    IMG_UINT32 ui32FullCleans;
+} LINUX_PAGE_POOL_STATS;
+
+static LIST_HEAD(g_sPagePoolList);
+static IMG_UINT32 g_ui32PagePoolCount;
+static LINUX_PAGE_POOL_STATS g_sPagePoolStats;
+static DEFINE_SPINLOCK(g_sPagePoolLock);
+static struct proc_dir_entry *g_SeqFilePagePool;
+
+static IMG_BOOL PagePoolCleanPages(struct page **ppsPageList, IMG_UINT32 ui32PageCount)
+{
+#if defined(__arm__)
+    
+    if(ui32PageCount < PVR_LINUX_PAGE_POOL_FLUSH_ALL_PAGES)
+    {
+        IMG_UINT32 i;
+
+        for(i = 0; i < ui32PageCount; i++)
+        {
+            IMG_VOID *pvPageVAddr = kmap(ppsPageList[i]);
+
+            dmac_flush_range(pvPageVAddr, pvPageVAddr + PAGE_SIZE);
+            kunmap(ppsPageList[i]);
+#if defined(CONFIG_OUTER_CACHE)
+            outer_flush_range(page_to_phys(ppsPageList[i]),
+                              page_to_phys(ppsPageList[i]) + PAGE_SIZE);
+#endif
+        }
+        return IMG_FALSE;
+    }
+#else
+    PVR_UNREFERENCED_PARAMETER(ppsPageList);
+#endif
+
+    OSFlushCPUCacheKM();
+    return IMG_TRUE;
+}
+
+static IMG_UINT32 PagePoolAlloc(struct page **ppsPageList, IMG_UINT32 ui32PageCount)
+{
+    IMG_UINT32 ui32Taken = 0;
+
+    spin_lock(&g_sPagePoolLock);
+    while(ui32Taken < ui32PageCount && !list_empty(&g_sPagePoolList))
+    {
+        struct page *psPage = list_first_entry(&g_sPagePoolList, struct page, lru);
+
+        list_del(&psPage->lru);
+        ppsPageList[ui32Taken++] = psPage;
+    }
+    g_ui32PagePoolCount -= ui32Taken;
+    g_sPagePoolStats.ui32Hits += ui32Taken;
+    g_sPagePoolStats.ui32Misses += ui32PageCount - ui32Taken;
+    spin_unlock(&g_sPagePoolLock);
+
+    return ui32Taken;
+}
+
+static IMG_VOID PagePoolFree(struct page **ppsPageList, IMG_UINT32 ui32PageCount)
+{
+    IMG_UINT32 ui32Pooled, i;
+    IMG_BOOL bFullClean;
+
+    spin_lock(&g_sPagePoolLock);
+    ui32Pooled = PVR_LINUX_PAGE_POOL_MAX_PAGES - g_ui32PagePoolCount;
+    spin_unlock(&g_sPagePoolLock);
+
+    if(ui32Pooled > ui32PageCount)
+    {
+        ui32Pooled = ui32PageCount;
+    }
+
+    
+    bFullClean = (ui32Pooled != 0) ? PagePoolCleanPages(ppsPageList, ui32Pooled) : IMG_FALSE;
+
+    spin_lock(&g_sPagePoolLock);
+    if(bFullClean)
+    {
+        g_sPagePoolStats.ui32FullCleans++;
+    }
+    else
+    {
+        g_sPagePoolStats.ui32PageCleans += ui32Pooled;
+    }
+    for(i = 0; i < ui32Pooled && g_ui32PagePoolCount < PVR_LINUX_PAGE_POOL_MAX_PAGES; i++)
+    {
+        list_add(&ppsPageList[i]->lru, &g_sPagePoolList);
+        g_ui32PagePoolCount++;
+    }
+    g_sPagePoolStats.ui32PagesPooled += i;
+    g_sPagePoolStats.ui32PagesOverflowed += ui32PageCount - i;
+    spin_unlock(&g_sPagePoolLock);
+
+    for(; i < ui32PageCount; i++)
+    {
+        __free_pages(ppsPageList[i], 0);
+    }
+}
+
+static IMG_UINT32 PagePoolDrain(IMG_UINT32 ui32PageCount)
+{
+    LIST_HEAD(sFreeList);
+    struct page *psPage, *psPageTmp;
+    IMG_UINT32 ui32Remaining;
+
+    spin_lock(&g_sPagePoolLock);
+    while(ui32PageCount-- && !list_empty(&g_sPagePoolList))
+    {
+        list_move(g_sPagePoolList.next, &sFreeList);
+        g_ui32PagePoolCount--;
+        g_sPagePoolStats.ui32PagesShrunk++;
+    }
+    ui32Remaining = g_ui32PagePoolCount;
+    spin_unlock(&g_sPagePoolLock);
+
+    list_for_each_entry_safe(psPage, psPageTmp, &sFreeList, lru)
+    {
+        list_del(&psPage->lru);
+        __free_pages(psPage, 0);
+    }
+
+    return ui32Remaining;
+}
+
+static int PagePoolShrink(struct shrinker *psShrinker, struct shrink_control *psShrinkControl)
+{
+    PVR_UNREFERENCED_PARAMETER(psShrinker);
+
+    if(psShrinkControl->nr_to_scan == 0)
+    {
+        return (int)g_ui32PagePoolCount;
+    }
+
+    return (int)PagePoolDrain((IMG_UINT32)psShrinkControl->nr_to_scan);
+}
+
+static struct shrinker g_sPagePoolShrinker =
+{
+    .shrink = PagePoolShrink,
+    .seeks = DEFAULT_SEEKS,
+};
+
+static void ProcSeqShowPagePool(struct seq_file *sfile, void *el)
+{
+    LINUX_PAGE_POOL_STATS sStats;
+    IMG_UINT32 ui32PageCount;
+
+    PVR_UNREFERENCED_PARAMETER(el);
+
+    spin_lock(&g_sPagePoolLock);
+    sStats = g_sPagePoolStats;
+    ui32PageCount = g_ui32PagePoolCount;
+    spin_unlock(&g_sPagePoolLock);
+
+    seq_printf(sfile, "pooled %u/%u pages\n", ui32PageCount, PVR_LINUX_PAGE_POOL_MAX_PAGES);
+    seq_printf(sfile, "alloc hits %u misses %u\n", sStats.ui32Hits, sStats.ui32Misses);
+    seq_printf(sfile, "free pooled %u overflowed %u shrunk %u\n",
+               sStats.ui32PagesPooled, sStats.ui32PagesOverflowed, sStats.ui32PagesShrunk);
+    seq_printf(sfile, "page cleans %u full cleans %u\n",
+               sStats.ui32PageCleans, sStats.ui32FullCleans);
+}
+
 
 #if (LINUX_VERSION_CODE < KERNEL_VERSION(2,6,15))
 static IMG_VOID ReservePages(IMG_VOID *pvAddress, IMG_UINT32 ui32Length);
@@ -235,6 +422,16 @@ LinuxMMInit(IMG_VOID)
         return PVRSRV_ERROR_OUT_OF_MEMORY;
     }
 
+    g_SeqFilePagePool = CreateProcReadEntrySeq("page_pool", NULL, NULL,
+                                               ProcSeqShowPagePool,
+                                               ProcSeq1ElementOff2Element, NULL);
+    if(!g_SeqFilePagePool)
+    {
+        PVR_DPF((PVR_DBG_WARNING, "%s: couldn't make page_pool proc entry", __FUNCTION__));
+    }
+
+    register_shrinker(&g_sPagePoolShrinker);
+
     return PVRSRV_OK;
 }
 
@@ -330,6 +527,15 @@ LinuxMMCleanup(IMG_VOID)
     }
 #endif
 
+    unregister_shrinker(&g_sPagePoolShrinker);
+    PagePoolDrain(g_ui32PagePoolCount);
+
+    if(g_SeqFilePagePool)
+    {
+        RemoveProcEntrySeq(g_SeqFilePagePool);
+        g_SeqFilePagePool = IMG_NULL;
+    }
+
     if(psLinuxMemAreaCache)
     {
         KMemCacheDestroyWrapper(psLinuxMemAreaCache); 
@@ -955,6 +1161,7 @@ NewAllocPagesLinuxMemArea(IMG_UINT32 ui32Bytes, IMG_UINT32 ui32AreaFlags)
     struct page **pvPageList;
     IMG_HANDLE hBlockPageList;
     IMG_INT32 i;		
+    IMG_UINT32 ui32PooledPages;
     PVRSRV_ERROR eError;
     
     psLinuxMemArea = LinuxMemAreaStructAlloc();
@@ -971,7 +1178,9 @@ NewAllocPagesLinuxMemArea(IMG_UINT32 ui32Bytes, IMG_UINT32 ui32AreaFlags)
         goto failed_page_list_alloc;
     }
     
-    for(i=0; i<(IMG_INT32)ui32PageCount; i++)
+    ui32PooledPages = PagePoolAlloc(pvPageList, ui32PageCount);
+
+    for(i=(IMG_INT32)ui32PooledPages; i<(IMG_INT32)ui32PageCount; i++)
     {
         pvPageList[i] = alloc_pages(GFP_KERNEL | __GFP_HIGHMEM, 0);
         if(!pvPageList[i])
@@ -1009,7 +1218,8 @@ NewAllocPagesLinuxMemArea(IMG_UINT32 ui32Bytes, IMG_UINT32 ui32AreaFlags)
     INIT_LIST_HEAD(&psLinuxMemArea->sMMapOffsetStructList);
 
     
-    if(ui32AreaFlags & (PVRSRV_HAP_WRITECOMBINE | PVRSRV_HAP_UNCACHED))
+    if((ui32AreaFlags & (PVRSRV_HAP_WRITECOMBINE | PVRSRV_HAP_UNCACHED)) &&
+       ui32PooledPages != ui32PageCount)
     {
         psLinuxMemArea->bNeedsCacheInvalidate = IMG_TRUE;
     }
@@ -1068,9 +1278,10 @@ FreeAllocPagesLinuxMemArea(LinuxMemArea *psLinuxMemArea)
         mem_map_reserve(pvPageList[i]);
 #endif		
 #endif	
-        __free_pages(pvPageList[i], 0);
     }
 
+    PagePoolFree(pvPageList, ui32PageCount);
+
     (IMG_VOID) OSFreeMem(0, sizeof(*pvPageList) * ui32PageCount, pvPageList, hBlockPageList);
 	psLinuxMemArea->uData.sPageList.pvPageList = IMG_NULL; 
 
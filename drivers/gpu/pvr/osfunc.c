@@ -51,6 +51,7 @@
 #include <linux/interrupt.h>
 #include <asm/hardirq.h>
 #include <linux/timer.h>
+#include <linux/hrtimer.h>
 #include <linux/capability.h>
 #include <asm/uaccess.h>
 #include <linux/spinlock.h>
@@ -558,6 +559,93 @@ IMG_VOID OSSleepms(IMG_UINT32 ui32Timems)
 }
 
 
+IMG_UINT64 OSClockns64(IMG_VOID)
+{
+    return (IMG_UINT64)ktime_to_ns(ktime_get());
+}
+
+
+typedef struct _OS_WAIT_QUEUE_
+{
+    wait_queue_head_t	sWait;
+    atomic_t		sStamp;
+} OS_WAIT_QUEUE;
+
+PVRSRV_ERROR OSWaitQueueCreate(IMG_HANDLE *phWaitQueue)
+{
+    OS_WAIT_QUEUE *psWaitQueue;
+    PVRSRV_ERROR eError;
+
+    eError = OSAllocMem(PVRSRV_OS_NON_PAGEABLE_HEAP, sizeof(OS_WAIT_QUEUE),
+                        (IMG_VOID **)&psWaitQueue, IMG_NULL, "Wait Queue");
+    if (eError != PVRSRV_OK)
+    {
+        return eError;
+    }
+
+    init_waitqueue_head(&psWaitQueue->sWait);
+    atomic_set(&psWaitQueue->sStamp, 0);
+
+    *phWaitQueue = (IMG_HANDLE)psWaitQueue;
+
+    return PVRSRV_OK;
+}
+
+IMG_VOID OSWaitQueueDestroy(IMG_HANDLE hWaitQueue)
+{
+    OSFreeMem(PVRSRV_OS_NON_PAGEABLE_HEAP, sizeof(OS_WAIT_QUEUE), hWaitQueue, IMG_NULL);
+}
+
+ 
+IMG_UINT32 OSWaitQueueStamp(IMG_HANDLE hWaitQueue)
+{
+    OS_WAIT_QUEUE *psWaitQueue = (OS_WAIT_QUEUE *)hWaitQueue;
+
+    return (IMG_UINT32)atomic_read(&psWaitQueue->sStamp);
+}
+
+ 
+IMG_VOID OSWaitQueueSignal(IMG_HANDLE hWaitQueue)
+{
+    OS_WAIT_QUEUE *psWaitQueue = (OS_WAIT_QUEUE *)hWaitQueue;
+
+    atomic_inc(&psWaitQueue->sStamp);
+    wake_up(&psWaitQueue->sWait);
+}
+
+ 
+PVRSRV_ERROR OSWaitQueueWaitus(IMG_HANDLE hWaitQueue, IMG_UINT32 ui32Stamp, IMG_UINT32 ui32Timeoutus)
+{
+    OS_WAIT_QUEUE *psWaitQueue = (OS_WAIT_QUEUE *)hWaitQueue;
+    PVRSRV_ERROR eError = PVRSRV_OK;
+    ktime_t sTimeout;
+    DEFINE_WAIT(sWait);
+
+    
+    if (in_interrupt() || irqs_disabled())
+    {
+        udelay(1);
+        return PVRSRV_ERROR_TIMEOUT;
+    }
+
+    /* an hrtimer, not jiffies: the slices are far shorter than a tick */
+    sTimeout = ktime_set(0, ui32Timeoutus * NSEC_PER_USEC);
+
+    prepare_to_wait(&psWaitQueue->sWait, &sWait, TASK_UNINTERRUPTIBLE);
+    if ((IMG_UINT32)atomic_read(&psWaitQueue->sStamp) == ui32Stamp)
+    {
+        if (schedule_hrtimeout_range(&sTimeout, ui32Timeoutus * NSEC_PER_USEC / 4,
+                                     HRTIMER_MODE_REL) == 0)
+        {
+            eError = PVRSRV_ERROR_TIMEOUT;
+        }
+    }
+    finish_wait(&psWaitQueue->sWait, &sWait);
+
+    return eError;
+}
+
+
  
 IMG_HANDLE OSFuncHighResTimerCreate(IMG_VOID)
 {
@@ -487,6 +487,14 @@ IMG_VOID OSWaitus(IMG_UINT32 ui32Timeus);
  
 IMG_VOID OSSleepms(IMG_UINT32 ui32Timems);
 
+IMG_UINT64 OSClockns64(IMG_VOID);
+
+PVRSRV_ERROR OSWaitQueueCreate(IMG_HANDLE *phWaitQueue);
+IMG_VOID OSWaitQueueDestroy(IMG_HANDLE hWaitQueue);
+IMG_UINT32 OSWaitQueueStamp(IMG_HANDLE hWaitQueue);
+IMG_VOID OSWaitQueueSignal(IMG_HANDLE hWaitQueue);
+PVRSRV_ERROR OSWaitQueueWaitus(IMG_HANDLE hWaitQueue, IMG_UINT32 ui32Stamp, IMG_UINT32 ui32Timeoutus);
+
 IMG_HANDLE OSFuncHighResTimerCreate(IMG_VOID);
 IMG_UINT32 OSFuncHighResTimerGetus(IMG_HANDLE hTimer);
 IMG_VOID OSFuncHighResTimerDestroy(IMG_HANDLE hTimer);
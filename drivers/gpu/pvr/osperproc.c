@@ -28,6 +28,7 @@
 #include "osperproc.h"
 
 #include "env_perproc.h"
+#include "env_data.h"
 #include "proc.h"
 
 extern IMG_UINT32 gui32ReleasePID;
@@ -57,6 +58,8 @@ PVRSRV_ERROR OSPerProcessPrivateDataInit(IMG_HANDLE *phOsPrivateData)
 
 	psEnvPerProc->hBlockAlloc = hBlockAlloc;
 
+	LinuxInitMutex(&psEnvPerProc->sBridgeLock);
+
 	
 	LinuxMMapPerProcessConnect(psEnvPerProc);
 
@@ -86,6 +89,14 @@ PVRSRV_ERROR OSPerProcessPrivateDataDeInit(IMG_HANDLE hOsPrivateData)
 	
 	RemovePerProcessProcDir(psEnvPerProc);
 
+	if (psEnvPerProc->pvBridgeData != IMG_NULL)
+	{
+		OSFreeMem(PVRSRV_OS_PAGEABLE_HEAP,
+				  PVRSRV_MAX_BRIDGE_IN_SIZE + PVRSRV_MAX_BRIDGE_OUT_SIZE,
+				  psEnvPerProc->pvBridgeData, IMG_NULL);
+		psEnvPerProc->pvBridgeData = IMG_NULL;
+	}
+
 	eError = OSFreeMem(PVRSRV_OS_NON_PAGEABLE_HEAP,
 				sizeof(PVRSRV_ENV_PER_PROCESS_DATA),
 				hOsPrivateData,
@@ -38,6 +38,9 @@ typedef struct
 	IMG_UINT32 ui32OpenPID;
 
 	
+	IMG_PVOID pvPerProc;
+
+	
 #if defined (SUPPORT_SID_INTERFACE)
 	IMG_SID hKernelMemInfo;
 #else
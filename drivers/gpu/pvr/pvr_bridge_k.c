@@ -38,12 +38,17 @@
 #include "pvr_uaccess.h"
 #include "refcount.h"
 
+#include "env_perproc.h"
+#include "env_data.h"
+#include "lock.h"
+
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/spinlock.h>
+
 #if defined(SUPPORT_DRI_DRM)
 #include <drm/drmP.h>
 #include "pvr_drm.h"
-#if defined(PVR_SECURE_DRM_AUTH_EXPORT)
-#include "env_perproc.h"
-#endif
 #endif
 
 #if defined(SUPPORT_VGX)
@@ -74,6 +79,200 @@ static void ProcSeqStartstopBridgeStats(struct seq_file *sfile,IMG_BOOL start);
 
 extern PVRSRV_LINUX_MUTEX gPVRSRVLock;
 
+/*
+ * Bridge calls take some combination of three locks, always in this order:
+ *
+ *  - gPVRSRVLock, the services lock.  Anything that allocates or frees
+ *    handles, memory, contexts or resman items still needs it.
+ *  - the per-process bridge lock.  It keeps one process's calls from
+ *    running against its own handle base and objects concurrently, and
+ *    guards the per-process bridge buffer.
+ *  - gsBridgeSyncLock.  It serialises everything that reads or bumps the
+ *    pending op counts of sync objects, which are shared between processes,
+ *    so that each kick takes its op values atomically with respect to the
+ *    other kicks and flips.
+ *
+ * The hot per-frame calls take only the last two, so a process kicking the
+ * SGX no longer waits behind another process's allocations or mappings.
+ */
+#define BRIDGE_LOCK_GLOBAL		(1U << 0)
+#define BRIDGE_LOCK_PROCESS		(1U << 1)
+#define BRIDGE_LOCK_SYNC		(1U << 2)
+
+/* Per-process lock held by the current owner of gPVRSRVLock, if any. */
+PVRSRV_LINUX_MUTEX *gpsPVRSRVProcessLock;
+/* Time gPVRSRVLock was released by its owner while waiting on an event. */
+IMG_UINT32 gui32PVRSRVLockDroppedus;
+
+static PVRSRV_LINUX_MUTEX gsBridgeSyncLock;
+
+typedef struct _PVRSRV_BRIDGE_LOCK_STATS_
+{
+	IMG_UINT32	ui32Calls;
+	IMG_UINT32	ui32MaxWaitus;
+	IMG_UINT32	ui32MaxHoldus;
+	IMG_UINT64	ui64TotalWaitus;
+	IMG_UINT64	ui64TotalHoldus;
+} PVRSRV_BRIDGE_LOCK_STATS;
+
+static PVRSRV_BRIDGE_LOCK_STATS g_BridgeLockStats[BRIDGE_DISPATCH_TABLE_ENTRY_COUNT];
+static IMG_UINT32 g_ui32BridgeLockOverlapped;
+static DEFINE_SPINLOCK(g_sBridgeLockStatsLock);
+
+static struct proc_dir_entry *g_ProcBridgeLocks;
+static void *ProcSeqOff2ElementBridgeLocks(struct seq_file *sfile, loff_t off);
+static void *ProcSeqNextBridgeLocks(struct seq_file *sfile, void *el, loff_t off);
+static void ProcSeqShowBridgeLocks(struct seq_file *sfile, void *el);
+
+static IMG_UINT32 BridgeLockFlags(IMG_UINT32 ui32BridgeID)
+{
+	switch(ui32BridgeID)
+	{
+#if defined(SUPPORT_SGX)
+		case PVRSRV_GET_BRIDGE_ID(PVRSRV_BRIDGE_SGX_DOKICK):
+#if defined(TRANSFER_QUEUE)
+		case PVRSRV_GET_BRIDGE_ID(PVRSRV_BRIDGE_SGX_SUBMITTRANSFER):
+#endif
+#if !defined(SUPPORT_SGX_EDM_MEMORY_DEBUG)
+		case PVRSRV_GET_BRIDGE_ID(PVRSRV_BRIDGE_SGX_GETMISCINFO):
+#endif
+#endif
+		case PVRSRV_GET_BRIDGE_ID(PVRSRV_BRIDGE_SYNC_OPS_TAKE_TOKEN):
+		case PVRSRV_GET_BRIDGE_ID(PVRSRV_BRIDGE_SYNC_OPS_FLUSH_TO_TOKEN):
+		case PVRSRV_GET_BRIDGE_ID(PVRSRV_BRIDGE_SYNC_OPS_FLUSH_TO_MOD_OBJ):
+		case PVRSRV_GET_BRIDGE_ID(PVRSRV_BRIDGE_SYNC_OPS_FLUSH_TO_DELTA):
+			return BRIDGE_LOCK_PROCESS | BRIDGE_LOCK_SYNC;
+
+		/* These take pending op values but also need the services lock. */
+		case PVRSRV_GET_BRIDGE_ID(PVRSRV_BRIDGE_SWAP_DISPCLASS_TO_BUFFER):
+		case PVRSRV_GET_BRIDGE_ID(PVRSRV_BRIDGE_SWAP_DISPCLASS_TO_BUFFER2):
+		case PVRSRV_GET_BRIDGE_ID(PVRSRV_BRIDGE_SWAP_DISPCLASS_TO_SYSTEM):
+		case PVRSRV_GET_BRIDGE_ID(PVRSRV_BRIDGE_MODIFY_PENDING_SYNC_OPS):
+		case PVRSRV_GET_BRIDGE_ID(PVRSRV_BRIDGE_MODIFY_COMPLETE_SYNC_OPS):
+			return BRIDGE_LOCK_GLOBAL | BRIDGE_LOCK_PROCESS | BRIDGE_LOCK_SYNC;
+
+		default:
+			return BRIDGE_LOCK_GLOBAL | BRIDGE_LOCK_PROCESS;
+	}
+}
+
+static IMG_VOID BridgeLockStatsUpdate(IMG_UINT32 ui32BridgeID,
+									  ktime_t sStart,
+									  ktime_t sLocked,
+									  IMG_UINT32 ui32Droppedus,
+									  IMG_BOOL bOverlapped)
+{
+	PVRSRV_BRIDGE_LOCK_STATS *psStats;
+	IMG_UINT32 ui32Waitus, ui32Holdus;
+	unsigned long ulFlags;
+
+	if(ui32BridgeID >= BRIDGE_DISPATCH_TABLE_ENTRY_COUNT)
+	{
+		return;
+	}
+
+	ui32Waitus = (IMG_UINT32)ktime_us_delta(sLocked, sStart);
+	ui32Holdus = (IMG_UINT32)ktime_us_delta(ktime_get(), sLocked);
+	ui32Holdus = (ui32Holdus > ui32Droppedus) ? ui32Holdus - ui32Droppedus : 0;
+
+	psStats = &g_BridgeLockStats[ui32BridgeID];
+
+	spin_lock_irqsave(&g_sBridgeLockStatsLock, ulFlags);
+	psStats->ui32Calls++;
+	psStats->ui64TotalWaitus += ui32Waitus;
+	psStats->ui64TotalHoldus += ui32Holdus;
+	if(ui32Waitus > psStats->ui32MaxWaitus)
+	{
+		psStats->ui32MaxWaitus = ui32Waitus;
+	}
+	if(ui32Holdus > psStats->ui32MaxHoldus)
+	{
+		psStats->ui32MaxHoldus = ui32Holdus;
+	}
+	if(bOverlapped)
+	{
+		g_ui32BridgeLockOverlapped++;
+	}
+	spin_unlock_irqrestore(&g_sBridgeLockStatsLock, ulFlags);
+}
+
+/*
+ * Dispatch one of the per-frame calls without the services lock.  The
+ * caller's per-process data is taken from the file rather than looked up in
+ * the kernel handle base, which only the services lock protects.
+ */
+static IMG_INT BridgeDispatchConcurrent(PVRSRV_FILE_PRIVATE_DATA *psPrivateData,
+										PVRSRV_BRIDGE_PACKAGE *psBridgePackageKM,
+										IMG_UINT32 ui32LockFlags)
+{
+	PVRSRV_PER_PROCESS_DATA *psPerProc = (PVRSRV_PER_PROCESS_DATA *)psPrivateData->pvPerProc;
+	PVRSRV_ENV_PER_PROCESS_DATA *psEnvPerProc;
+	IMG_UINT32 ui32BridgeID = PVRSRV_GET_BRIDGE_ID(psBridgePackageKM->ui32BridgeID);
+	IMG_BOOL bOverlapped;
+	ktime_t sStart, sLocked;
+	IMG_INT err;
+
+	if(psPerProc == IMG_NULL ||
+	   psPerProc->hPerProcData != psBridgePackageKM->hKernelServices ||
+	   psPerProc->ui32PID != OSGetCurrentProcessIDKM())
+	{
+		PVR_DPF((PVR_DBG_ERROR, "%s: Invalid kernel services handle", __FUNCTION__));
+		return -EFAULT;
+	}
+
+	if(psPrivateData->hKernelMemInfo)
+	{
+		PVR_DPF((PVR_DBG_ERROR, "%s: Import/Export handle tried "
+				 "to use privileged service", __FUNCTION__));
+		return -EFAULT;
+	}
+
+	psEnvPerProc = (PVRSRV_ENV_PER_PROCESS_DATA *)PVRSRVProcessPrivateData(psPerProc);
+	if(psEnvPerProc == IMG_NULL)
+	{
+		return -EFAULT;
+	}
+
+	sStart = ktime_get();
+	bOverlapped = LinuxIsLockedMutex(&gPVRSRVLock);
+
+	LinuxLockMutex(&psEnvPerProc->sBridgeLock);
+
+	if(psEnvPerProc->pvBridgeData == IMG_NULL)
+	{
+		if(OSAllocMem(PVRSRV_OS_PAGEABLE_HEAP,
+					  PVRSRV_MAX_BRIDGE_IN_SIZE + PVRSRV_MAX_BRIDGE_OUT_SIZE,
+					  &psEnvPerProc->pvBridgeData, IMG_NULL,
+					  "Per Process Bridge Data") != PVRSRV_OK)
+		{
+			psEnvPerProc->pvBridgeData = IMG_NULL;
+			LinuxUnLockMutex(&psEnvPerProc->sBridgeLock);
+			return -ENOMEM;
+		}
+	}
+
+	if(ui32LockFlags & BRIDGE_LOCK_SYNC)
+	{
+		LinuxLockMutex(&gsBridgeSyncLock);
+	}
+	sLocked = ktime_get();
+
+	psBridgePackageKM->ui32BridgeID = ui32BridgeID;
+
+	err = BridgedDispatchKM(psPerProc, psBridgePackageKM, psEnvPerProc->pvBridgeData);
+
+	if(ui32LockFlags & BRIDGE_LOCK_SYNC)
+	{
+		LinuxUnLockMutex(&gsBridgeSyncLock);
+	}
+
+	BridgeLockStatsUpdate(ui32BridgeID, sStart, sLocked, 0, bOverlapped);
+
+	LinuxUnLockMutex(&psEnvPerProc->sBridgeLock);
+
+	return err;
+}
+
 #if defined(SUPPORT_MEMINFO_IDS)
 static IMG_UINT64 ui64Stamp;
 #endif 
@@ -81,6 +280,19 @@ static IMG_UINT64 ui64Stamp;
 PVRSRV_ERROR
 LinuxBridgeInit(IMG_VOID)
 {
+	LinuxInitMutex(&gsBridgeSyncLock);
+
+	g_ProcBridgeLocks = CreateProcReadEntrySeq("bridge_locks",
+											   NULL,
+											   ProcSeqNextBridgeLocks,
+											   ProcSeqShowBridgeLocks,
+											   ProcSeqOff2ElementBridgeLocks,
+											   NULL);
+	if(!g_ProcBridgeLocks)
+	{
+		return PVRSRV_ERROR_OUT_OF_MEMORY;
+	}
+
 #if defined(DEBUG_BRIDGE_KM)
 	{
 		g_ProcBridgeStats = CreateProcReadEntrySeq(
@@ -106,6 +318,79 @@ LinuxBridgeDeInit(IMG_VOID)
 #if defined(DEBUG_BRIDGE_KM)
     RemoveProcEntrySeq(g_ProcBridgeStats);
 #endif
+	RemoveProcEntrySeq(g_ProcBridgeLocks);
+}
+
+
+static void *ProcSeqOff2ElementBridgeLocks(struct seq_file *sfile, loff_t off)
+{
+	if(!off)
+	{
+		return PVR_PROC_SEQ_START_TOKEN;
+	}
+
+	if(off > BRIDGE_DISPATCH_TABLE_ENTRY_COUNT)
+	{
+		return (void*)0;
+	}
+
+	return (void*)&g_BridgeLockStats[off-1];
+}
+
+static void *ProcSeqNextBridgeLocks(struct seq_file *sfile, void *el, loff_t off)
+{
+	return ProcSeqOff2ElementBridgeLocks(sfile, off);
+}
+
+static void ProcSeqShowBridgeLocks(struct seq_file *sfile, void *el)
+{
+	PVRSRV_BRIDGE_LOCK_STATS sStats;
+	IMG_UINT32 ui32BridgeID;
+	unsigned long ulFlags;
+
+	if(el == PVR_PROC_SEQ_START_TOKEN)
+	{
+		seq_printf(sfile,
+				   "Concurrent calls made while the services lock was held = %u\n\n"
+				   "%-45s | %-10s | %10s | %10s | %10s | %10s | %10s\n",
+				   g_ui32BridgeLockOverlapped,
+				   "Bridge",
+				   "Locks",
+				   "Calls",
+				   "Avg wait us",
+				   "Max wait us",
+				   "Avg hold us",
+				   "Max hold us");
+		return;
+	}
+
+	spin_lock_irqsave(&g_sBridgeLockStatsLock, ulFlags);
+	sStats = *(PVRSRV_BRIDGE_LOCK_STATS *)el;
+	spin_unlock_irqrestore(&g_sBridgeLockStatsLock, ulFlags);
+
+	if(sStats.ui32Calls == 0)
+	{
+		return;
+	}
+
+	ui32BridgeID = (IMG_UINT32)((PVRSRV_BRIDGE_LOCK_STATS *)el - g_BridgeLockStats);
+
+	seq_printf(sfile,
+#if defined(DEBUG_BRIDGE_KM)
+			   "%-45s   %-10s   %-10u   %-10llu   %-10u   %-10llu   %-10u\n",
+			   g_BridgeDispatchTable[ui32BridgeID].pszIOCName,
+#else
+			   "%-45u   %-10s   %-10u   %-10llu   %-10u   %-10llu   %-10u\n",
+			   ui32BridgeID,
+#endif
+			   (BridgeLockFlags(ui32BridgeID) & BRIDGE_LOCK_GLOBAL) ?
+			   ((BridgeLockFlags(ui32BridgeID) & BRIDGE_LOCK_SYNC) ? "global+sync" : "global") :
+			   "process",
+			   sStats.ui32Calls,
+			   div_u64(sStats.ui64TotalWaitus, sStats.ui32Calls),
+			   sStats.ui32MaxWaitus,
+			   div_u64(sStats.ui64TotalHoldus, sStats.ui32Calls),
+			   sStats.ui32MaxHoldus);
 }
 
 #if defined(DEBUG_BRIDGE_KM)
@@ -198,10 +483,13 @@ PVRSRV_BridgeDispatchKM(struct file *pFile, unsigned int unref__ ioctlCmd, unsig
 	PVRSRV_BRIDGE_PACKAGE *psBridgePackageKM;
 	IMG_UINT32 ui32PID = OSGetCurrentProcessIDKM();
 	PVRSRV_PER_PROCESS_DATA *psPerProc;
+	PVRSRV_ENV_PER_PROCESS_DATA *psEnvPerProc;
+	PVRSRV_LINUX_MUTEX *psProcessLock = IMG_NULL;
+	IMG_UINT32 ui32LockFlags;
+	IMG_UINT32 ui32Droppedus = 0;
+	ktime_t sStart, sLocked;
 	IMG_INT err = -EFAULT;
 
-	LinuxLockMutex(&gPVRSRVLock);
-
 #if defined(SUPPORT_DRI_DRM)
 	psBridgePackageKM = (PVRSRV_BRIDGE_PACKAGE *)arg;
 	PVR_ASSERT(psBridgePackageKM != IMG_NULL);
@@ -215,7 +503,7 @@ PVRSRV_BridgeDispatchKM(struct file *pFile, unsigned int unref__ ioctlCmd, unsig
 		PVR_DPF((PVR_DBG_ERROR, "%s: Received invalid pointer to function arguments",
 				 __FUNCTION__));
 
-		goto unlock_and_return;
+		return err;
 	}
 	
 	
@@ -225,11 +513,21 @@ PVRSRV_BridgeDispatchKM(struct file *pFile, unsigned int unref__ ioctlCmd, unsig
 					  sizeof(PVRSRV_BRIDGE_PACKAGE))
 	  != PVRSRV_OK)
 	{
-		goto unlock_and_return;
+		return err;
 	}
 #endif
 
 	cmd = psBridgePackageKM->ui32BridgeID;
+
+	ui32LockFlags = BridgeLockFlags(PVRSRV_GET_BRIDGE_ID(cmd));
+	if(!(ui32LockFlags & BRIDGE_LOCK_GLOBAL))
+	{
+		return BridgeDispatchConcurrent(PRIVATE_DATA(pFile), psBridgePackageKM, ui32LockFlags);
+	}
+
+	sStart = ktime_get();
+	sLocked = sStart;
+	LinuxLockMutex(&gPVRSRVLock);
 	
 	if(cmd != PVRSRV_BRIDGE_CONNECT_SERVICES)
 	{
@@ -266,6 +564,25 @@ PVRSRV_BridgeDispatchKM(struct file *pFile, unsigned int unref__ ioctlCmd, unsig
 		}
 	}
 
+	psEnvPerProc = (PVRSRV_ENV_PER_PROCESS_DATA *)PVRSRVProcessPrivateData(psPerProc);
+	if(psEnvPerProc == IMG_NULL)
+	{
+		PVR_DPF((PVR_DBG_ERROR, "%s: Process private data not allocated", __FUNCTION__));
+		goto unlock_and_return;
+	}
+
+	psProcessLock = &psEnvPerProc->sBridgeLock;
+	LinuxLockMutex(psProcessLock);
+	gpsPVRSRVProcessLock = psProcessLock;
+
+	if(ui32LockFlags & BRIDGE_LOCK_SYNC)
+	{
+		LinuxLockMutex(&gsBridgeSyncLock);
+	}
+
+	sLocked = ktime_get();
+	ui32Droppedus = gui32PVRSRVLockDroppedus;
+
 	psBridgePackageKM->ui32BridgeID = PVRSRV_GET_BRIDGE_ID(psBridgePackageKM->ui32BridgeID);
 
 	switch(cmd)
@@ -371,7 +688,14 @@ PVRSRV_BridgeDispatchKM(struct file *pFile, unsigned int unref__ ioctlCmd, unsig
 	}
 #endif 
 
-	err = BridgedDispatchKM(psPerProc, psBridgePackageKM);
+	{
+		SYS_DATA *psSysData;
+
+		SysAcquireData(&psSysData);
+
+		err = BridgedDispatchKM(psPerProc, psBridgePackageKM,
+								((ENV_DATA *)psSysData->pvEnvSpecificData)->pvBridgeData);
+	}
 	if(err != PVRSRV_OK)
 		goto unlock_and_return;
 
@@ -445,6 +769,19 @@ PVRSRV_BridgeDispatchKM(struct file *pFile, unsigned int unref__ ioctlCmd, unsig
 	}
 
 unlock_and_return:
+	if(psProcessLock != IMG_NULL)
+	{
+		if(ui32LockFlags & BRIDGE_LOCK_SYNC)
+		{
+			LinuxUnLockMutex(&gsBridgeSyncLock);
+		}
+
+		BridgeLockStatsUpdate(psBridgePackageKM->ui32BridgeID, sStart, sLocked,
+							  gui32PVRSRVLockDroppedus - ui32Droppedus, IMG_FALSE);
+
+		gpsPVRSRVProcessLock = IMG_NULL;
+		LinuxUnLockMutex(psProcessLock);
+	}
 	LinuxUnLockMutex(&gPVRSRVLock);
 	return err;
 }
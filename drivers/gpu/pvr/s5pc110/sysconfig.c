@@ -30,12 +30,18 @@
 #include "oemfuncs.h"
 #include "sgxinfo.h"
 #include "sgxinfokm.h"
+#include "proc.h"
 
+#include <linux/module.h>
 #include <linux/platform_device.h>
 #include <linux/regulator/consumer.h>
 #include <linux/clk.h>
 #include <linux/err.h>
 #include <linux/cpufreq.h>
+#include <linux/jiffies.h>
+#include <linux/math64.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
 
 #define REAL_HARDWARE 1
 #define SGX540_BASEADDR 0xf3000000
@@ -83,16 +89,90 @@ IMG_UINT32   PVRSRV_BridgeDispatchKM( IMG_UINT32  Ioctl,
 									IMG_UINT32 *pdwBytesTransferred);
 
 #if defined(SUPPORT_ACTIVE_POWER_MANAGEMENT)
+static struct clk *g3d_clock;
+static struct regulator *g3d_pd_regulator;
+
+static PVRSRV_ERROR EnableSGXClocks(void)
+{
+	regulator_enable(g3d_pd_regulator);
+	clk_enable(g3d_clock);
+
+	return PVRSRV_OK;
+}
+
+static PVRSRV_ERROR DisableSGXClocks(void)
+{
+	clk_disable(g3d_clock);
+	regulator_disable(g3d_pd_regulator);
+
+	return PVRSRV_OK;
+}
+
+#if defined(SUPPORT_SGX_DVFS)
 /*
- * We need to keep the memory bus speed up when the GPU is active.
- * On the  S5PV210, it is bound to the CPU freq.
- * In arch/arm/mach-s5pv210/cpufreq.c, the bus speed is only lowered when the
- * CPU freq is below 200MHz.
+ * GPU frequency scaling.
+ *
+ * While the SGX is powered, a services timer samples the core clock gating
+ * status: a non-zero status means some module of the core is clocked, i.e.
+ * busy.  At the end of each window the busy fraction picks the next g3d
+ * rate; the rate itself is changed from a work item, inside the services
+ * clock speed change bracket, so the microkernel timer is reprogrammed by
+ * SGXUpdateTimingInfo for the new core clock.
  */
-#define MIN_CPU_KHZ_FREQ 200000
+#define SYS_SGX_DVFS_MAX_LEVELS		4
+#define SYS_SGX_DVFS_SAMPLE_MS		4
+#define SYS_SGX_DVFS_WINDOW_MS		200
 
-static struct clk *g3d_clock;
-static struct regulator *g3d_pd_regulator;
+static unsigned int sgx_dvfs_enable = 1;
+module_param(sgx_dvfs_enable, uint, 0644);
+
+/* load (percent) above which the governor jumps to the top rate */
+static unsigned int sgx_dvfs_up_threshold = 90;
+module_param(sgx_dvfs_up_threshold, uint, 0644);
+
+/* load (percent) the governor aims for when it picks a lower rate */
+static unsigned int sgx_dvfs_target_load = 60;
+module_param(sgx_dvfs_target_load, uint, 0644);
+
+typedef struct _SYS_SGX_DVFS_
+{
+	spinlock_t			sLock;
+
+	IMG_UINT32			ui32NumLevels;
+	IMG_UINT32			aui32RateHz[SYS_SGX_DVFS_MAX_LEVELS];
+	IMG_UINT32			ui32Level;			/* rate the clock runs at */
+	IMG_UINT32			ui32TargetLevel;	/* rate the governor asked for */
+
+	IMG_BOOL			bInitialised;
+	IMG_BOOL			bPowered;
+	IMG_BOOL			bCPUFloor;
+	IMG_BOOL			bReapply;		/* clock moved under us */
+
+	IMG_HANDLE			hSampleTimer;
+	IMG_BOOL			bSampling;
+	unsigned long		ulWindowStart;
+	IMG_UINT32			ui32Samples;
+	IMG_UINT32			ui32BusySamples;
+	IMG_UINT32			ui32LastLoad;
+
+	/* time in state, in ms; the last slot counts time powered off */
+	unsigned long		ulStateStart;
+	IMG_UINT64			aui64TimeInStateMs[SYS_SGX_DVFS_MAX_LEVELS + 1];
+	IMG_UINT32			ui32Transitions;
+
+	struct work_struct	sWork;
+	struct proc_dir_entry	*psProcEntry;
+} SYS_SGX_DVFS;
+
+static SYS_SGX_DVFS gsSGXDVFS;
+
+#if defined(CONFIG_PVR_LIMIT_MINFREQ)
+/*
+ * The memory bus speed is bound to the CPU freq on the S5PV210 and is only
+ * lowered when the CPU freq is below 200MHz.  Keep the CPU at or above that
+ * while the GPU runs at its top rate, which is when it needs the bandwidth.
+ */
+#define MIN_CPU_KHZ_FREQ 200000
 
 #ifdef CONFIG_LIVE_OC
 extern unsigned long get_gpuminfreq(void);
@@ -106,8 +186,7 @@ static int limit_adjust_cpufreq_notifier(struct notifier_block *nb,
 	if (event != CPUFREQ_ADJUST)
 		return 0;
 
-	/* This is our indicator of GPU activity */
-	if (regulator_is_enabled(g3d_pd_regulator))
+	if (gsSGXDVFS.bCPUFloor)
 #ifdef CONFIG_LIVE_OC
 		cpufreq_verify_within_limits(policy, get_gpuminfreq(),
 					     policy->cpuinfo.max_freq);
@@ -122,23 +201,407 @@ static int limit_adjust_cpufreq_notifier(struct notifier_block *nb,
 static struct notifier_block cpufreq_limit_notifier = {
 	.notifier_call = limit_adjust_cpufreq_notifier,
 };
+#endif /* defined(CONFIG_PVR_LIMIT_MINFREQ) */
 
-static PVRSRV_ERROR EnableSGXClocks(void)
+/*
+ * An APLL change in the CPU freq driver rewrites the G3D divider.  It is
+ * meant to put it back, but if the clock no longer runs at the rate of the
+ * current level have the work put the level back.
+ */
+static int SGXDVFSCPUFreqTransition(struct notifier_block *nb,
+									unsigned long event, void *data)
 {
-	regulator_enable(g3d_pd_regulator);
-	clk_enable(g3d_clock);
-	cpufreq_update_policy(current_thread_info()->cpu);
+	IMG_BOOL bKick = IMG_FALSE;
 
-	return PVRSRV_OK;
+	if (event != CPUFREQ_POSTCHANGE)
+	{
+		return 0;
+	}
+
+	spin_lock(&gsSGXDVFS.sLock);
+	if (gsSGXDVFS.ui32NumLevels &&
+		clk_get_rate(g3d_clock) != gsSGXDVFS.aui32RateHz[gsSGXDVFS.ui32Level])
+	{
+		gsSGXDVFS.bReapply = IMG_TRUE;
+		bKick = IMG_TRUE;
+	}
+	spin_unlock(&gsSGXDVFS.sLock);
+
+	if (bKick)
+	{
+		schedule_work(&gsSGXDVFS.sWork);
+	}
+
+	return 0;
 }
 
-static PVRSRV_ERROR DisableSGXClocks(void)
+static struct notifier_block gsSGXDVFSTransitionNotifier = {
+	.notifier_call = SGXDVFSCPUFreqTransition,
+};
+
+/* Fold the time since the last state change into the time-in-state table. */
+static IMG_VOID SGXDVFSAccountLocked(IMG_VOID)
 {
-	clk_disable(g3d_clock);
-	regulator_disable(g3d_pd_regulator);
-	cpufreq_update_policy(current_thread_info()->cpu);
+	unsigned long ulNow = jiffies;
+	IMG_UINT32 ui32Slot;
 
-	return PVRSRV_OK;
+	ui32Slot = gsSGXDVFS.bPowered ? gsSGXDVFS.ui32Level : SYS_SGX_DVFS_MAX_LEVELS;
+	gsSGXDVFS.aui64TimeInStateMs[ui32Slot] += jiffies_to_msecs(ulNow - gsSGXDVFS.ulStateStart);
+	gsSGXDVFS.ulStateStart = ulNow;
+}
+
+static IMG_UINT32 SGXDVFSSelectLevel(IMG_UINT32 ui32Load)
+{
+	IMG_UINT32 ui32CurKHz = gsSGXDVFS.aui32RateHz[gsSGXDVFS.ui32Level] / 1000;
+	IMG_UINT32 ui32Level;
+
+	if (ui32Load >= sgx_dvfs_up_threshold)
+	{
+		return gsSGXDVFS.ui32NumLevels - 1;
+	}
+
+	/* lowest rate that carries the same work at the target load */
+	for (ui32Level = 0; ui32Level < gsSGXDVFS.ui32NumLevels - 1; ui32Level++)
+	{
+		if ((gsSGXDVFS.aui32RateHz[ui32Level] / 1000) * sgx_dvfs_target_load >=
+			ui32CurKHz * ui32Load)
+		{
+			break;
+		}
+	}
+
+	return ui32Level;
+}
+
+/* Services timer callback; only runs while the SGX is powered. */
+static IMG_VOID SGXDVFSSample(IMG_VOID *pvData)
+{
+	PVRSRV_DEVICE_NODE	*psDeviceNode = pvData;
+	PVRSRV_SGXDEV_INFO	*psDevInfo = psDeviceNode->pvDevice;
+	IMG_BOOL			bBusy;
+	IMG_BOOL			bKick = IMG_FALSE;
+
+	bBusy = (OSReadHWReg(psDevInfo->pvRegsBaseKM, psDevInfo->ui32ClkGateStatusReg) &
+			 psDevInfo->ui32ClkGateStatusMask) != 0;
+
+	spin_lock(&gsSGXDVFS.sLock);
+
+	gsSGXDVFS.ui32Samples++;
+	if (bBusy)
+	{
+		gsSGXDVFS.ui32BusySamples++;
+	}
+
+	if (time_after_eq(jiffies, gsSGXDVFS.ulWindowStart +
+					  msecs_to_jiffies(SYS_SGX_DVFS_WINDOW_MS)))
+	{
+		gsSGXDVFS.ui32LastLoad = gsSGXDVFS.ui32BusySamples * 100 / gsSGXDVFS.ui32Samples;
+		gsSGXDVFS.ui32Samples = 0;
+		gsSGXDVFS.ui32BusySamples = 0;
+		gsSGXDVFS.ulWindowStart = jiffies;
+
+		if (sgx_dvfs_enable)
+		{
+			IMG_UINT32 ui32Target = SGXDVFSSelectLevel(gsSGXDVFS.ui32LastLoad);
+
+			if (ui32Target != gsSGXDVFS.ui32TargetLevel)
+			{
+				gsSGXDVFS.ui32TargetLevel = ui32Target;
+				bKick = (ui32Target != gsSGXDVFS.ui32Level);
+			}
+		}
+	}
+
+	spin_unlock(&gsSGXDVFS.sLock);
+
+	if (bKick)
+	{
+		schedule_work(&gsSGXDVFS.sWork);
+	}
+}
+
+/*
+ * Runs outside the power transition paths: the clock speed change takes the
+ * services power lock, which they already hold.
+ */
+static void SGXDVFSWork(struct work_struct *psWork)
+{
+	IMG_UINT32		ui32Target;
+	IMG_BOOL		bReapply;
+	PVRSRV_ERROR	eError;
+#if defined(CONFIG_PVR_LIMIT_MINFREQ)
+	IMG_BOOL		bFloor, bUpdate;
+#endif
+
+	PVR_UNREFERENCED_PARAMETER(psWork);
+
+	spin_lock(&gsSGXDVFS.sLock);
+	ui32Target = gsSGXDVFS.ui32TargetLevel;
+	bReapply = gsSGXDVFS.bReapply;
+	gsSGXDVFS.bReapply = IMG_FALSE;
+	spin_unlock(&gsSGXDVFS.sLock);
+
+	if (ui32Target != gsSGXDVFS.ui32Level || bReapply)
+	{
+		eError = PVRSRVDevicePreClockSpeedChange(gui32SGXDeviceID, IMG_TRUE, IMG_NULL);
+		if (eError == PVRSRV_OK)
+		{
+			if (clk_set_rate(g3d_clock, gsSGXDVFS.aui32RateHz[ui32Target]) != 0)
+			{
+				PVR_DPF((PVR_DBG_ERROR, "SGXDVFSWork: failed to set g3d clock to %uHz",
+						 gsSGXDVFS.aui32RateHz[ui32Target]));
+			}
+			else
+			{
+				gsSGXDeviceMap.sTimingInfo.ui32CoreClockSpeed = clk_get_rate(g3d_clock);
+
+				spin_lock(&gsSGXDVFS.sLock);
+				SGXDVFSAccountLocked();
+				if (ui32Target != gsSGXDVFS.ui32Level)
+				{
+					gsSGXDVFS.ui32Level = ui32Target;
+					gsSGXDVFS.ui32Transitions++;
+				}
+				spin_unlock(&gsSGXDVFS.sLock);
+			}
+
+			PVRSRVDevicePostClockSpeedChange(gui32SGXDeviceID, IMG_TRUE, IMG_NULL);
+		}
+	}
+
+#if defined(CONFIG_PVR_LIMIT_MINFREQ)
+	spin_lock(&gsSGXDVFS.sLock);
+	bFloor = gsSGXDVFS.bPowered &&
+			 gsSGXDVFS.ui32Level == gsSGXDVFS.ui32NumLevels - 1;
+	bUpdate = (bFloor != gsSGXDVFS.bCPUFloor);
+	gsSGXDVFS.bCPUFloor = bFloor;
+	spin_unlock(&gsSGXDVFS.sLock);
+
+	if (bUpdate)
+	{
+		cpufreq_update_policy(0);
+	}
+#endif
+}
+
+static void SGXDVFSProcShow(struct seq_file *sfile, void *el)
+{
+	IMG_UINT32 i;
+
+	PVR_UNREFERENCED_PARAMETER(el);
+
+	spin_lock(&gsSGXDVFS.sLock);
+	SGXDVFSAccountLocked();
+
+	seq_printf(sfile, "load %u%% rate %uHz target %uHz transitions %u\n",
+			   gsSGXDVFS.ui32LastLoad,
+			   gsSGXDVFS.aui32RateHz[gsSGXDVFS.ui32Level],
+			   gsSGXDVFS.aui32RateHz[gsSGXDVFS.ui32TargetLevel],
+			   gsSGXDVFS.ui32Transitions);
+	for (i = 0; i < gsSGXDVFS.ui32NumLevels; i++)
+	{
+		seq_printf(sfile, "%u %llu\n", gsSGXDVFS.aui32RateHz[i],
+				   gsSGXDVFS.aui64TimeInStateMs[i]);
+	}
+	seq_printf(sfile, "off %llu\n", gsSGXDVFS.aui64TimeInStateMs[SYS_SGX_DVFS_MAX_LEVELS]);
+
+	spin_unlock(&gsSGXDVFS.sLock);
+}
+
+/*
+ * Build the rate table from the rate the bootloader left on the g3d clock,
+ * which is the top level.  Called once the SGX device node exists.
+ */
+static IMG_VOID SGXDVFSInit(IMG_VOID)
+{
+	static const IMG_UINT32 aui32Percent[SYS_SGX_DVFS_MAX_LEVELS] = { 100, 75, 50, 33 };
+	IMG_UINT32 aui32Desc[SYS_SGX_DVFS_MAX_LEVELS];
+	IMG_UINT32 ui32Top = clk_get_rate(g3d_clock);
+	IMG_UINT32 i, n = 0;
+
+	spin_lock_init(&gsSGXDVFS.sLock);
+	INIT_WORK(&gsSGXDVFS.sWork, SGXDVFSWork);
+
+	for (i = 0; i < SYS_SGX_DVFS_MAX_LEVELS; i++)
+	{
+		long lRate = clk_round_rate(g3d_clock, ui32Top / 100 * aui32Percent[i]);
+
+		if (lRate <= 0 || (n && (IMG_UINT32)lRate >= aui32Desc[n - 1]))
+		{
+			continue;
+		}
+		aui32Desc[n++] = (IMG_UINT32)lRate;
+	}
+
+	for (i = 0; i < n; i++)
+	{
+		gsSGXDVFS.aui32RateHz[i] = aui32Desc[n - 1 - i];
+	}
+	gsSGXDVFS.ui32NumLevels = n;
+	gsSGXDVFS.ui32Level = n ? n - 1 : 0;
+	gsSGXDVFS.ui32TargetLevel = gsSGXDVFS.ui32Level;
+	gsSGXDVFS.ulStateStart = jiffies;
+
+	if (n > 1)
+	{
+		gsSGXDVFS.hSampleTimer = OSAddTimer(SGXDVFSSample,
+											gpsSysData->psDeviceNodeList,
+											SYS_SGX_DVFS_SAMPLE_MS);
+		if (!gsSGXDVFS.hSampleTimer)
+		{
+			PVR_DPF((PVR_DBG_WARNING, "SGXDVFSInit: no timer, running at a fixed rate"));
+		}
+	}
+
+	gsSGXDVFS.psProcEntry = CreateProcReadEntrySeq("sgx_dvfs", NULL, NULL,
+												   SGXDVFSProcShow,
+												   ProcSeq1ElementOff2Element, NULL);
+	if (!gsSGXDVFS.psProcEntry)
+	{
+		PVR_DPF((PVR_DBG_WARNING, "SGXDVFSInit: couldn't make sgx_dvfs proc entry"));
+	}
+
+	cpufreq_register_notifier(&gsSGXDVFSTransitionNotifier, CPUFREQ_TRANSITION_NOTIFIER);
+#if defined(CONFIG_PVR_LIMIT_MINFREQ)
+	cpufreq_register_notifier(&cpufreq_limit_notifier, CPUFREQ_POLICY_NOTIFIER);
+#endif
+
+	gsSGXDVFS.bInitialised = IMG_TRUE;
+}
+
+static IMG_VOID SGXDVFSDeinit(IMG_VOID)
+{
+	if (!gsSGXDVFS.bInitialised)
+	{
+		return;
+	}
+
+	if (gsSGXDVFS.bSampling)
+	{
+		OSDisableTimer(gsSGXDVFS.hSampleTimer);
+		gsSGXDVFS.bSampling = IMG_FALSE;
+	}
+	if (gsSGXDVFS.hSampleTimer)
+	{
+		OSRemoveTimer(gsSGXDVFS.hSampleTimer);
+		gsSGXDVFS.hSampleTimer = IMG_NULL;
+	}
+
+	cpufreq_unregister_notifier(&gsSGXDVFSTransitionNotifier, CPUFREQ_TRANSITION_NOTIFIER);
+	cancel_work_sync(&gsSGXDVFS.sWork);
+
+	if (gsSGXDVFS.psProcEntry)
+	{
+		RemoveProcEntrySeq(gsSGXDVFS.psProcEntry);
+		gsSGXDVFS.psProcEntry = IMG_NULL;
+	}
+
+#if defined(CONFIG_PVR_LIMIT_MINFREQ)
+	cpufreq_unregister_notifier(&cpufreq_limit_notifier, CPUFREQ_POLICY_NOTIFIER);
+	gsSGXDVFS.bCPUFloor = IMG_FALSE;
+	cpufreq_update_policy(0);
+#endif
+
+	gsSGXDVFS.bInitialised = IMG_FALSE;
+}
+
+/* Called with the clocks running, after the SGX has been powered up. */
+static IMG_VOID SGXDVFSPowerOn(IMG_VOID)
+{
+	if (!gsSGXDVFS.bInitialised)
+	{
+		return;
+	}
+
+	spin_lock(&gsSGXDVFS.sLock);
+	SGXDVFSAccountLocked();
+	gsSGXDVFS.bPowered = IMG_TRUE;
+	gsSGXDVFS.ui32Samples = 0;
+	gsSGXDVFS.ui32BusySamples = 0;
+	gsSGXDVFS.ulWindowStart = jiffies;
+	spin_unlock(&gsSGXDVFS.sLock);
+
+	if (gsSGXDVFS.hSampleTimer && !gsSGXDVFS.bSampling)
+	{
+		OSEnableTimer(gsSGXDVFS.hSampleTimer);
+		gsSGXDVFS.bSampling = IMG_TRUE;
+	}
+
+#if defined(CONFIG_PVR_LIMIT_MINFREQ)
+	schedule_work(&gsSGXDVFS.sWork);
+#endif
+}
+
+/* Called before the clocks are stopped. */
+static IMG_VOID SGXDVFSPowerOff(IMG_VOID)
+{
+	if (!gsSGXDVFS.bInitialised)
+	{
+		return;
+	}
+
+	if (gsSGXDVFS.bSampling)
+	{
+		OSDisableTimer(gsSGXDVFS.hSampleTimer);
+		gsSGXDVFS.bSampling = IMG_FALSE;
+	}
+
+	spin_lock(&gsSGXDVFS.sLock);
+	SGXDVFSAccountLocked();
+	gsSGXDVFS.bPowered = IMG_FALSE;
+	spin_unlock(&gsSGXDVFS.sLock);
+
+#if defined(CONFIG_PVR_LIMIT_MINFREQ)
+	if (gsSGXDVFS.bCPUFloor)
+	{
+		schedule_work(&gsSGXDVFS.sWork);
+	}
+#endif
+}
+#endif /* defined(SUPPORT_SGX_DVFS) */
+
+static struct proc_dir_entry *gpsSGXPowerProcEntry;
+
+/*
+ * Active power management statistics.  The counters are updated by the SGX
+ * power callbacks under the services power lock, so take it for a snapshot.
+ */
+static void SGXPowerProcShow(struct seq_file *sfile, void *el)
+{
+	PVRSRV_SGXDEV_INFO *psDevInfo;
+	SGX_POWER_STATS sStats;
+	IMG_UINT32 ui32Latencyms, ui32MaxLatencyms, ui32KickIntervalus;
+
+	PVR_UNREFERENCED_PARAMETER(el);
+
+	if (gpsSysData == IMG_NULL || gpsSysData->psDeviceNodeList == IMG_NULL)
+	{
+		return;
+	}
+	psDevInfo = (PVRSRV_SGXDEV_INFO *)gpsSysData->psDeviceNodeList->pvDevice;
+
+	if (PVRSRVPowerLock(KERNEL_ID, IMG_FALSE) != PVRSRV_OK)
+	{
+		return;
+	}
+	sStats = psDevInfo->sPowerStats;
+	ui32Latencyms = psDevInfo->ui32ActivePowManLatencyms;
+	ui32MaxLatencyms = psDevInfo->ui32ActivePowManMaxLatencyms;
+	ui32KickIntervalus = psDevInfo->ui32KickIntervalAvgus;
+	PVRSRVPowerUnlock(KERNEL_ID);
+
+	seq_printf(sfile, "idle timeout %ums (max %ums) kick interval %uus\n",
+			   ui32Latencyms, ui32MaxLatencyms, ui32KickIntervalus);
+	seq_printf(sfile, "power ups %u short power downs %u\n",
+			   sStats.ui32PowerUps, sStats.ui32ShortPowerDowns);
+	seq_printf(sfile, "power up latency last %uus avg %lluus max %uus\n",
+			   sStats.ui32PowerUpLatencyLastus,
+			   sStats.ui32PowerUps ?
+			   div_u64(sStats.ui64PowerUpLatencyTotalus, sStats.ui32PowerUps) : 0,
+			   sStats.ui32PowerUpLatencyMaxus);
+	seq_printf(sfile, "on %llums off %llums\n",
+			   div_u64(sStats.ui64PoweredOnns, 1000000),
+			   div_u64(sStats.ui64PoweredOffns, 1000000));
 }
 
 #endif /* defined(SUPPORT_ACTIVE_POWER_MANAGEMENT) */
@@ -259,7 +722,12 @@ PVRSRV_ERROR SysInitialise(IMG_VOID)
 	
 	/* Set up timing information*/
 	psTimingInfo = &gsSGXDeviceMap.sTimingInfo;
+#if defined(SUPPORT_SGX_DVFS)
+	/* the governor starts from whatever rate the g3d clock was left at */
+	psTimingInfo->ui32CoreClockSpeed = clk_get_rate(g3d_clock);
+#else
 	psTimingInfo->ui32CoreClockSpeed = SYS_SGX_CLOCK_SPEED;
+#endif
 	psTimingInfo->ui32HWRecoveryFreq = SYS_SGX_HWRECOVERY_TIMEOUT_FREQ; 
 	psTimingInfo->ui32ActivePowManLatencyms = SYS_SGX_ACTIVE_POWER_LATENCY_MS; 
 	psTimingInfo->ui32uKernelFreq = SYS_SGX_PDS_TIMER_FREQ; 
@@ -466,6 +934,20 @@ PVRSRV_ERROR SysInitialise(IMG_VOID)
 		return eError;
 	}
 
+#if defined(SUPPORT_SGX_DVFS)
+	SGXDVFSInit();
+#endif
+
+#if defined(SUPPORT_ACTIVE_POWER_MANAGEMENT)
+	gpsSGXPowerProcEntry = CreateProcReadEntrySeq("sgx_power", NULL, NULL,
+												  SGXPowerProcShow,
+												  ProcSeq1ElementOff2Element, NULL);
+	if (!gpsSGXPowerProcEntry)
+	{
+		PVR_DPF((PVR_DBG_WARNING, "SysInitialise: couldn't make sgx_power proc entry"));
+	}
+#endif
+
 #if defined(SUPPORT_ACTIVE_POWER_MANAGEMENT)
 	DisableSGXClocks();
 #endif
@@ -570,9 +1052,14 @@ PVRSRV_ERROR SysDeinitialise (SYS_DATA *psSysData)
 
 #if defined(SUPPORT_ACTIVE_POWER_MANAGEMENT)
 	/* TODO: regulator and clk put. */
-	cpufreq_unregister_notifier(&cpufreq_limit_notifier,
-				    CPUFREQ_POLICY_NOTIFIER);
-	cpufreq_update_policy(current_thread_info()->cpu);
+	if (gpsSGXPowerProcEntry)
+	{
+		RemoveProcEntrySeq(gpsSGXPowerProcEntry);
+		gpsSGXPowerProcEntry = IMG_NULL;
+	}
+#if defined(SUPPORT_SGX_DVFS)
+	SGXDVFSDeinit();
+#endif
 #endif
 
 #if defined(SYS_USING_INTERRUPTS)
@@ -936,6 +1423,9 @@ PVRSRV_ERROR SysDevicePrePowerState(IMG_UINT32			ui32DeviceIndex,
 	{
 		PVRSRVSetDCState(DC_STATE_FLUSH_COMMANDS);
 		PVR_DPF((PVR_DBG_MESSAGE, "SysDevicePrePowerState: SGX Entering state D3"));
+#if defined(SUPPORT_SGX_DVFS)
+		SGXDVFSPowerOff();
+#endif
 		DisableSGXClocks();
 		PVRSRVSetDCState(DC_STATE_NO_FLUSH_COMMANDS);
 	}
@@ -980,6 +1470,9 @@ PVRSRV_ERROR SysDevicePostPowerState(IMG_UINT32			ui32DeviceIndex,
 	{
 		PVR_DPF((PVR_DBG_MESSAGE, "SysDevicePostPowerState: SGX Leaving state D3"));
 		eError = EnableSGXClocks();
+#if defined(SUPPORT_SGX_DVFS)
+		SGXDVFSPowerOn();
+#endif
 	}
 #else
 	PVR_UNREFERENCED_PARAMETER(eNewPowerState);
@@ -48,6 +48,19 @@ typedef struct _PVRSRV_STUB_PBDESC_ PVRSRV_STUB_PBDESC;
 
 typedef struct _PVRSRV_SGX_CCB_INFO_ *PPVRSRV_SGX_CCB_INFO;
 
+typedef struct _SGX_POWER_STATS_
+{
+	IMG_UINT32				ui32PowerUps;
+	IMG_UINT32				ui32ShortPowerDowns;	
+	IMG_UINT32				ui32PowerUpLatencyLastus;
+	IMG_UINT32				ui32PowerUpLatencyMaxus;
+	IMG_UINT64				ui64PowerUpLatencyTotalus;
+	IMG_UINT64				ui64PoweredOnns;
+	IMG_UINT64				ui64PoweredOffns;
+	IMG_UINT64				ui64PowerUpStartns;
+	IMG_UINT64				ui64PowerStateChangens;
+} SGX_POWER_STATS;
+
 typedef struct _PVRSRV_SGXDEV_INFO_
 {
 	PVRSRV_DEVICE_TYPE		eDeviceType;
@@ -96,6 +109,16 @@ typedef struct _PVRSRV_SGXDEV_INFO_
 	IMG_UINT32				ui32uKernelTimerClock;
 	IMG_BOOL				bSGXIdle;
 
+	
+	IMG_HANDLE				hPowerWaitQueue;
+
+	
+	IMG_UINT32				ui32ActivePowManMaxLatencyms;
+	IMG_UINT32				ui32ActivePowManLatencyms;
+	IMG_UINT32				ui32KickIntervalAvgus;
+	IMG_UINT64				ui64LastKickns;
+	SGX_POWER_STATS			sPowerStats;
+
 	PVRSRV_STUB_PBDESC		*psStubPBDescListKM;
 
 
@@ -543,6 +566,8 @@ PVRSRV_ERROR SGXPostClockSpeedChange(IMG_HANDLE				hDevHandle,
 									 IMG_BOOL				bIdleDevice,
 									 PVRSRV_DEV_POWER_STATE	eCurrentPowerState);
 
+IMG_VOID SGXActivePowerKick(PVRSRV_SGXDEV_INFO	*psDevInfo);
+
 IMG_VOID SGXPanic(PVRSRV_SGXDEV_INFO	*psDevInfo);
 
 IMG_VOID SGXDumpDebugInfo (PVRSRV_SGXDEV_INFO	*psDevInfo,
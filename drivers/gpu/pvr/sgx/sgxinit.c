@@ -624,6 +624,13 @@ static PVRSRV_ERROR DevInitSGXPart1 (IMG_VOID *pvDeviceNode)
 	OSMemSet (psDevInfo, 0, sizeof(PVRSRV_SGXDEV_INFO));
 
 	
+	if (OSWaitQueueCreate(&psDevInfo->hPowerWaitQueue) != PVRSRV_OK)
+	{
+		PVR_DPF((PVR_DBG_WARNING,"DevInitSGXPart1 : No power wait queue, power transitions will poll"));
+		psDevInfo->hPowerWaitQueue = IMG_NULL;
+	}
+
+	
 	psDevInfo->eDeviceType 		= DEV_DEVICE_TYPE;
 	psDevInfo->eDeviceClass 	= DEV_DEVICE_CLASS;
 
@@ -982,6 +989,11 @@ static PVRSRV_ERROR DevDeInitSGX (IMG_VOID *pvDeviceNode)
 #endif 
 
 
+	if (psDevInfo->hPowerWaitQueue != IMG_NULL)
+	{
+		OSWaitQueueDestroy(psDevInfo->hPowerWaitQueue);
+	}
+
 	
 	OSFreeMem(PVRSRV_OS_NON_PAGEABLE_HEAP,
 				sizeof(PVRSRV_SGXDEV_INFO),
@@ -1416,6 +1428,12 @@ IMG_BOOL SGX_ISRHandler (IMG_VOID *pvData)
 			
 			OSWriteHWReg(psDevInfo->pvRegsBaseKM, EUR_CR_EVENT_HOST_CLEAR, ui32EventClear);
 			OSWriteHWReg(psDevInfo->pvRegsBaseKM, EUR_CR_EVENT_HOST_CLEAR2, ui32EventClear2);
+
+			
+			if (psDevInfo->hPowerWaitQueue != IMG_NULL)
+			{
+				OSWaitQueueSignal(psDevInfo->hPowerWaitQueue);
+			}
 		}
 	}
 
@@ -33,6 +33,11 @@
 #include "sgxutils.h"
 #include "pdump_km.h"
 
+#define SGX_POWER_WAIT_SPIN_US		(50)
+#define SGX_POWER_WAIT_SLICE_US		(50)
+
+#define SGX_APM_MIN_LATENCY_MS		(5)
+
 
 #if defined(SUPPORT_HW_RECOVERY)
 static PVRSRV_ERROR SGXAddTimer(PVRSRV_DEVICE_NODE		*psDeviceNode,
@@ -136,8 +141,17 @@ static PVRSRV_ERROR SGXUpdateTimingInfo(PVRSRV_DEVICE_NODE	*psDeviceNode)
 
 	if (psSGXTimingInfo->bEnableActivePM)
 	{
+		
+
+		if (psDevInfo->ui32ActivePowManMaxLatencyms != psSGXTimingInfo->ui32ActivePowManLatencyms)
+		{
+			psDevInfo->ui32ActivePowManMaxLatencyms = psSGXTimingInfo->ui32ActivePowManLatencyms;
+			psDevInfo->ui32ActivePowManLatencyms = psSGXTimingInfo->ui32ActivePowManLatencyms;
+			psDevInfo->ui32KickIntervalAvgus = psSGXTimingInfo->ui32ActivePowManLatencyms * 1000 / 2;
+		}
+
 		ui32ActivePowManSampleRate =
-			psSGXTimingInfo->ui32uKernelFreq * psSGXTimingInfo->ui32ActivePowManLatencyms / 1000;
+			psSGXTimingInfo->ui32uKernelFreq * psDevInfo->ui32ActivePowManLatencyms / 1000;
 		
 
 
@@ -149,6 +163,7 @@ static PVRSRV_ERROR SGXUpdateTimingInfo(PVRSRV_DEVICE_NODE	*psDeviceNode)
 	}
 	else
 	{
+		psDevInfo->ui32ActivePowManMaxLatencyms = 0;
 		ui32ActivePowManSampleRate = 0;
 	}
 
@@ -180,7 +195,59 @@ static IMG_VOID SGXStartTimer(PVRSRV_SGXDEV_INFO	*psDevInfo)
 }
 
 
-static IMG_VOID SGXPollForClockGating (PVRSRV_SGXDEV_INFO	*psDevInfo,
+#if !defined(NO_HARDWARE)
+static PVRSRV_ERROR SGXWaitForPowerValue(PVRSRV_SGXDEV_INFO	*psDevInfo,
+										 volatile IMG_UINT32	*pui32LinMemAddr,
+										 IMG_UINT32			ui32Value,
+										 IMG_UINT32			ui32Mask)
+{
+	IMG_UINT32	ui32Spin;
+
+	
+
+	for (ui32Spin = 0; ui32Spin < SGX_POWER_WAIT_SPIN_US; ui32Spin++)
+	{
+		if ((*pui32LinMemAddr & ui32Mask) == ui32Value)
+		{
+			return PVRSRV_OK;
+		}
+		OSWaitus(1);
+	}
+
+	if (psDevInfo->hPowerWaitQueue == IMG_NULL)
+	{
+		return PollForValueKM(pui32LinMemAddr, ui32Value, ui32Mask,
+							  MAX_HW_TIME_US, MAX_HW_TIME_US/WAIT_TRY_COUNT, IMG_FALSE);
+	}
+
+	
+
+	LOOP_UNTIL_TIMEOUT(MAX_HW_TIME_US)
+	{
+		IMG_UINT32 ui32Stamp = OSWaitQueueStamp(psDevInfo->hPowerWaitQueue);
+
+		if ((*pui32LinMemAddr & ui32Mask) == ui32Value)
+		{
+			return PVRSRV_OK;
+		}
+
+		OSWaitQueueWaitus(psDevInfo->hPowerWaitQueue, ui32Stamp, SGX_POWER_WAIT_SLICE_US);
+	} END_LOOP_UNTIL_TIMEOUT();
+
+	if ((*pui32LinMemAddr & ui32Mask) == ui32Value)
+	{
+		return PVRSRV_OK;
+	}
+
+	PVR_DPF((PVR_DBG_ERROR,"SGXWaitForPowerValue: Timeout. Expected 0x%x but found 0x%x (mask 0x%x).",
+			 ui32Value, *pui32LinMemAddr & ui32Mask, ui32Mask));
+
+	return PVRSRV_ERROR_TIMEOUT;
+}
+#endif 
+
+
+static IMG_VOID SGXWaitForClockGating (PVRSRV_SGXDEV_INFO	*psDevInfo,
 									   IMG_UINT32			ui32Register,
 									   IMG_UINT32			ui32RegisterValue,
 									   IMG_CHAR				*pszComment)
@@ -194,14 +261,12 @@ static IMG_VOID SGXPollForClockGating (PVRSRV_SGXDEV_INFO	*psDevInfo,
 	PVR_ASSERT(psDevInfo != IMG_NULL);
 
 	 
-	if (PollForValueKM((IMG_UINT32 *)psDevInfo->pvRegsBaseKM + (ui32Register >> 2),
-						0,
-						ui32RegisterValue,
-						MAX_HW_TIME_US,
-						MAX_HW_TIME_US/WAIT_TRY_COUNT,
-						IMG_FALSE) != PVRSRV_OK)
+	if (SGXWaitForPowerValue(psDevInfo,
+							 (IMG_UINT32 *)psDevInfo->pvRegsBaseKM + (ui32Register >> 2),
+							 0,
+							 ui32RegisterValue) != PVRSRV_OK)
 	{
-		PVR_DPF((PVR_DBG_ERROR,"SGXPollForClockGating: %s failed.", pszComment));
+		PVR_DPF((PVR_DBG_ERROR,"SGXWaitForClockGating: %s failed.", pszComment));
 		SGXDumpDebugInfo(psDevInfo, IMG_FALSE);
 		PVR_DBG_BREAK;
 	}
@@ -212,10 +277,142 @@ static IMG_VOID SGXPollForClockGating (PVRSRV_SGXDEV_INFO	*psDevInfo,
 }
 
 
+static IMG_UINT32 SGXNsToUs(IMG_UINT64 ui64Ns)
+{
+	if (ui64Ns > 0xFFFFFFFFULL)
+	{
+		return 0xFFFFFFFFU / 1000;
+	}
+	return (IMG_UINT32)ui64Ns / 1000;
+}
+
+
+static IMG_VOID SGXPowerStatsOn(PVRSRV_SGXDEV_INFO	*psDevInfo)
+{
+	SGX_POWER_STATS	*psStats = &psDevInfo->sPowerStats;
+	IMG_UINT64		ui64Now = OSClockns64();
+	IMG_UINT32		ui32Latencyus;
+
+	psStats->ui32PowerUps++;
+	if (psStats->ui64PowerUpStartns != 0)
+	{
+		ui32Latencyus = SGXNsToUs(ui64Now - psStats->ui64PowerUpStartns);
+		psStats->ui32PowerUpLatencyLastus = ui32Latencyus;
+		psStats->ui64PowerUpLatencyTotalus += ui32Latencyus;
+		if (ui32Latencyus > psStats->ui32PowerUpLatencyMaxus)
+		{
+			psStats->ui32PowerUpLatencyMaxus = ui32Latencyus;
+		}
+		psStats->ui64PowerUpStartns = 0;
+	}
+
+	if (psStats->ui64PowerStateChangens != 0)
+	{
+		IMG_UINT64 ui64Offns = ui64Now - psStats->ui64PowerStateChangens;
+
+		psStats->ui64PoweredOffns += ui64Offns;
+
+		
+
+		if (ui64Offns < (IMG_UINT64)psDevInfo->ui32ActivePowManLatencyms * 1000000)
+		{
+			psStats->ui32ShortPowerDowns++;
+		}
+	}
+	psStats->ui64PowerStateChangens = ui64Now;
+}
+
+
+static IMG_VOID SGXPowerStatsOff(PVRSRV_SGXDEV_INFO	*psDevInfo)
+{
+	SGX_POWER_STATS	*psStats = &psDevInfo->sPowerStats;
+	IMG_UINT64		ui64Now = OSClockns64();
+
+	if (psStats->ui64PowerStateChangens != 0)
+	{
+		psStats->ui64PoweredOnns += ui64Now - psStats->ui64PowerStateChangens;
+	}
+	psStats->ui64PowerStateChangens = ui64Now;
+}
+
+
+static IMG_VOID SGXActivePowerKickLocked(PVRSRV_SGXDEV_INFO	*psDevInfo)
+{
+	IMG_UINT64	ui64Now = OSClockns64();
+	IMG_UINT64	ui64Gapns = ui64Now - psDevInfo->ui64LastKickns;
+	IMG_UINT32	ui32Maxms = psDevInfo->ui32ActivePowManMaxLatencyms;
+	IMG_INT32	i32Gapus, i32Avgus;
+	IMG_UINT32	ui32Latencyms;
+
+	psDevInfo->ui64LastKickns = ui64Now;
+
+	
+
+	if (ui32Maxms == 0 || ui64Gapns >= (IMG_UINT64)ui32Maxms * 1000000)
+	{
+		return;
+	}
+
+	
+
+	i32Gapus = (IMG_INT32)((IMG_UINT32)ui64Gapns / 1000);
+	i32Avgus = (IMG_INT32)psDevInfo->ui32KickIntervalAvgus;
+	i32Avgus += (i32Gapus - i32Avgus) / 8;
+	psDevInfo->ui32KickIntervalAvgus = (IMG_UINT32)i32Avgus;
+
+	ui32Latencyms = (2 * psDevInfo->ui32KickIntervalAvgus) / 1000 + 1;
+	if (ui32Latencyms < SGX_APM_MIN_LATENCY_MS)
+	{
+		ui32Latencyms = SGX_APM_MIN_LATENCY_MS;
+	}
+	if (ui32Latencyms > ui32Maxms)
+	{
+		ui32Latencyms = ui32Maxms;
+	}
+
+	if (ui32Latencyms != psDevInfo->ui32ActivePowManLatencyms &&
+		psDevInfo->psSGXHostCtl != IMG_NULL &&
+		psDevInfo->ui32uKernelTimerClock != 0)
+	{
+		IMG_UINT32 ui32uKernelFreq = psDevInfo->ui32CoreClockSpeed / psDevInfo->ui32uKernelTimerClock;
+
+		psDevInfo->ui32ActivePowManLatencyms = ui32Latencyms;
+		psDevInfo->psSGXHostCtl->ui32ActivePowManSampleRate = ui32uKernelFreq * ui32Latencyms / 1000 + 1;
+	}
+}
+
+
+/*
+ * The kick paths no longer hold the services lock, and the same state is
+ * written by SGXUpdateTimingInfo during power transitions, so take the
+ * power lock.  A kick that can't get it just isn't sampled.
+ */
+IMG_VOID SGXActivePowerKick(PVRSRV_SGXDEV_INFO	*psDevInfo)
+{
+	if (PVRSRVPowerLock(KERNEL_ID, IMG_FALSE) != PVRSRV_OK)
+	{
+		return;
+	}
+
+	SGXActivePowerKickLocked(psDevInfo);
+
+	PVRSRVPowerUnlock(KERNEL_ID);
+}
+
+
 PVRSRV_ERROR SGXPrePowerState (IMG_HANDLE				hDevHandle,
 							   PVRSRV_DEV_POWER_STATE	eNewPowerState,
 							   PVRSRV_DEV_POWER_STATE	eCurrentPowerState)
 {
+	if ((eNewPowerState == PVRSRV_DEV_POWER_STATE_ON) &&
+		(eCurrentPowerState == PVRSRV_DEV_POWER_STATE_OFF))
+	{
+		PVRSRV_DEVICE_NODE	*psDeviceNode = hDevHandle;
+		PVRSRV_SGXDEV_INFO	*psDevInfo = psDeviceNode->pvDevice;
+
+		psDevInfo->sPowerStats.ui64PowerUpStartns = OSClockns64();
+	}
+
 	if ((eNewPowerState != eCurrentPowerState) &&
 		(eNewPowerState != PVRSRV_DEV_POWER_STATE_ON))
 	{
@@ -263,12 +460,10 @@ PVRSRV_ERROR SGXPrePowerState (IMG_HANDLE				hDevHandle,
 
 		
 		#if !defined(NO_HARDWARE)
-		if (PollForValueKM(&psDevInfo->psSGXHostCtl->ui32PowerStatus,
-							ui32CompleteStatus,
-							ui32CompleteStatus,
-							MAX_HW_TIME_US,
-							MAX_HW_TIME_US/WAIT_TRY_COUNT,
-							IMG_FALSE) != PVRSRV_OK)
+		if (SGXWaitForPowerValue(psDevInfo,
+								 &psDevInfo->psSGXHostCtl->ui32PowerStatus,
+								 ui32CompleteStatus,
+								 ui32CompleteStatus) != PVRSRV_OK)
 		{
 			PVR_DPF((PVR_DBG_ERROR,"SGXPrePowerState: Wait for SGX ukernel power transition failed."));
 			PVR_DBG_BREAK;
@@ -295,7 +490,7 @@ PVRSRV_ERROR SGXPrePowerState (IMG_HANDLE				hDevHandle,
 		for (ui32Core = 0; ui32Core < ui32CoresEnabled; ui32Core++)
 		{
 			
-			SGXPollForClockGating(psDevInfo,
+			SGXWaitForClockGating(psDevInfo,
 								  SGX_MP_CORE_SELECT(psDevInfo->ui32ClkGateStatusReg, ui32Core),
 								  psDevInfo->ui32ClkGateStatusMask,
 								  "Wait for SGX clock gating");
@@ -303,12 +498,12 @@ PVRSRV_ERROR SGXPrePowerState (IMG_HANDLE				hDevHandle,
 
 		#if defined(SGX_FEATURE_MP)
 		
-		SGXPollForClockGating(psDevInfo,
+		SGXWaitForClockGating(psDevInfo,
 							  psDevInfo->ui32MasterClkGateStatusReg,
 							  psDevInfo->ui32MasterClkGateStatusMask,
 							  "Wait for SGX master clock gating");
 
-		SGXPollForClockGating(psDevInfo,
+		SGXWaitForClockGating(psDevInfo,
 							  psDevInfo->ui32MasterClkGateStatus2Reg,
 							  psDevInfo->ui32MasterClkGateStatus2Mask,
 							  "Wait for SGX master clock gating (2)");
@@ -323,6 +518,8 @@ PVRSRV_ERROR SGXPrePowerState (IMG_HANDLE				hDevHandle,
 				PVR_DPF((PVR_DBG_ERROR,"SGXPrePowerState: SGXDeinitialise failed: %u", eError));
 				return eError;
 			}
+
+			SGXPowerStatsOff(psDevInfo);
 		}
 	}
 
@@ -373,6 +570,8 @@ PVRSRV_ERROR SGXPostPowerState (IMG_HANDLE				hDevHandle,
 				PVR_DPF((PVR_DBG_ERROR,"SGXPostPowerState: SGXInitialise failed"));
 				return eError;
 			}
+
+			SGXPowerStatsOn(psDevInfo);
 		}
 		else
 		{
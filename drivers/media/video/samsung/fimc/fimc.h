@@ -16,6 +16,7 @@
 
 #ifdef __KERNEL__
 #include <linux/wait.h>
+#include <linux/notifier.h>
 #include <linux/mutex.h>
 #include <linux/i2c.h>
 #include <linux/fb.h>
@@ -27,6 +28,7 @@
 #include <media/videobuf-core.h>
 #include <plat/media.h>
 #include <plat/fimc.h>
+#include <plat/media-buf.h>
 #endif
 
 #define FIMC_NAME		"s3c-fimc"
@@ -176,6 +178,7 @@ struct fimc_buf_set {
 	u32			flags;
 	atomic_t		mapped_cnt;
 	struct list_head	list;
+	struct s5p_media_buf	*shared;	/* imported source, output only */
 };
 
 /* for capture device */
@@ -207,6 +210,25 @@ struct fimc_ctx_idx {
 	struct fimc_idx next;
 };
 
+/*
+ * vsync-aligned flips for FIMC_OVLY_DMA_AUTO: a destination buffer is not
+ * written again while FIMD is scanning it out or about to latch it.
+ */
+struct fimc_flip {
+	spinlock_t		lock;
+	struct notifier_block	nb;
+	int			registered;
+	int			ctx;		/* context owning pending/shown */
+	int			pending;	/* panned, latched at next vsync */
+	int			shown;		/* being scanned out */
+	int			waiting;	/* next frame held for vsync */
+
+	u32			vsyncs;
+	u32			flips;
+	u32			missed_vsyncs;	/* replaced before it was shown */
+	u32			deferred;	/* starts held back for vsync */
+};
+
 /* scaler abstraction: local use recommended */
 struct fimc_scaler {
 	u32 bypass;
@@ -310,6 +332,9 @@ struct s3cfb_window {
 	enum			s3cfb_mem_owner_t owner;
 	unsigned int	other_mem_addr;
 	unsigned int	other_mem_size;
+	struct			s5p_media_buf *shared;
+	struct			s5p_media_buf *retired;
+	u32			retired_vsync;
 	int			local_channel;
 	int			dma_burst;
 	unsigned int		pseudo_pal[16];
@@ -327,6 +352,12 @@ struct s3cfb_window {
 #define S3CFB_SET_WIN_PATH	_IOW('F', 308, enum s3cfb_data_path_t)
 #define S3CFB_SET_WIN_ADDR	_IOW('F', 309, unsigned long)
 #define S3CFB_SET_WIN_MEM	_IOW('F', 310, enum s3cfb_mem_owner_t)
+
+#define S3CFB_EVENT_VSYNC		0
+#define S3CFB_EVENT_DISPLAY_OFF		1
+
+extern int s3cfb_register_vsync_notifier(struct notifier_block *nb);
+extern int s3cfb_unregister_vsync_notifier(struct notifier_block *nb);
 /* ------------------------------------------------------------------------ */
 
 struct fimc_fbinfo {
@@ -369,6 +400,7 @@ struct fimc_control {
 	int				id;		/* controller id */
 	char				name[16];
 	atomic_t			in_use;
+	atomic_t			cap_exported;	/* live capture handles */
 	void __iomem			*regs;		/* register i/o */
 	struct clk			*clk;		/* interface clock */
 	struct regulator	*regulator;		/* pd regulator */
@@ -394,6 +426,7 @@ struct fimc_control {
 	struct fimc_fbinfo		fb;		/* fimd info */
 	struct fimc_scaler		sc;		/* scaler info */
 	struct fimc_effect		fe;		/* fimc effect info */
+	struct fimc_flip		flip;		/* overlay flip state */
 
 	enum fimc_status		status;
 	enum fimc_log			log;
@@ -505,7 +538,8 @@ extern int fimc_try_fmt_vid_capture(struct file *file, void *fh,
 extern int fimc_reqbufs_capture(void *fh, struct v4l2_requestbuffers *b);
 extern int fimc_querybuf_capture(void *fh, struct v4l2_buffer *b);
 extern int fimc_g_ctrl_capture(void *fh, struct v4l2_control *c);
-extern int fimc_s_ctrl_capture(void *fh, struct v4l2_control *c);
+extern int fimc_s_ctrl_capture(struct file *filp, void *fh,
+					struct v4l2_control *c);
 extern int fimc_s_ext_ctrls_capture(void *fh, struct v4l2_ext_controls *c);
 extern int fimc_cropcap_capture(void *fh, struct v4l2_cropcap *a);
 extern int fimc_g_crop_capture(void *fh, struct v4l2_crop *a);
@@ -573,6 +607,14 @@ extern int fimc_pop_outq(struct fimc_control *ctrl,
 					struct fimc_ctx *ctx, int *idx);
 extern int fimc_init_out_queue(struct fimc_control *ctrl, struct fimc_ctx *ctx);
 extern void fimc_outdev_init_idxs(struct fimc_control *ctrl);
+extern void fimc_outdev_put_shared_buf(struct fimc_ctx *ctx, int idx);
+extern int fimc_outdev_start_dma(struct fimc_control *ctrl,
+					struct fimc_ctx *ctx, int idx);
+extern int fimc_outdev_pop_inq(struct fimc_control *ctrl,
+					int *ctx_num, int *idx, int idle);
+extern void fimc_outdev_flip(struct fimc_control *ctrl,
+					struct fimc_ctx *ctx, int idx);
+extern void fimc_outdev_flip_stop(struct fimc_control *ctrl);
 
 extern void fimc_dump_context(struct fimc_control *ctrl, struct fimc_ctx *ctx);
 extern void fimc_print_signal(struct fimc_control *ctrl);
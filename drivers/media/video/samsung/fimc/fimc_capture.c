@@ -20,6 +20,7 @@
 #include <linux/mm.h>
 #include <linux/io.h>
 #include <linux/uaccess.h>
+#include <linux/file.h>
 #include <plat/media.h>
 #include <plat/clock.h>
 #include <plat/fimc.h>
@@ -192,6 +193,14 @@ static const struct v4l2_queryctrl fimc_controls[] = {
 		.step = 1,
 		.default_value = 0,
 		.flags = V4L2_CTRL_FLAG_READ_ONLY,
+	}, {
+		.id = V4L2_CID_EXPORT_BUF,
+		.type = V4L2_CTRL_TYPE_INTEGER,
+		.name = "Export buffer",
+		.minimum = 0,
+		.maximum = FIMC_CAPBUFS - 1,
+		.step = 1,
+		.default_value = 0,
 	},
 };
 
@@ -984,6 +993,11 @@ int fimc_reqbufs_capture(void *fh, struct v4l2_requestbuffers *b)
 		return -ENODEV;
 	}
 
+	if (atomic_read(&ctrl->cap_exported)) {
+		fimc_err("%s: capture buffers are still shared\n", __func__);
+		return -EBUSY;
+	}
+
 	mutex_lock(&ctrl->v4l2_lock);
 
 	if (b->count < 1 || b->count > FIMC_CAPBUFS)
@@ -1155,6 +1169,82 @@ int fimc_g_ctrl_capture(void *fh, struct v4l2_control *c)
 	return ret;
 }
 
+struct fimc_cap_shared_buf {
+	struct s5p_media_buf	buf;
+	struct fimc_control	*ctrl;
+	struct file		*fimc_file;
+};
+
+static void fimc_cap_shared_buf_release(struct s5p_media_buf *buf)
+{
+	struct fimc_cap_shared_buf *shared =
+		container_of(buf, struct fimc_cap_shared_buf, buf);
+
+	atomic_dec(&shared->ctrl->cap_exported);
+
+	/* may be the last reference, which releases the capture device */
+	fput(shared->fimc_file);
+	kfree(shared);
+}
+
+/*
+ * Wrap the planes of capture buffer @idx in a shared buffer fd, so the
+ * frame can go straight to the MFC encoder or the JPEG block. The buffers
+ * cannot be reallocated, and the device stays open, until every copy of
+ * the fd has been closed. Called with v4l2_lock held.
+ */
+static int fimc_export_buf_capture(struct file *filp,
+				   struct fimc_control *ctrl, int idx)
+{
+	struct fimc_buf_set *bufs;
+	struct fimc_cap_shared_buf *shared;
+	struct s5p_media_buf *buf;
+	int plane, fd;
+
+	if (idx < 0 || idx >= ctrl->cap->nr_bufs ||
+	    !ctrl->cap->bufs[idx].base[FIMC_ADDR_Y]) {
+		fimc_err("%s: invalid buffer index %d\n", __func__, idx);
+		return -EINVAL;
+	}
+
+	shared = kzalloc(sizeof(*shared), GFP_KERNEL);
+	if (!shared)
+		return -ENOMEM;
+
+	bufs = &ctrl->cap->bufs[idx];
+	buf = &shared->buf;
+	for (plane = 0; plane < S5P_MEDIA_BUF_MAX_PLANES; plane++) {
+		if (!bufs->base[plane] || !bufs->length[plane])
+			break;
+
+		buf->plane[plane].paddr = bufs->base[plane];
+		buf->plane[plane].size = bufs->length[plane];
+		buf->nr_planes++;
+	}
+
+	buf->exporter = ctrl->name;
+	/* the capture buffers are only ever mapped uncached */
+	buf->cpu_cached = false;
+	buf->release = fimc_cap_shared_buf_release;
+
+	shared->ctrl = ctrl;
+	get_file(filp);
+	shared->fimc_file = filp;
+	atomic_inc(&ctrl->cap_exported);
+
+	fd = s5p_media_buf_export(buf);
+	if (fd < 0) {
+		fimc_err("%s: failed to export buffer %d (%d)\n",
+				__func__, idx, fd);
+		atomic_dec(&ctrl->cap_exported);
+		fput(filp);
+		kfree(shared);
+	}
+
+	return fd;
+}
+
+
 /**
  * We used s_ctrl API to get the physical address of the buffers.
  * In g_ctrl, we can pass only one parameter, thus we cannot pass
@@ -1164,7 +1254,7 @@ int fimc_g_ctrl_capture(void *fh, struct v4l2_control *c)
  * for C0~C3). Currently, we will continue with the existing
  * implementation till we get any better idea to implement.
  */
-int fimc_s_ctrl_capture(void *fh, struct v4l2_control *c)
+int fimc_s_ctrl_capture(struct file *filp, void *fh, struct v4l2_control *c)
 {
 	struct fimc_control *ctrl = ((struct fimc_prv_data *)fh)->ctrl;
 	int ret = 0;
@@ -1203,6 +1293,14 @@ int fimc_s_ctrl_capture(void *fh, struct v4l2_control *c)
 		c->value = ctrl->cap->bufs[c->value].base[FIMC_ADDR_CR];
 		break;
 
+	case V4L2_CID_EXPORT_BUF:
+		ret = fimc_export_buf_capture(filp, ctrl, c->value);
+		if (ret >= 0) {
+			c->value = ret;
+			ret = 0;
+		}
+		break;
+
 	/* Implementation as per C100 FIMC driver */
 	case V4L2_CID_STREAM_PAUSE:
 		fimc_hwset_stop_processing(ctrl);
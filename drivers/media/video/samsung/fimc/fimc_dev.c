@@ -246,9 +246,8 @@ static inline u32 fimc_irq_out_multi_buf(struct fimc_control *ctrl,
 static inline u32 fimc_irq_out_dma(struct fimc_control *ctrl,
 				   struct fimc_ctx *ctx)
 {
-	struct fimc_buf_set buf_set;
 	int idx = ctrl->out->idxs.active.idx;
-	int ret = -1, i, ctx_num, next;
+	int ret = -1, ctx_num, next;
 	u32 wakeup = 1;
 
 	if (ctx->status == FIMC_READY_OFF) {
@@ -279,29 +278,18 @@ static inline u32 fimc_irq_out_dma(struct fimc_control *ctrl,
 					__func__, ret);
 			return -EINVAL;
 		}
+
+		fimc_outdev_flip(ctrl, ctx, idx);
 	}
 
-	/* Detach buffer from incomming queue. */
-	ret = fimc_pop_inq(ctrl, &ctx_num, &next);
+	/*
+	 * Detach buffer from incomming queue. A buffer whose destination is
+	 * still on screen is left queued and started from the next vsync.
+	 */
+	ret = fimc_outdev_pop_inq(ctrl, &ctx_num, &next, 0);
 	if (ret == 0) {		/* There is a buffer in incomming queue. */
 		ctx = &ctrl->out->ctx[ctx_num];
-		fimc_outdev_set_src_addr(ctrl, ctx->src[next].base);
-
-		memset(&buf_set, 0x00, sizeof(buf_set));
-		buf_set.base[FIMC_ADDR_Y] = ctx->dst[next].base[FIMC_ADDR_Y];
-
-		for (i = 0; i < FIMC_PHYBUFS; i++)
-			fimc_hwset_output_address(ctrl, &buf_set, i);
-
-		ret = fimc_outdev_start_camif(ctrl);
-		if (ret < 0)
-			fimc_err("Fail: fimc_start_camif\n");
-
-		ctrl->out->idxs.active.ctx = ctx_num;
-		ctrl->out->idxs.active.idx = next;
-
-		ctx->status = FIMC_STREAMON;
-		ctrl->status = FIMC_STREAMON;
+		fimc_outdev_start_dma(ctrl, ctx, next);
 	} else {		/* There is no buffer in incomming queue. */
 		ctrl->out->idxs.active.ctx = -1;
 		ctrl->out->idxs.active.idx = -1;
@@ -478,6 +466,10 @@ struct fimc_control *fimc_register_controller(struct platform_device *pdev)
 	mutex_init(&ctrl->alloc_lock);
 	mutex_init(&ctrl->v4l2_lock);
 	init_waitqueue_head(&ctrl->wq);
+	spin_lock_init(&ctrl->flip.lock);
+	ctrl->flip.ctx = -1;
+	ctrl->flip.pending = -1;
+	ctrl->flip.shown = -1;
 
 	/* get resource for io memory */
 	res = platform_get_resource(pdev, IORESOURCE_MEM, 0);
@@ -1034,6 +1026,7 @@ static int fimc_release(struct file *filp)
 
 			/* Make all buffers DQUEUED state. */
 			for (i = 0; i < FIMC_OUTBUFS; i++) {
+				fimc_outdev_put_shared_buf(ctx, i);
 				ctx->src[i].state = VIDEOBUF_IDLE;
 				ctx->src[i].flags = V4L2_BUF_FLAG_MAPPED;
 			}
@@ -1073,6 +1066,7 @@ static int fimc_release(struct file *filp)
 		if (atomic_read(&ctrl->in_use) == 0) {
 			ctrl->status = FIMC_STREAMOFF;
 			fimc_outdev_init_idxs(ctrl);
+			fimc_outdev_flip_stop(ctrl);
 
 			fimc_clk_en(ctrl, false);
 
@@ -1307,6 +1301,22 @@ static DEVICE_ATTR(log_level, 0644, \
 			fimc_show_log_level,
 			fimc_store_log_level);
 
+static ssize_t fimc_show_flip_stats(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct fimc_control *ctrl;
+	struct fimc_flip *flip;
+
+	ctrl = get_fimc_ctrl(to_platform_device(dev)->id);
+	flip = &ctrl->flip;
+
+	return sprintf(buf, "vsyncs %u\nflips %u\nmissed_vsyncs %u\n"
+			"deferred %u\n", flip->vsyncs, flip->flips,
+			flip->missed_vsyncs, flip->deferred);
+}
+
+static DEVICE_ATTR(flip_stats, 0444, fimc_show_flip_stats, NULL);
+
 static int __devinit fimc_probe(struct platform_device *pdev)
 {
 	struct s3c_platform_fimc *pdata;
@@ -1391,6 +1401,13 @@ static int __devinit fimc_probe(struct platform_device *pdev)
 		fimc_err("failed to add sysfs entries\n");
 		goto err_global;
 	}
+
+	ret = device_create_file(&(pdev->dev), &dev_attr_flip_stats);
+	if (ret < 0) {
+		fimc_err("failed to add sysfs entries\n");
+		device_remove_file(&(pdev->dev), &dev_attr_log_level);
+		goto err_global;
+	}
 	printk(KERN_INFO "FIMC%d registered successfully\n", ctrl->id);
 
 	return 0;
@@ -1415,6 +1432,7 @@ static int fimc_remove(struct platform_device *pdev)
 	fimc_unregister_controller(pdev);
 
 	device_remove_file(&(pdev->dev), &dev_attr_log_level);
+	device_remove_file(&(pdev->dev), &dev_attr_flip_stats);
 
 	kfree(fimc_dev);
 	fimc_dev = NULL;
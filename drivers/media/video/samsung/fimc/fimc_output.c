@@ -185,6 +185,7 @@ static void fimc_init_out_buf(struct fimc_ctx *ctx)
 	int i;
 
 	for (i = 0; i < FIMC_OUTBUFS; i++) {
+		fimc_outdev_put_shared_buf(ctx, i);
 		ctx->src[i].state = VIDEOBUF_IDLE;
 		ctx->src[i].flags = 0x0;
 
@@ -1627,6 +1628,217 @@ int fimc_s_crop_output(void *fh, struct v4l2_crop *a)
 	return 0;
 }
 
+int fimc_outdev_start_dma(struct fimc_control *ctrl,
+			  struct fimc_ctx *ctx, int idx)
+{
+	struct fimc_buf_set buf_set;	/* destination addr */
+	int ret, i;
+
+	fimc_outdev_set_src_addr(ctrl, ctx->src[idx].base);
+
+	memset(&buf_set, 0x00, sizeof(buf_set));
+	buf_set.base[FIMC_ADDR_Y] = ctx->dst[idx].base[FIMC_ADDR_Y];
+
+	for (i = 0; i < FIMC_PHYBUFS; i++)
+		fimc_hwset_output_address(ctrl, &buf_set, i);
+
+	ret = fimc_outdev_start_camif(ctrl);
+	if (ret < 0)
+		fimc_err("Fail: fimc_start_camif\n");
+
+	ctrl->out->idxs.active.ctx = ctx->ctx_num;
+	ctrl->out->idxs.active.idx = idx;
+
+	ctx->status = FIMC_STREAMON;
+	ctrl->status = FIMC_STREAMON;
+
+	return ret;
+}
+
+static int fimc_peek_inq(struct fimc_control *ctrl, int *ctx_num, int *idx)
+{
+	unsigned long spin_flags;
+	int i;
+
+	spin_lock_irqsave(&ctrl->out->lock_in, spin_flags);
+
+	for (i = (FIMC_INQUEUES-1); i >= 0; i--) {
+		if (ctrl->out->inq[i].ctx != -1) {
+			*ctx_num = ctrl->out->inq[i].ctx;
+			*idx = ctrl->out->inq[i].idx;
+			break;
+		}
+	}
+
+	spin_unlock_irqrestore(&ctrl->out->lock_in, spin_flags);
+
+	return (i < 0) ? -EINVAL : 0;
+}
+
+/* called with flip.lock held */
+static int fimc_outdev_flip_blocked(struct fimc_control *ctrl)
+{
+	struct fimc_flip *flip = &ctrl->flip;
+	int ctx_num, idx;
+
+	if (fimc_peek_inq(ctrl, &ctx_num, &idx) < 0)
+		return 0;
+
+	if (ctx_num != flip->ctx ||
+	    ctrl->out->ctx[ctx_num].overlay.mode != FIMC_OVLY_DMA_AUTO)
+		return 0;
+
+	if (idx == flip->pending)
+		return 1;
+
+	/*
+	 * The buffer on screen is released by the pending flip. Without one
+	 * nothing will ever replace it, so write it anyway rather than stall.
+	 */
+	if (idx == flip->shown && flip->pending != -1)
+		return 1;
+
+	return 0;
+}
+
+/*
+ * Detach the next buffer to process, unless it is a DMA_AUTO destination
+ * FIMD still needs. Then it stays queued and the next vsync starts it.
+ * With idle set, nothing is detached if a vsync has restarted the
+ * controller in the meantime.
+ */
+int fimc_outdev_pop_inq(struct fimc_control *ctrl, int *ctx_num, int *idx,
+			int idle)
+{
+	struct fimc_flip *flip = &ctrl->flip;
+	unsigned long flags;
+	int ret;
+
+	spin_lock_irqsave(&flip->lock, flags);
+
+	if (idle && ctrl->status != FIMC_READY_ON &&
+	    ctrl->status != FIMC_STREAMON_IDLE) {
+		spin_unlock_irqrestore(&flip->lock, flags);
+		return -EAGAIN;
+	}
+
+	if (fimc_outdev_flip_blocked(ctrl)) {
+		if (!flip->waiting) {
+			flip->waiting = 1;
+			flip->deferred++;
+		}
+		spin_unlock_irqrestore(&flip->lock, flags);
+		return -EAGAIN;
+	}
+
+	flip->waiting = 0;
+	ret = fimc_pop_inq(ctrl, ctx_num, idx);
+
+	spin_unlock_irqrestore(&flip->lock, flags);
+
+	return ret;
+}
+
+/* dst[idx] has just been panned to, FIMD latches it at the next vsync */
+void fimc_outdev_flip(struct fimc_control *ctrl, struct fimc_ctx *ctx, int idx)
+{
+	struct fimc_flip *flip = &ctrl->flip;
+	unsigned long flags;
+
+	spin_lock_irqsave(&flip->lock, flags);
+
+	if (flip->ctx != ctx->ctx_num) {
+		flip->ctx = ctx->ctx_num;
+		flip->shown = -1;
+		flip->pending = -1;
+	}
+
+	if (flip->pending != -1)
+		flip->missed_vsyncs++;
+
+	flip->pending = idx;
+	flip->flips++;
+
+	spin_unlock_irqrestore(&flip->lock, flags);
+}
+
+static int fimc_outdev_vsync(struct notifier_block *nb,
+			     unsigned long event, void *data)
+{
+	struct fimc_control *ctrl = container_of(nb, struct fimc_control,
+						 flip.nb);
+	struct fimc_flip *flip = &ctrl->flip;
+	unsigned long flags;
+	int ctx_num, idx;
+
+	spin_lock_irqsave(&flip->lock, flags);
+
+	if (event == S3CFB_EVENT_DISPLAY_OFF) {
+		flip->shown = -1;
+		flip->pending = -1;
+	} else {
+		flip->vsyncs++;
+		if (flip->pending != -1) {
+			flip->shown = flip->pending;
+			flip->pending = -1;
+		}
+	}
+
+	if (flip->waiting && ctrl->status == FIMC_STREAMON_IDLE &&
+	    !fimc_outdev_flip_blocked(ctrl)) {
+		flip->waiting = 0;
+		if (fimc_pop_inq(ctrl, &ctx_num, &idx) == 0)
+			fimc_outdev_start_dma(ctrl, &ctrl->out->ctx[ctx_num],
+					      idx);
+	}
+
+	spin_unlock_irqrestore(&flip->lock, flags);
+
+	return NOTIFY_OK;
+}
+
+static void fimc_outdev_flip_start(struct fimc_control *ctrl,
+				   struct fimc_ctx *ctx)
+{
+	struct fimc_flip *flip = &ctrl->flip;
+	unsigned long flags;
+
+	spin_lock_irqsave(&flip->lock, flags);
+	flip->ctx = ctx->ctx_num;
+	flip->pending = -1;
+	flip->shown = -1;
+	flip->waiting = 0;
+	spin_unlock_irqrestore(&flip->lock, flags);
+
+#ifdef CONFIG_FB_S3C
+	if (!flip->registered) {
+		flip->nb.notifier_call = fimc_outdev_vsync;
+		if (s3cfb_register_vsync_notifier(&flip->nb) == 0)
+			flip->registered = 1;
+	}
+#endif
+}
+
+void fimc_outdev_flip_stop(struct fimc_control *ctrl)
+{
+	struct fimc_flip *flip = &ctrl->flip;
+	unsigned long flags;
+
+#ifdef CONFIG_FB_S3C
+	if (flip->registered) {
+		s3cfb_unregister_vsync_notifier(&flip->nb);
+		flip->registered = 0;
+	}
+#endif
+
+	spin_lock_irqsave(&flip->lock, flags);
+	flip->ctx = -1;
+	flip->pending = -1;
+	flip->shown = -1;
+	flip->waiting = 0;
+	spin_unlock_irqrestore(&flip->lock, flags);
+}
+
 int fimc_streamon_output(void *fh)
 {
 	struct fimc_ctx *ctx;
@@ -1645,6 +1857,8 @@ int fimc_streamon_output(void *fh)
 		ret = fimc_outdev_set_dst_buf(ctrl, ctx);
 		if (ret)
 			return ret;
+
+		fimc_outdev_flip_start(ctrl, ctx);
 	}
 
 	ret = fimc_outdev_check_param(ctrl, ctx);
@@ -1700,6 +1914,7 @@ int fimc_streamoff_output(void *fh)
 
 	/* Make all buffers DQUEUED state. */
 	for (i = 0; i < FIMC_OUTBUFS; i++) {
+		fimc_outdev_put_shared_buf(ctx, i);
 		ctx->src[i].state = VIDEOBUF_IDLE;
 		ctx->src[i].flags = V4L2_BUF_FLAG_MAPPED;
 	}
@@ -1734,6 +1949,7 @@ int fimc_streamoff_output(void *fh)
 		ctrl->status = FIMC_STREAMOFF;
 		fimc_outdev_init_idxs(ctrl);
 		fimc_outdev_stop_camif(ctrl);
+		fimc_outdev_flip_stop(ctrl);
 	}
 
 	if (ctx_id == ctrl->out->last_ctx)
@@ -2020,6 +2236,73 @@ static int fimc_update_in_queue_addr(struct fimc_control *ctrl,
 	return 0;
 }
 
+void fimc_outdev_put_shared_buf(struct fimc_ctx *ctx, int idx)
+{
+	if (ctx->src[idx].shared) {
+		s5p_media_buf_put(ctx->src[idx].shared);
+		ctx->src[idx].shared = NULL;
+	}
+}
+
+static unsigned int fimc_outdev_src_planes(u32 pixelformat)
+{
+	switch (pixelformat) {
+	case V4L2_PIX_FMT_YUV420:
+		return 3;
+	case V4L2_PIX_FMT_NV12:		/* fall through */
+	case V4L2_PIX_FMT_NV21:		/* fall through */
+	case V4L2_PIX_FMT_NV12T:	/* fall through */
+	case V4L2_PIX_FMT_NV16:		/* fall through */
+	case V4L2_PIX_FMT_NV61:
+		return 2;
+	default:
+		return 1;
+	}
+}
+
+/*
+ * Point the source buffer straight at another device's memory, e.g. an
+ * MFC decoded frame. The reference is held until the buffer is dequeued
+ * so the exporter cannot recycle the memory while FIMC is reading it.
+ */
+static int fimc_update_in_queue_shared(struct fimc_control *ctrl,
+				       struct fimc_ctx *ctx, u32 idx, int fd)
+{
+	struct s5p_media_buf *shared;
+	dma_addr_t addr[3] = { 0, 0, 0 };
+	unsigned int i;
+	int ret;
+
+	shared = s5p_media_buf_get(fd);
+	if (IS_ERR(shared)) {
+		fimc_err("%s: invalid shared buffer fd(%d)\n", __func__, fd);
+		return PTR_ERR(shared);
+	}
+
+	if (shared->nr_planes < fimc_outdev_src_planes(ctx->pix.pixelformat) ||
+	    shared->plane[0].size < ctx->pix.width * ctx->pix.height) {
+		fimc_err("%s: shared buffer from %s does not fit %dx%d\n",
+			__func__, shared->exporter,
+			ctx->pix.width, ctx->pix.height);
+		s5p_media_buf_put(shared);
+		return -EINVAL;
+	}
+
+	for (i = 0; i < shared->nr_planes; i++)
+		addr[i] = shared->plane[i].paddr;
+
+	ret = fimc_update_in_queue_addr(ctrl, ctx, idx, addr);
+	if (ret < 0) {
+		s5p_media_buf_put(shared);
+		return ret;
+	}
+
+	fimc_outdev_put_shared_buf(ctx, idx);
+	ctx->src[idx].shared = shared;
+
+	return 0;
+}
+
 int fimc_qbuf_output(void *fh, struct v4l2_buffer *b)
 {
 	struct fimc_buf *buf = (struct fimc_buf *)b->m.userptr;
@@ -2048,7 +2331,12 @@ int fimc_qbuf_output(void *fh, struct v4l2_buffer *b)
 	}
 
 	if (b->memory == V4L2_MEMORY_USERPTR) {
-		ret = fimc_update_in_queue_addr(ctrl, ctx, b->index, buf->base);
+		if (b->flags & V4L2_BUF_FLAG_SHARED_FD)
+			ret = fimc_update_in_queue_shared(ctrl, ctx, b->index,
+							  (int)b->m.userptr);
+		else
+			ret = fimc_update_in_queue_addr(ctrl, ctx, b->index,
+							buf->base);
 		if (ret < 0)
 			return ret;
 	}
@@ -2057,12 +2345,15 @@ int fimc_qbuf_output(void *fh, struct v4l2_buffer *b)
 	ret = fimc_push_inq(ctrl, ctx, b->index);
 	if (ret < 0) {
 		fimc_err("Fail: fimc_push_inq\n");
+		fimc_outdev_put_shared_buf(ctx, b->index);
 		return -EINVAL;
 	}
 
 	if ((ctrl->status == FIMC_READY_ON) ||
 	    (ctrl->status == FIMC_STREAMON_IDLE)) {
-		ret = fimc_pop_inq(ctrl, &ctx_num, &idx);
+		ret = fimc_outdev_pop_inq(ctrl, &ctx_num, &idx, 1);
+		if (ret == -EAGAIN)	/* started by vsync or completion */
+			return 0;
 		if (ret < 0) {
 			fimc_err("Fail: fimc_pop_inq\n");
 			return -EINVAL;
@@ -2141,6 +2432,9 @@ int fimc_dqbuf_output(void *fh, struct v4l2_buffer *b)
 	}
 	mutex_unlock(&ctrl->lock);
 
+	/* FIMC has finished reading it, give it back to the exporter */
+	fimc_outdev_put_shared_buf(ctx, idx);
+
 	b->index = idx;
 
 	fimc_info2("ctx(%d) dqueued idx = %d\n", ctx->ctx_num, b->index);
@@ -108,7 +108,7 @@ static int fimc_s_ctrl(struct file *filp, void *fh, struct v4l2_control *c)
 	int ret = -1;
 
 	if (ctrl->cap != NULL) {
-		ret = fimc_s_ctrl_capture(fh, c);
+		ret = fimc_s_ctrl_capture(filp, fh, c);
 	} else if (ctrl->out != NULL) {
 		ret = fimc_s_ctrl_output(filp, fh, c);
 	} else {
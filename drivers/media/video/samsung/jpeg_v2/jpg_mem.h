@@ -16,6 +16,8 @@
 #include "jpg_misc.h"
 
 #include <linux/version.h>
+#include <linux/list.h>
+#include <linux/wait.h>
 #include <plat/media.h>
 #include <mach/media.h>
 
@@ -102,6 +104,19 @@ struct s5pc110_jpg_ctx {
 	int			caller_process;
 	struct jpegv2_limits	*limits;
 	struct jpegv2_buf	*bufinfo;
+
+	/*
+	 * Asynchronous requests, JPG_QUEUE_DEPTH deep:
+	 * [job_head, job_run) are done and not yet dequeued,
+	 * [job_run, job_tail) are waiting for the hardware.
+	 */
+	struct jpg_queue_job	*jobs;
+	unsigned int		job_head;
+	unsigned int		job_run;
+	unsigned int		job_tail;
+	int			job_seq;
+	struct list_head	run_list;
+	wait_queue_head_t	job_wait;
 };
 
 void *phy_to_vir_addr(unsigned int phy_addr, int mem_size);
@@ -144,6 +144,31 @@ struct jpg_args {
 	struct jpg_enc_proc_param	*thumb_enc_param;
 };
 
+enum jpg_queue_op {
+	JPG_QUEUE_DECODE,
+	JPG_QUEUE_ENCODE
+};
+
+/*
+ * One request for IOCTL_JPG_QUEUE. The stream (compressed data) and the
+ * frame (YCbCr image) are either s5p media buffer handles, used at the
+ * given offset into their first plane, or -1 for the driver's reserved
+ * buffer. enc_param.enc_type picks the main or thumbnail reserved area.
+ * IOCTL_JPG_DEQUEUE returns the request with the decoded/encoded sizes
+ * filled in, the JPG_SUCCESS/JPG_FAIL result and the sequence number.
+ */
+struct jpg_queue_args {
+	enum jpg_queue_op		op;
+	int				stream_fd;
+	unsigned int			stream_offset;
+	int				frame_fd;
+	unsigned int			frame_offset;
+	struct jpg_dec_proc_param	dec_param;
+	struct jpg_enc_proc_param	enc_param;
+	int				result;
+	int				seq;
+};
+
 void reset_jpg(struct s5pc110_jpg_ctx *jpg_ctx);
 enum jpg_return_status decode_jpg(struct s5pc110_jpg_ctx *jpg_ctx, \
 		struct jpg_dec_proc_param *dec_param);
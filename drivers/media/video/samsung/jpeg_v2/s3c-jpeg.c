@@ -38,10 +38,14 @@
 #include <linux/mm.h>
 #include <linux/platform_device.h>
 #include <linux/regulator/consumer.h>
+#include <linux/workqueue.h>
+#include <linux/spinlock.h>
+#include <linux/err.h>
 
 #include <linux/version.h>
 #include <plat/media.h>
 #include <plat/jpeg.h>
+#include <plat/media-buf.h>
 #include <mach/media.h>
 
 #include <linux/time.h>
@@ -125,6 +129,314 @@ irqreturn_t s3c_jpeg_irq(int irq, void *dev_id, struct pt_regs *regs)
 
 	return IRQ_HANDLED;
 }
+
+struct jpg_queue_job {
+	struct jpg_queue_args	args;
+	struct s5p_media_buf	*stream_buf;
+	struct s5p_media_buf	*frame_buf;
+};
+
+static struct workqueue_struct	*jpg_wq;
+static struct work_struct	jpg_work;
+static DEFINE_SPINLOCK(jpg_queue_lock);
+static LIST_HEAD(jpg_run_list);
+
+static bool jpg_queue_busy(struct s5pc110_jpg_ctx *jpg_reg_ctx)
+{
+	bool busy;
+
+	spin_lock(&jpg_queue_lock);
+	busy = jpg_reg_ctx->job_run != jpg_reg_ctx->job_tail;
+	spin_unlock(&jpg_queue_lock);
+
+	return busy;
+}
+
+static bool jpg_queue_done(struct s5pc110_jpg_ctx *jpg_reg_ctx)
+{
+	bool done;
+
+	spin_lock(&jpg_queue_lock);
+	done = jpg_reg_ctx->job_head != jpg_reg_ctx->job_run;
+	spin_unlock(&jpg_queue_lock);
+
+	return done;
+}
+
+static unsigned int jpg_queue_addr(struct s5p_media_buf *buf,
+				   unsigned int offset, unsigned int start)
+{
+	if (buf)
+		return buf->plane[0].paddr + offset;
+
+	return jpg_data_base_addr + start;
+}
+
+static void jpg_queue_run(struct s5pc110_jpg_ctx *jpg_reg_ctx,
+			  struct jpg_queue_job *job)
+{
+	struct s5pc110_jpg_ctx	hw_ctx;
+	struct jpegv2_buf	*bufinfo = jpg_reg_ctx->bufinfo;
+	struct jpg_queue_args	*args = &job->args;
+	unsigned int		stream_addr, frame_addr;
+	bool			thumb;
+
+	memset(&hw_ctx, 0x00, sizeof(hw_ctx));
+	hw_ctx.limits = jpg_reg_ctx->limits;
+	hw_ctx.bufinfo = bufinfo;
+
+	thumb = args->op == JPG_QUEUE_ENCODE &&
+		args->enc_param.enc_type == JPG_THUMBNAIL;
+
+	stream_addr = jpg_queue_addr(job->stream_buf, args->stream_offset,
+			thumb ? bufinfo->thumb_stream_start :
+				bufinfo->main_stream_start);
+	frame_addr = jpg_queue_addr(job->frame_buf, args->frame_offset,
+			thumb ? bufinfo->thumb_frame_start :
+				bufinfo->main_frame_start);
+
+	if (thumb) {
+		hw_ctx.jpg_thumb_data_addr = stream_addr;
+		hw_ctx.img_thumb_data_addr = frame_addr;
+	} else {
+		hw_ctx.jpg_data_addr = stream_addr;
+		hw_ctx.img_data_addr = frame_addr;
+	}
+
+	jpg_dbg("queue seq %d op %d stream 0x%08x frame 0x%08x\n",
+		args->seq, args->op, stream_addr, frame_addr);
+
+	lock_jpg_mutex();
+	jpeg_clock_enable();
+
+	if (args->op == JPG_QUEUE_DECODE)
+		args->result = decode_jpg(&hw_ctx, &args->dec_param);
+	else
+		args->result = encode_jpg(&hw_ctx, &args->enc_param);
+
+	jpeg_clock_disable();
+	unlock_jpg_mutex();
+
+	/* the hardware is done with the planes, let the exporter reuse them */
+	if (job->stream_buf)
+		s5p_media_buf_put(job->stream_buf);
+	if (job->frame_buf)
+		s5p_media_buf_put(job->frame_buf);
+	job->stream_buf = NULL;
+	job->frame_buf = NULL;
+}
+
+/*
+ * Run one request from each context with queued work in turn, so a
+ * burst capture cannot starve a thumbnail decode and vice versa.
+ */
+static void jpg_queue_work(struct work_struct *work)
+{
+	struct s5pc110_jpg_ctx	*jpg_reg_ctx;
+	struct jpg_queue_job	*job;
+
+	for (;;) {
+		spin_lock(&jpg_queue_lock);
+		if (list_empty(&jpg_run_list)) {
+			spin_unlock(&jpg_queue_lock);
+			break;
+		}
+
+		jpg_reg_ctx = list_first_entry(&jpg_run_list,
+					struct s5pc110_jpg_ctx, run_list);
+		list_del_init(&jpg_reg_ctx->run_list);
+		job = &jpg_reg_ctx->jobs[jpg_reg_ctx->job_run % JPG_QUEUE_DEPTH];
+		spin_unlock(&jpg_queue_lock);
+
+		jpg_queue_run(jpg_reg_ctx, job);
+
+		spin_lock(&jpg_queue_lock);
+		jpg_reg_ctx->job_run++;
+		if (jpg_reg_ctx->job_run != jpg_reg_ctx->job_tail &&
+		    list_empty(&jpg_reg_ctx->run_list))
+			list_add_tail(&jpg_reg_ctx->run_list, &jpg_run_list);
+		/* s3c_jpeg_release() may free the context once unlocked */
+		wake_up(&jpg_reg_ctx->job_wait);
+		spin_unlock(&jpg_queue_lock);
+	}
+}
+
+/*
+ * Take a reference on an imported buffer and make sure @size bytes at
+ * @offset fit in its first plane. fd < 0 selects the reserved buffer.
+ */
+static int jpg_queue_import(int fd, unsigned int offset, unsigned int size,
+			    struct s5p_media_buf **bufp)
+{
+	struct s5p_media_buf *buf;
+
+	*bufp = NULL;
+	if (fd < 0)
+		return 0;
+
+	buf = s5p_media_buf_get(fd);
+	if (IS_ERR(buf))
+		return PTR_ERR(buf);
+
+	if (offset >= buf->plane[0].size ||
+	    size > buf->plane[0].size - offset) {
+		jpg_err("%s buffer too small: %zu bytes at %u, need %u\n",
+			buf->exporter, buf->plane[0].size, offset, size);
+		s5p_media_buf_put(buf);
+		return -EINVAL;
+	}
+
+	*bufp = buf;
+
+	return 0;
+}
+
+static int jpg_queue_submit(struct s5pc110_jpg_ctx *jpg_reg_ctx,
+			    struct jpg_queue_args *args)
+{
+	struct jpegv2_limits	*limits = jpg_reg_ctx->limits;
+	struct s5p_media_buf	*stream_buf, *frame_buf;
+	struct jpg_queue_job	*job;
+	unsigned int		stream_size, frame_size;
+	int			ret;
+
+	switch (args->op) {
+	case JPG_QUEUE_DECODE:
+		/*
+		 * The output size is only known once the hardware has parsed
+		 * the header, so an imported frame must hold the largest image
+		 * the reserved buffer was sized for.
+		 */
+		stream_size = args->dec_param.file_size;
+		frame_size = jpg_reg_ctx->bufinfo->main_frame_size;
+		if (stream_size == 0 ||
+		    (args->stream_fd < 0 &&
+		     stream_size > jpg_reg_ctx->bufinfo->main_stream_size))
+			return -EINVAL;
+		break;
+
+	case JPG_QUEUE_ENCODE:
+		if (args->enc_param.width == 0 ||
+		    args->enc_param.width > limits->max_main_width ||
+		    args->enc_param.height == 0 ||
+		    args->enc_param.height > limits->max_main_height)
+			return -EINVAL;
+
+		/* same worst case as the reserved stream buffer */
+		stream_size = args->enc_param.width * args->enc_param.height;
+		frame_size = stream_size * 2;
+		break;
+
+	default:
+		return -EINVAL;
+	}
+
+	ret = jpg_queue_import(args->stream_fd, args->stream_offset,
+			       stream_size, &stream_buf);
+	if (ret < 0)
+		return ret;
+
+	ret = jpg_queue_import(args->frame_fd, args->frame_offset,
+			       frame_size, &frame_buf);
+	if (ret < 0) {
+		if (stream_buf)
+			s5p_media_buf_put(stream_buf);
+		return ret;
+	}
+
+	spin_lock(&jpg_queue_lock);
+
+	if (jpg_reg_ctx->job_tail - jpg_reg_ctx->job_head >= JPG_QUEUE_DEPTH) {
+		spin_unlock(&jpg_queue_lock);
+		if (stream_buf)
+			s5p_media_buf_put(stream_buf);
+		if (frame_buf)
+			s5p_media_buf_put(frame_buf);
+		return -EBUSY;
+	}
+
+	if (++jpg_reg_ctx->job_seq <= 0)
+		jpg_reg_ctx->job_seq = 1;
+	args->seq = jpg_reg_ctx->job_seq;
+	args->result = JPG_FAIL;
+
+	job = &jpg_reg_ctx->jobs[jpg_reg_ctx->job_tail % JPG_QUEUE_DEPTH];
+	job->args = *args;
+	job->stream_buf = stream_buf;
+	job->frame_buf = frame_buf;
+	jpg_reg_ctx->job_tail++;
+
+	if (list_empty(&jpg_reg_ctx->run_list))
+		list_add_tail(&jpg_reg_ctx->run_list, &jpg_run_list);
+
+	spin_unlock(&jpg_queue_lock);
+
+	queue_work(jpg_wq, &jpg_work);
+
+	return args->seq;
+}
+
+static int jpg_queue_collect(struct s5pc110_jpg_ctx *jpg_reg_ctx,
+			     struct jpg_queue_args *args, bool nonblock)
+{
+	struct jpg_queue_job	*job;
+	int			ret;
+
+	for (;;) {
+		spin_lock(&jpg_queue_lock);
+
+		if (jpg_reg_ctx->job_head == jpg_reg_ctx->job_tail) {
+			spin_unlock(&jpg_queue_lock);
+			return -ENODATA;
+		}
+
+		if (jpg_reg_ctx->job_head != jpg_reg_ctx->job_run) {
+			job = &jpg_reg_ctx->jobs[jpg_reg_ctx->job_head %
+						 JPG_QUEUE_DEPTH];
+			*args = job->args;
+			jpg_reg_ctx->job_head++;
+			spin_unlock(&jpg_queue_lock);
+			return args->seq;
+		}
+
+		spin_unlock(&jpg_queue_lock);
+
+		if (nonblock)
+			return -EAGAIN;
+
+		ret = wait_event_interruptible(jpg_reg_ctx->job_wait,
+					       jpg_queue_done(jpg_reg_ctx));
+		if (ret)
+			return ret;
+	}
+}
+
+/*
+ * The queue ioctls do not take the jpg mutex: the worker needs it to run
+ * the requests a blocking IOCTL_JPG_DEQUEUE is waiting for.
+ */
+static long jpg_queue_ioctl(struct file *file,
+			    struct s5pc110_jpg_ctx *jpg_reg_ctx,
+			    unsigned int cmd, unsigned long arg)
+{
+	struct jpg_queue_args	args;
+	int			ret;
+
+	if (copy_from_user(&args, (void __user *)arg, sizeof(args)))
+		return -EFAULT;
+
+	if (cmd == IOCTL_JPG_QUEUE)
+		ret = jpg_queue_submit(jpg_reg_ctx, &args);
+	else
+		ret = jpg_queue_collect(jpg_reg_ctx, &args,
+					file->f_flags & O_NONBLOCK);
+
+	if (ret > 0 && copy_to_user((void __user *)arg, &args, sizeof(args)))
+		return -EFAULT;
+
+	return ret;
+}
+
 static int s3c_jpeg_open(struct inode *inode, struct file *file)
 {
 	struct s5pc110_jpg_ctx *jpg_reg_ctx;
@@ -136,11 +448,22 @@ static int s3c_jpeg_open(struct inode *inode, struct file *file)
 		       mem_alloc(sizeof(struct s5pc110_jpg_ctx));
 	memset(jpg_reg_ctx, 0x00, sizeof(struct s5pc110_jpg_ctx));
 
+	jpg_reg_ctx->jobs = kcalloc(JPG_QUEUE_DEPTH,
+				    sizeof(struct jpg_queue_job), GFP_KERNEL);
+	if (jpg_reg_ctx->jobs == NULL) {
+		kfree(jpg_reg_ctx);
+		return -ENOMEM;
+	}
+
+	INIT_LIST_HEAD(&jpg_reg_ctx->run_list);
+	init_waitqueue_head(&jpg_reg_ctx->job_wait);
+
 	ret = lock_jpg_mutex();
 
 	if (!ret) {
 		jpg_err("JPG Mutex Lock Fail\r\n");
 		unlock_jpg_mutex();
+		kfree(jpg_reg_ctx->jobs);
 		kfree(jpg_reg_ctx);
 		return FALSE;
 	}
@@ -149,6 +472,7 @@ static int s3c_jpeg_open(struct inode *inode, struct file *file)
 		jpg_err("Instance Number error-JPEG is running, \
 				instance number is %d\n", instanceNo);
 		unlock_jpg_mutex();
+		kfree(jpg_reg_ctx->jobs);
 		kfree(jpg_reg_ctx);
 		return FALSE;
 	}
@@ -181,6 +505,9 @@ static int s3c_jpeg_release(struct inode *inode, struct file *file)
 		return FALSE;
 	}
 
+	/* let queued requests finish before the context goes away */
+	wait_event(jpg_reg_ctx->job_wait, !jpg_queue_busy(jpg_reg_ctx));
+
 	ret = lock_jpg_mutex();
 
 	if (!ret) {
@@ -192,6 +519,7 @@ static int s3c_jpeg_release(struct inode *inode, struct file *file)
 		instanceNo = 0;
 
 	unlock_jpg_mutex();
+	kfree(jpg_reg_ctx->jobs);
 	kfree(jpg_reg_ctx);
 
 	return 0;
@@ -226,6 +554,9 @@ static long s3c_jpeg_ioctl(struct file *file,
 		return FALSE;
 	}
 
+	if (cmd == IOCTL_JPG_QUEUE || cmd == IOCTL_JPG_DEQUEUE)
+		return jpg_queue_ioctl(file, jpg_reg_ctx, cmd, arg);
+
 	ret = lock_jpg_mutex();
 
 	if (!ret) {
@@ -334,11 +665,15 @@ static long s3c_jpeg_ioctl(struct file *file,
 
 static unsigned int s3c_jpeg_poll(struct file *file, poll_table *wait)
 {
+	struct s5pc110_jpg_ctx *jpg_reg_ctx = file->private_data;
 	unsigned int mask = 0;
 
 	jpg_dbg("enter poll\n");
 	poll_wait(file, &wait_queue_jpeg, wait);
+	poll_wait(file, &jpg_reg_ctx->job_wait, wait);
 	mask = POLLOUT | POLLWRNORM;
+	if (jpg_queue_done(jpg_reg_ctx))
+		mask |= POLLIN | POLLRDNORM;
 	return mask;
 }
 
@@ -527,6 +862,13 @@ static int s3c_jpeg_probe(struct platform_device *pdev)
 
 	init_waitqueue_head(&wait_queue_jpeg);
 
+	jpg_wq = create_freezable_workqueue("s3c-jpg");
+	if (jpg_wq == NULL) {
+		jpg_err("failed to create workqueue\n");
+		return -ENOMEM;
+	}
+	INIT_WORK(&jpg_work, jpg_queue_work);
+
 	jpg_dbg("JPG_Init\n");
 
 	/* Mutex initialization */
@@ -534,14 +876,16 @@ static int s3c_jpeg_probe(struct platform_device *pdev)
 
 	if (h_mutex == NULL) {
 		jpg_err("JPG Mutex Initialize error\r\n");
-		return FALSE;
+		ret = -ENOMEM;
+		goto err_destroy_wq;
 	}
 
 	ret = lock_jpg_mutex();
 
 	if (!ret) {
 		jpg_err("JPG Mutex Lock Fail\n");
-		return FALSE;
+		ret = -EBUSY;
+		goto err_destroy_wq;
 	}
 
 	instanceNo = 0;
@@ -549,8 +893,17 @@ static int s3c_jpeg_probe(struct platform_device *pdev)
 	unlock_jpg_mutex();
 
 	ret = misc_register(&s3c_jpeg_miscdev);
+	if (ret) {
+		jpg_err("failed to register misc device (%d)\n", ret);
+		goto err_destroy_wq;
+	}
 
 	return 0;
+
+err_destroy_wq:
+	destroy_workqueue(jpg_wq);
+	jpg_wq = NULL;
+	return ret;
 }
 
 static int s3c_jpeg_remove(struct platform_device *dev)
@@ -563,6 +916,7 @@ static int s3c_jpeg_remove(struct platform_device *dev)
 
 	free_irq(irq_no, dev);
 	misc_deregister(&s3c_jpeg_miscdev);
+	destroy_workqueue(jpg_wq);
 	return 0;
 }
 
@@ -17,6 +17,7 @@
 
 #define MAX_INSTANCE_NUM	1
 #define MAX_PROCESSING_THRESHOLD 1000	/* 1Sec */
+#define JPG_QUEUE_DEPTH		4
 
 #define JPEG_IOCTL_MAGIC 'J'
 
@@ -28,6 +29,8 @@
 #define IOCTL_JPG_GET_THUMB_FRMBUF		_IO(JPEG_IOCTL_MAGIC, 6)
 #define IOCTL_JPG_GET_PHY_FRMBUF		_IO(JPEG_IOCTL_MAGIC, 7)
 #define IOCTL_JPG_GET_PHY_THUMB_FRMBUF		_IO(JPEG_IOCTL_MAGIC, 8)
+#define IOCTL_JPG_QUEUE		_IOWR(JPEG_IOCTL_MAGIC, 9, struct jpg_queue_args)
+#define IOCTL_JPG_DEQUEUE	_IOWR(JPEG_IOCTL_MAGIC, 10, struct jpg_queue_args)
 #define JPG_CLOCK_DIVIDER_RATIO_QUARTER	4
 
 /* Driver Helper function */
@@ -30,6 +30,7 @@
 #include <linux/kernel.h>
 #include <linux/string.h>
 #include <linux/fs.h>
+#include <linux/file.h>
 #include <linux/mm.h>
 #include <linux/miscdevice.h>
 #include <linux/platform_device.h>
@@ -39,6 +40,11 @@
 #include <linux/slab.h>
 #include <linux/clk.h>
 #include <linux/dma-mapping.h>
+#include <linux/workqueue.h>
+#include <linux/poll.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/math64.h>
 
 #include <linux/sched.h>
 #include <linux/firmware.h>
@@ -49,6 +55,7 @@
 #include <plat/media.h>
 #include <mach/media.h>
 #include <plat/mfc.h>
+#include <plat/media-buf.h>
 #ifdef CONFIG_DVFS_LIMIT
 #include <mach/cpu-freq-v210.h>
 #endif
@@ -68,6 +75,248 @@ static struct clk *mfc_sclk;
 static struct regulator *mfc_pd_regulator;
 const struct firmware	*mfc_fw_info;
 
+static struct workqueue_struct *mfc_wq;
+static struct work_struct mfc_work;
+static DEFINE_SPINLOCK(mfc_queue_lock);
+static LIST_HEAD(mfc_run_list);
+static LIST_HEAD(mfc_inst_list);
+#ifdef CONFIG_DEBUG_FS
+static struct dentry *mfc_debugfs_dir;
+#endif
+
+static void mfc_account_frame(struct mfc_inst_ctx *mfc_ctx, ktime_t queued,
+			      ktime_t start, int ret_code)
+{
+	struct mfc_inst_stats *stats = &mfc_ctx->stats;
+	ktime_t now = ktime_get();
+	unsigned int latency_us = (unsigned int)ktime_us_delta(now, queued);
+	s64 window_us;
+
+	spin_lock(&mfc_queue_lock);
+
+	stats->frames++;
+	if (ret_code < 0)
+		stats->errors++;
+
+	stats->latency_total_us += latency_us;
+	if (latency_us > stats->latency_max_us)
+		stats->latency_max_us = latency_us;
+	stats->hw_total_us += ktime_us_delta(now, start);
+
+	/* fps over windows of at least one second */
+	if (stats->window_frames++ == 0)
+		stats->window_start = start;
+
+	window_us = ktime_us_delta(now, stats->window_start);
+	if (window_us >= USEC_PER_SEC) {
+		stats->fps_x10 = div_u64((u64)stats->window_frames * 10 * USEC_PER_SEC,
+					 (u32)window_us);
+		stats->window_frames = 0;
+	}
+
+	spin_unlock(&mfc_queue_lock);
+}
+
+static bool mfc_queue_busy(struct mfc_inst_ctx *mfc_ctx)
+{
+	bool busy;
+
+	spin_lock(&mfc_queue_lock);
+	busy = mfc_ctx->job_run != mfc_ctx->job_tail;
+	spin_unlock(&mfc_queue_lock);
+
+	return busy;
+}
+
+static bool mfc_queue_done(struct mfc_inst_ctx *mfc_ctx)
+{
+	bool done;
+
+	spin_lock(&mfc_queue_lock);
+	done = mfc_ctx->job_head != mfc_ctx->job_run;
+	spin_unlock(&mfc_queue_lock);
+
+	return done;
+}
+
+static void mfc_run_job(struct mfc_inst_ctx *mfc_ctx, struct mfc_queue_job *job)
+{
+	ktime_t start;
+
+	mutex_lock(&mfc_mutex);
+	clk_enable(mfc_sclk);
+
+	start = ktime_get();
+	if (job->cmd == IOCTL_MFC_DEC_EXE_ASYNC)
+		job->param.ret_code = mfc_exe_decode(mfc_ctx, &job->param.args);
+	else
+		job->param.ret_code = mfc_exe_encode(mfc_ctx, &job->param.args);
+
+	clk_disable(mfc_sclk);
+	mutex_unlock(&mfc_mutex);
+
+	mfc_account_frame(mfc_ctx, job->queued, start, job->param.ret_code);
+}
+
+/*
+ * Run one command from each instance with queued work in turn, so a
+ * long-running stream cannot starve the others.
+ */
+static void mfc_queue_work(struct work_struct *work)
+{
+	struct mfc_inst_ctx *mfc_ctx;
+	struct mfc_queue_job *job;
+
+	for (;;) {
+		spin_lock(&mfc_queue_lock);
+		if (list_empty(&mfc_run_list)) {
+			spin_unlock(&mfc_queue_lock);
+			break;
+		}
+
+		mfc_ctx = list_first_entry(&mfc_run_list, struct mfc_inst_ctx, run_list);
+		list_del_init(&mfc_ctx->run_list);
+		job = &mfc_ctx->jobs[mfc_ctx->job_run % MFC_QUEUE_DEPTH];
+		spin_unlock(&mfc_queue_lock);
+
+		mfc_run_job(mfc_ctx, job);
+
+		spin_lock(&mfc_queue_lock);
+		mfc_ctx->job_run++;
+		if (mfc_ctx->job_run != mfc_ctx->job_tail && list_empty(&mfc_ctx->run_list))
+			list_add_tail(&mfc_ctx->run_list, &mfc_run_list);
+		/* mfc_release() may free the context once the lock is dropped */
+		wake_up(&mfc_ctx->job_wait);
+		spin_unlock(&mfc_queue_lock);
+	}
+}
+
+static int mfc_queue_submit(struct mfc_inst_ctx *mfc_ctx, unsigned int cmd,
+			    struct mfc_common_args *param)
+{
+	struct mfc_queue_job *job;
+	int seq;
+
+	spin_lock(&mfc_queue_lock);
+
+	if (mfc_ctx->job_tail - mfc_ctx->job_head >= MFC_QUEUE_DEPTH) {
+		spin_unlock(&mfc_queue_lock);
+		return -EBUSY;
+	}
+
+	if (++mfc_ctx->job_seq <= 0)
+		mfc_ctx->job_seq = 1;
+	seq = mfc_ctx->job_seq;
+
+	job = &mfc_ctx->jobs[mfc_ctx->job_tail % MFC_QUEUE_DEPTH];
+	job->cmd = cmd;
+	job->seq = seq;
+	job->queued = ktime_get();
+	job->param = *param;
+	mfc_ctx->job_tail++;
+
+	if (list_empty(&mfc_ctx->run_list))
+		list_add_tail(&mfc_ctx->run_list, &mfc_run_list);
+
+	spin_unlock(&mfc_queue_lock);
+
+	queue_work(mfc_wq, &mfc_work);
+
+	return seq;
+}
+
+static int mfc_queue_collect(struct mfc_inst_ctx *mfc_ctx,
+			     struct mfc_common_args *param, bool nonblock)
+{
+	struct mfc_queue_job *job;
+	int ret;
+
+	for (;;) {
+		spin_lock(&mfc_queue_lock);
+
+		if (mfc_ctx->job_head == mfc_ctx->job_tail) {
+			spin_unlock(&mfc_queue_lock);
+			return -ENODATA;
+		}
+
+		if (mfc_ctx->job_head != mfc_ctx->job_run) {
+			job = &mfc_ctx->jobs[mfc_ctx->job_head % MFC_QUEUE_DEPTH];
+			*param = job->param;
+			ret = job->seq;
+			mfc_ctx->job_head++;
+			spin_unlock(&mfc_queue_lock);
+			return ret;
+		}
+
+		spin_unlock(&mfc_queue_lock);
+
+		if (nonblock)
+			return -EAGAIN;
+
+		ret = wait_event_interruptible(mfc_ctx->job_wait, mfc_queue_done(mfc_ctx));
+		if (ret)
+			return ret;
+	}
+}
+
+#ifdef CONFIG_DEBUG_FS
+static int mfc_stats_show(struct seq_file *s, void *unused)
+{
+	struct mfc_inst_ctx *mfc_ctx;
+	struct mfc_inst_stats *stats;
+
+	spin_lock(&mfc_queue_lock);
+	list_for_each_entry(mfc_ctx, &mfc_inst_list, inst_list) {
+		stats = &mfc_ctx->stats;
+		seq_printf(s, "inst %d codec %d state %d queued %u frames %u errors %u "
+			   "fps %u.%u latency avg %lluus max %uus hw avg %lluus\n",
+			   mfc_ctx->InstNo, mfc_ctx->MfcCodecType, mfc_ctx->MfcState,
+			   mfc_ctx->job_tail - mfc_ctx->job_run,
+			   stats->frames, stats->errors,
+			   stats->fps_x10 / 10, stats->fps_x10 % 10,
+			   stats->frames ? div_u64(stats->latency_total_us, stats->frames) : 0,
+			   stats->latency_max_us,
+			   stats->frames ? div_u64(stats->hw_total_us, stats->frames) : 0);
+	}
+	spin_unlock(&mfc_queue_lock);
+
+	return 0;
+}
+
+static int mfc_buffers_show(struct seq_file *s, void *unused)
+{
+	mutex_lock(&mfc_mutex);
+	mfc_print_fragmentation(s);
+	mutex_unlock(&mfc_mutex);
+
+	return 0;
+}
+
+static int mfc_buffers_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, mfc_buffers_show, inode->i_private);
+}
+
+static const struct file_operations mfc_buffers_fops = {
+	.open		= mfc_buffers_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int mfc_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, mfc_stats_show, inode->i_private);
+}
+
+static const struct file_operations mfc_stats_fops = {
+	.open		= mfc_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+#endif
+
 static int mfc_open(struct inode *inode, struct file *file)
 {
 	struct mfc_inst_ctx *mfc_ctx;
@@ -127,6 +376,13 @@ static int mfc_open(struct inode *inode, struct file *file)
 	mfc_ctx->extraDPB = MFC_MAX_EXTRA_DPB;
 	mfc_ctx->FrameType = MFC_RET_FRAME_NOT_SET;
 
+	INIT_LIST_HEAD(&mfc_ctx->run_list);
+	init_waitqueue_head(&mfc_ctx->job_wait);
+
+	spin_lock(&mfc_queue_lock);
+	list_add_tail(&mfc_ctx->inst_list, &mfc_inst_list);
+	spin_unlock(&mfc_queue_lock);
+
 	file->private_data = mfc_ctx;
 
 	mutex_unlock(&mfc_mutex);
@@ -156,11 +412,27 @@ err_open:
 static int mfc_release(struct inode *inode, struct file *file)
 {
 	struct mfc_inst_ctx *mfc_ctx;
-	int ret;
+	int ret, i;
+
+	mfc_ctx = (struct mfc_inst_ctx *)file->private_data;
+	if (mfc_ctx != NULL) {
+		/* let queued commands finish before the instance goes away */
+		wait_event(mfc_ctx->job_wait, !mfc_queue_busy(mfc_ctx));
+
+		spin_lock(&mfc_queue_lock);
+		list_del(&mfc_ctx->inst_list);
+		spin_unlock(&mfc_queue_lock);
+
+		/* outside mfc_mutex, the exporter's release may take it */
+		for (i = 0; i < MFC_MAX_IMPORT_BUF; i++) {
+			if (mfc_ctx->import_buf[i])
+				s5p_media_buf_put(mfc_ctx->import_buf[i]);
+			mfc_ctx->import_buf[i] = NULL;
+		}
+	}
 
 	mutex_lock(&mfc_mutex);
 
-	mfc_ctx = (struct mfc_inst_ctx *)file->private_data;
 	if (mfc_ctx == NULL) {
 		mfc_err("MFCINST_ERR_INVALID_PARAM\n");
 		ret = -EIO;
@@ -201,11 +473,175 @@ out_release:
 	return ret;
 }
 
+struct mfc_shared_buf {
+	struct s5p_media_buf buf;
+	struct file *mfc_file;
+	int inst_no;
+};
+
+static void mfc_shared_buf_release(struct s5p_media_buf *buf)
+{
+	struct mfc_shared_buf *shared = container_of(buf, struct mfc_shared_buf, buf);
+	unsigned int i;
+
+	mutex_lock(&mfc_mutex);
+	for (i = 0; i < buf->nr_planes; i++)
+		mfc_unexport_buffer(shared->inst_no, buf->plane[i].paddr);
+	mutex_unlock(&mfc_mutex);
+
+	/* may be the last reference, which releases the instance */
+	fput(shared->mfc_file);
+	kfree(shared);
+}
+
+/* called with mfc_mutex held */
+static enum mfc_error_code mfc_export_buf(struct file *file, struct mfc_inst_ctx *mfc_ctx,
+					  struct mfc_export_buf_arg *export_arg)
+{
+	struct mfc_shared_buf *shared;
+	struct s5p_media_buf *buf;
+	unsigned int i, size;
+	int fd;
+
+	shared = kzalloc(sizeof(struct mfc_shared_buf), GFP_KERNEL);
+	if (!shared)
+		return MFCINST_MEMORY_ALLOC_FAIL;
+
+	shared->inst_no = mfc_ctx->mem_inst_no;
+	buf = &shared->buf;
+
+	for (i = 0; i < ARRAY_SIZE(export_arg->in_paddr); i++) {
+		if (!export_arg->in_paddr[i])
+			continue;
+
+		size = mfc_export_buffer(shared->inst_no, export_arg->in_paddr[i]);
+		if (!size)
+			goto err_unexport;
+
+		buf->plane[buf->nr_planes].paddr = export_arg->in_paddr[i];
+		buf->plane[buf->nr_planes].size = size;
+		buf->nr_planes++;
+	}
+
+	if (!buf->nr_planes) {
+		kfree(shared);
+		return MFCINST_ERR_INVALID_PARAM;
+	}
+
+	buf->exporter = "mfc50";
+	buf->cpu_cached = (mfc_ctx->buf_type == MFC_BUFFER_CACHE);
+	buf->release = mfc_shared_buf_release;
+
+	/* the instance must outlive every handle to its buffers */
+	get_file(file);
+	shared->mfc_file = file;
+
+	fd = s5p_media_buf_export(buf);
+	if (fd < 0) {
+		mfc_err("failed to export buffer(%d)\n", fd);
+		fput(file);
+		goto err_unexport;
+	}
+
+	export_arg->out_fd = fd;
+
+	return MFCINST_RET_OK;
+
+err_unexport:
+	for (i = 0; i < buf->nr_planes; i++)
+		mfc_unexport_buffer(shared->inst_no, buf->plane[i].paddr);
+	kfree(shared);
+
+	return MFCINST_MEMORY_INVALID_ADDR;
+}
+
+/*
+ * Called with mfc_mutex held. Any reference to drop is returned in *drop
+ * and must be put after unlocking, since the exporter's release may need
+ * mfc_mutex itself.
+ */
+static enum mfc_error_code mfc_import_buf(struct mfc_inst_ctx *mfc_ctx,
+					  struct mfc_import_buf_arg *import_arg,
+					  struct s5p_media_buf **drop)
+{
+	struct s5p_media_buf *buf;
+	unsigned int i, slot = MFC_MAX_IMPORT_BUF;
+
+	buf = s5p_media_buf_get(import_arg->in_fd);
+	if (IS_ERR(buf)) {
+		mfc_err("invalid shared buffer fd(%d)\n", import_arg->in_fd);
+		return MFCINST_ERR_INVALID_PARAM;
+	}
+
+	*drop = buf;
+
+	/* frame addresses are programmed as 2KB units from the port1 base */
+	for (i = 0; i < buf->nr_planes && i < 2; i++) {
+		if (buf->plane[i].paddr < mfc_port1_base_paddr ||
+		    buf->plane[i].paddr != ALIGN_TO_2KB(buf->plane[i].paddr)) {
+			mfc_err("%s plane %d(0x%08x) is not addressable\n",
+				buf->exporter, i, buf->plane[i].paddr);
+			return MFCINST_MEMORY_INVALID_ADDR;
+		}
+	}
+
+	for (i = 0; i < MFC_MAX_IMPORT_BUF; i++) {
+		if (mfc_ctx->import_buf[i] == buf) {
+			slot = i;
+			break;
+		}
+		if (!mfc_ctx->import_buf[i] && slot == MFC_MAX_IMPORT_BUF)
+			slot = i;
+	}
+
+	if (slot == MFC_MAX_IMPORT_BUF) {
+		mfc_err("too many imported buffers\n");
+		return MFCINST_MEMORY_ALLOC_FAIL;
+	}
+
+	/* keep the new reference unless the buffer is already held */
+	if (!mfc_ctx->import_buf[slot]) {
+		mfc_ctx->import_buf[slot] = buf;
+		*drop = NULL;
+	}
+
+	import_arg->Y_paddr = buf->plane[0].paddr;
+	import_arg->C_paddr = (buf->nr_planes > 1) ? buf->plane[1].paddr : 0;
+
+	return MFCINST_RET_OK;
+}
+
+/* called with mfc_mutex held, see mfc_import_buf() for *drop */
+static enum mfc_error_code mfc_unimport_buf(struct mfc_inst_ctx *mfc_ctx,
+					    struct mfc_import_buf_arg *import_arg,
+					    struct s5p_media_buf **drop)
+{
+	unsigned int i;
+
+	/* queued frames may still read it */
+	if (mfc_queue_busy(mfc_ctx))
+		return MFCINST_MEMORY_BUSY;
+
+	for (i = 0; i < MFC_MAX_IMPORT_BUF; i++) {
+		if (mfc_ctx->import_buf[i] &&
+		    mfc_ctx->import_buf[i]->plane[0].paddr == import_arg->Y_paddr) {
+			*drop = mfc_ctx->import_buf[i];
+			mfc_ctx->import_buf[i] = NULL;
+			return MFCINST_RET_OK;
+		}
+	}
+
+	return MFCINST_MEMORY_INVALID_ADDR;
+}
+
 static long mfc_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 {
 	int ret, ex_ret;
 	struct mfc_inst_ctx *mfc_ctx = NULL;
 	struct mfc_common_args in_param;
+	struct s5p_media_buf *drop = NULL;
+	enum mfc_inst_state min_state, exe_state;
+	ktime_t start;
 
 	mutex_lock(&mfc_mutex);
 	clk_enable(mfc_sclk);
@@ -249,6 +685,14 @@ static long mfc_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 			break;
 		}
 
+		if (mfc_queue_busy(mfc_ctx)) {
+			mfc_err("MFCINST_ERR_STATE_INVALID: async commands pending\n");
+			in_param.ret_code = MFCINST_ERR_STATE_INVALID;
+			ret = -EBUSY;
+			mutex_unlock(&mfc_mutex);
+			break;
+		}
+
 		if (mfc_set_state(mfc_ctx, MFCINST_STATE_ENC_EXE) < 0) {
 			mfc_err("MFCINST_ERR_STATE_INVALID\n");
 			in_param.ret_code = MFCINST_ERR_STATE_INVALID;
@@ -257,9 +701,11 @@ static long mfc_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 			break;
 		}
 
+		start = ktime_get();
 		in_param.ret_code = mfc_exe_encode(mfc_ctx, &(in_param.args));
 		ret = in_param.ret_code;
 		mutex_unlock(&mfc_mutex);
+		mfc_account_frame(mfc_ctx, start, start, ret);
 		break;
 
 	case IOCTL_MFC_DEC_INIT:
@@ -299,6 +745,14 @@ static long mfc_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 			break;
 		}
 
+		if (mfc_queue_busy(mfc_ctx)) {
+			mfc_err("MFCINST_ERR_STATE_INVALID: async commands pending\n");
+			in_param.ret_code = MFCINST_ERR_STATE_INVALID;
+			ret = -EBUSY;
+			mutex_unlock(&mfc_mutex);
+			break;
+		}
+
 		if (mfc_set_state(mfc_ctx, MFCINST_STATE_DEC_EXE) < 0) {
 			mfc_err("MFCINST_ERR_STATE_INVALID\n");
 			in_param.ret_code = MFCINST_ERR_STATE_INVALID;
@@ -307,9 +761,42 @@ static long mfc_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 			break;
 		}
 
+		start = ktime_get();
 		in_param.ret_code = mfc_exe_decode(mfc_ctx, &(in_param.args));
 		ret = in_param.ret_code;
 		mutex_unlock(&mfc_mutex);
+		mfc_account_frame(mfc_ctx, start, start, ret);
+		break;
+
+	case IOCTL_MFC_DEC_EXE_ASYNC:
+	case IOCTL_MFC_ENC_EXE_ASYNC:
+		mutex_lock(&mfc_mutex);
+		if (cmd == IOCTL_MFC_DEC_EXE_ASYNC) {
+			min_state = MFCINST_STATE_DEC_INITIALIZE;
+			exe_state = MFCINST_STATE_DEC_EXE;
+		} else {
+			min_state = MFCINST_STATE_ENC_INITIALIZE;
+			exe_state = MFCINST_STATE_ENC_EXE;
+		}
+
+		if ((mfc_ctx->MfcState < min_state) ||
+				(mfc_set_state(mfc_ctx, exe_state) < 0)) {
+			mfc_err("MFCINST_ERR_STATE_INVALID\n");
+			in_param.ret_code = MFCINST_ERR_STATE_INVALID;
+			ret = -EINVAL;
+			mutex_unlock(&mfc_mutex);
+			break;
+		}
+		mutex_unlock(&mfc_mutex);
+
+		ret = mfc_queue_submit(mfc_ctx, cmd, &in_param);
+		in_param.ret_code = (ret < 0) ? MFCINST_ERR_STATE_INVALID : MFCINST_RET_OK;
+		break;
+
+	case IOCTL_MFC_WAIT_DONE:
+		ret = mfc_queue_collect(mfc_ctx, &in_param, file->f_flags & O_NONBLOCK);
+		if (ret < 0)
+			in_param.ret_code = MFCINST_ERR_STATE_INVALID;
 		break;
 
 	case IOCTL_MFC_GET_CONFIG:
@@ -329,6 +816,14 @@ static long mfc_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 
 	case IOCTL_MFC_SET_CONFIG:
 		mutex_lock(&mfc_mutex);
+		if (mfc_queue_busy(mfc_ctx)) {
+			mfc_err("MFCINST_ERR_STATE_INVALID: async commands pending\n");
+			in_param.ret_code = MFCINST_ERR_STATE_INVALID;
+			ret = -EBUSY;
+			mutex_unlock(&mfc_mutex);
+			break;
+		}
+
 		in_param.ret_code = mfc_set_config(mfc_ctx, &(in_param.args));
 		ret = in_param.ret_code;
 		mutex_unlock(&mfc_mutex);
@@ -404,6 +899,45 @@ static long mfc_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 		mutex_unlock(&mfc_mutex);
 		break;
 
+	case IOCTL_MFC_EXPORT_BUF:
+		mutex_lock(&mfc_mutex);
+		if (mfc_ctx->MfcState < MFCINST_STATE_OPENED) {
+			mfc_err("MFCINST_ERR_STATE_INVALID\n");
+			in_param.ret_code = MFCINST_ERR_STATE_INVALID;
+			ret = -EINVAL;
+			mutex_unlock(&mfc_mutex);
+			break;
+		}
+
+		in_param.ret_code = mfc_export_buf(file, mfc_ctx, &(in_param.args.export_buf));
+		ret = in_param.ret_code;
+		mutex_unlock(&mfc_mutex);
+		break;
+
+	case IOCTL_MFC_IMPORT_BUF:
+	case IOCTL_MFC_UNIMPORT_BUF:
+		mutex_lock(&mfc_mutex);
+		if (mfc_ctx->MfcState < MFCINST_STATE_OPENED) {
+			mfc_err("MFCINST_ERR_STATE_INVALID\n");
+			in_param.ret_code = MFCINST_ERR_STATE_INVALID;
+			ret = -EINVAL;
+			mutex_unlock(&mfc_mutex);
+			break;
+		}
+
+		if (cmd == IOCTL_MFC_IMPORT_BUF)
+			in_param.ret_code = mfc_import_buf(mfc_ctx,
+					&(in_param.args.import_buf), &drop);
+		else
+			in_param.ret_code = mfc_unimport_buf(mfc_ctx,
+					&(in_param.args.import_buf), &drop);
+		ret = in_param.ret_code;
+		mutex_unlock(&mfc_mutex);
+
+		if (drop)
+			s5p_media_buf_put(drop);
+		break;
+
 	case IOCTL_MFC_GET_MMAP_SIZE:
 
 		if (mfc_ctx->MfcState < MFCINST_STATE_OPENED) {
@@ -506,11 +1040,21 @@ static int mfc_mmap(struct file *filp, struct vm_area_struct *vma)
 	return 0;
 }
 
+static unsigned int mfc_poll(struct file *file, poll_table *wait)
+{
+	struct mfc_inst_ctx *mfc_ctx = (struct mfc_inst_ctx *)file->private_data;
+
+	poll_wait(file, &mfc_ctx->job_wait, wait);
+
+	return mfc_queue_done(mfc_ctx) ? POLLIN | POLLRDNORM : 0;
+}
+
 static const struct file_operations mfc_fops = {
 	.owner      = THIS_MODULE,
 	.open       = mfc_open,
 	.release    = mfc_release,
 	.unlocked_ioctl = mfc_ioctl,
+	.poll       = mfc_poll,
 	.mmap       = mfc_mmap
 };
 
@@ -651,12 +1195,30 @@ static int mfc_probe(struct platform_device *pdev)
 	mfc_init_mem_inst_no();
 	mfc_init_buffer();
 
+	mfc_wq = create_freezable_workqueue("mfc");
+	if (mfc_wq == NULL) {
+		mfc_err("failed to create mfc workqueue\n");
+		ret = -ENOMEM;
+		goto err_wq;
+	}
+	INIT_WORK(&mfc_work, mfc_queue_work);
+
 	ret = misc_register(&mfc_miscdev);
 	if (ret) {
 		mfc_err("MFC can't misc register on minor\n");
 		goto err_misc_reg;
 	}
 
+#ifdef CONFIG_DEBUG_FS
+	mfc_debugfs_dir = debugfs_create_dir("mfc50", NULL);
+	if (!IS_ERR_OR_NULL(mfc_debugfs_dir)) {
+		debugfs_create_file("instances", S_IRUGO, mfc_debugfs_dir,
+				    NULL, &mfc_stats_fops);
+		debugfs_create_file("buffers", S_IRUGO, mfc_debugfs_dir,
+				    NULL, &mfc_buffers_fops);
+	}
+#endif
+
 	/*
 	 * MFC FW downloading
 	 */
@@ -676,8 +1238,13 @@ static int mfc_probe(struct platform_device *pdev)
 	return 0;
 
 err_req_fw:
+#ifdef CONFIG_DEBUG_FS
+	debugfs_remove_recursive(mfc_debugfs_dir);
+#endif
 	misc_deregister(&mfc_miscdev);
 err_misc_reg:
+	destroy_workqueue(mfc_wq);
+err_wq:
 	clk_put(mfc_sclk);
 err_clk_get:
 	regulator_put(mfc_pd_regulator);
@@ -714,7 +1281,11 @@ static int mfc_remove(struct platform_device *pdev)
 
 	clk_put(mfc_sclk);
 
+#ifdef CONFIG_DEBUG_FS
+	debugfs_remove_recursive(mfc_debugfs_dir);
+#endif
 	misc_deregister(&mfc_miscdev);
+	destroy_workqueue(mfc_wq);
 
 	if (mfc_fw_info)
 		release_firmware(mfc_fw_info);
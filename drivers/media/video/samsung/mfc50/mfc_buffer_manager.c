@@ -29,6 +29,8 @@
 #include <linux/mutex.h>
 #include <linux/slab.h>
 #include <linux/types.h>
+#include <linux/seq_file.h>
+#include <linux/math64.h>
 
 #include <linux/io.h>
 #include <linux/uaccess.h>
@@ -41,8 +43,24 @@
 #include "mfc_logmsg.h"
 #include "mfc_memory.h"
 
+/*
+ * Buffers below this size (contexts, shared memory, MV and codec buffers)
+ * are carved from the top of the free chunk they land in, large ones (CPB,
+ * DPB) from the bottom, so that short-lived small buffers don't split the
+ * space the next resolution's frame buffers need.
+ */
+#define MFC_SMALL_BUF_SIZE	(1024 * 1024)
+
+struct mfc_buffer_stats {
+	unsigned int allocs;
+	unsigned int alloc_fails;
+	unsigned int used;
+	unsigned int peak_used;
+};
+
 static struct list_head mfc_alloc_mem_head[MFC_MAX_PORT_NUM];
 static struct list_head mfc_free_mem_head[MFC_MAX_PORT_NUM];
+static struct mfc_buffer_stats mfc_buffer_stats[MFC_MAX_PORT_NUM];
 
 void mfc_print_mem_list(void)
 {
@@ -82,6 +100,9 @@ void mfc_merge_fragment(int inst_no)
 	for (port_no = 0; port_no < MFC_MAX_PORT_NUM; port_no++) {
 		list_for_each_safe(pos, n, &mfc_free_mem_head[port_no])
 		{
+			if (n == &mfc_free_mem_head[port_no])
+				break;
+
 			node1 = list_entry(pos, struct mfc_free_mem, list);
 			node2 = list_entry(n, struct mfc_free_mem, list);
 			if ((node1->start_addr + node1->size) == node2->start_addr) {
@@ -100,11 +121,30 @@ void mfc_merge_fragment(int inst_no)
 
 
 
+static void mfc_get_free_mem_info(int port_no, unsigned int *total,
+				  unsigned int *largest, unsigned int *chunks)
+{
+	struct mfc_free_mem *free_node;
+
+	*total = 0;
+	*largest = 0;
+	*chunks = 0;
+
+	list_for_each_entry(free_node, &mfc_free_mem_head[port_no], list) {
+		*total += free_node->size;
+		if (free_node->size > *largest)
+			*largest = free_node->size;
+		(*chunks)++;
+	}
+}
+
 static unsigned int mfc_get_free_mem(int alloc_size, int inst_no, int port_no)
 {
 	struct list_head *pos;
 	struct mfc_free_mem *free_node, *match_node = NULL;
 	unsigned int alloc_addr = 0;
+	unsigned int total, largest, chunks;
+	bool small = alloc_size < MFC_SMALL_BUF_SIZE;
 
 	mfc_debug("request Size : %d\n", alloc_size);
 
@@ -112,45 +152,83 @@ static unsigned int mfc_get_free_mem(int alloc_size, int inst_no, int port_no)
 		mfc_err("all memory is gone\n");
 		return alloc_addr;
 	}
-	/* find best chunk of memory */
+	/*
+	 * find best chunk of memory; among equal fits prefer the highest one
+	 * for small buffers and the lowest one for large buffers
+	 */
 	list_for_each(pos, &mfc_free_mem_head[port_no])
 	{
 		free_node = list_entry(pos, struct mfc_free_mem, list);
 
-		if (match_node != NULL) {
-			if ((free_node->size >= alloc_size) &&
-				(free_node->size < match_node->size))
-				match_node = free_node;
-		} else {
-			if (free_node->size >= alloc_size)
-				match_node = free_node;
-		}
+		if (free_node->size < alloc_size)
+			continue;
+
+		if ((match_node == NULL) ||
+			(free_node->size < match_node->size) ||
+			(small && (free_node->size == match_node->size)))
+			match_node = free_node;
 	}
 
 
 	if (match_node != NULL) {
 		mfc_debug("match : startAddr(0x%08x) size(%d)\n", match_node->start_addr, match_node->size);
 
-		alloc_addr = match_node->start_addr;
-		match_node->start_addr += alloc_size;
+		if (small) {
+			alloc_addr = match_node->start_addr + match_node->size - alloc_size;
+		} else {
+			alloc_addr = match_node->start_addr;
+			match_node->start_addr += alloc_size;
+		}
 		match_node->size -= alloc_size;
 
-		if (match_node->size < 0x1)	/* delete match_node. */
-			mfc_err("there is no suitable chunk...[case 0]\n");
+		if (match_node->size == 0) {
+			list_del(&(match_node->list));
+			kfree(match_node);
+		}
 	} else {
-		mfc_err("there is no suitable chunk....[case 1]\n");
+		mfc_get_free_mem_info(port_no, &total, &largest, &chunks);
+		mfc_err("there is no suitable chunk: port%d request %d, "
+			"free %u in %u chunks, largest %u\n",
+			port_no, alloc_size, total, chunks, largest);
 		return 0;
 	}
 
 	return alloc_addr;
 }
 
+void mfc_print_fragmentation(struct seq_file *s)
+{
+	struct mfc_alloc_mem *alloc_node;
+	struct mfc_buffer_stats *stats;
+	unsigned int total, largest, chunks;
+	int port_no;
+
+	for (port_no = 0; port_no < MFC_MAX_PORT_NUM; port_no++) {
+		stats = &mfc_buffer_stats[port_no];
+		mfc_get_free_mem_info(port_no, &total, &largest, &chunks);
+
+		seq_printf(s, "port%d: used %u peak %u free %u in %u chunks, "
+			   "largest %u, fragmentation %u%%\n",
+			   port_no, stats->used, stats->peak_used, total, chunks,
+			   largest, total ? 100 - (unsigned int)div_u64((u64)largest * 100, total) : 0);
+		seq_printf(s, "port%d: allocs %u failed %u\n",
+			   port_no, stats->allocs, stats->alloc_fails);
+
+		list_for_each_entry(alloc_node, &mfc_alloc_mem_head[port_no], list)
+			seq_printf(s, "  inst %d p_addr 0x%08x size %d\n",
+				   alloc_node->inst_no, alloc_node->p_addr,
+				   alloc_node->size);
+	}
+}
+
 
 int mfc_init_buffer(void)
 {
 	struct mfc_free_mem *free_node;
 	int	port_no;
 
+	memset(mfc_buffer_stats, 0, sizeof(mfc_buffer_stats));
+
 	for (port_no = 0; port_no < MFC_MAX_PORT_NUM; port_no++) {
 		INIT_LIST_HEAD(&mfc_alloc_mem_head[port_no]);
 		INIT_LIST_HEAD(&mfc_free_mem_head[port_no]);
@@ -189,6 +267,11 @@ enum mfc_error_code mfc_release_buffer(unsigned char *u_addr)
 		{
 			alloc_node = list_entry(pos, struct mfc_alloc_mem, list);
 			if (alloc_node->u_addr == u_addr) {
+				if (alloc_node->export_count) {
+					mfc_err("buffer(0x%08x) is still shared\n",
+						alloc_node->p_addr);
+					return MFCINST_MEMORY_BUSY;
+				}
 				mfc_free_alloc_mem(alloc_node, port_no);
 				found = true;
 				break;
@@ -228,25 +311,58 @@ void mfc_release_all_buffer(int inst_no)
 
 void mfc_free_alloc_mem(struct mfc_alloc_mem *alloc_node, int port_no)
 {
+	struct list_head *head = &mfc_free_mem_head[port_no];
 	struct list_head *pos;
 	struct mfc_free_mem *free_node;
 	struct mfc_free_mem *target_node;
+	struct mfc_free_mem *merged_node = NULL;
+	unsigned int start_addr = alloc_node->p_addr;
+	unsigned int size = alloc_node->size;
 
-	free_node = (struct mfc_free_mem *)kmalloc(sizeof(struct mfc_free_mem), GFP_KERNEL);
-	free_node->start_addr = alloc_node->p_addr;
-	free_node->size = alloc_node->size;
-
-	list_for_each(pos, &mfc_free_mem_head[port_no])
+	list_for_each(pos, head)
 	{
 		target_node = list_entry(pos, struct mfc_free_mem, list);
-		if (alloc_node->p_addr < target_node->start_addr)
+		if (start_addr < target_node->start_addr)
 			break;
 	}
 
-	if (pos == &mfc_free_mem_head[port_no])
-		list_add_tail(&(free_node->list), &(mfc_free_mem_head[port_no]));
-	else
-		list_add_tail(&(free_node->list), pos);
+	/* coalesce with the chunks on either side straight away */
+	if (pos->prev != head) {
+		target_node = list_entry(pos->prev, struct mfc_free_mem, list);
+		if ((target_node->start_addr + target_node->size) == start_addr) {
+			target_node->size += size;
+			merged_node = target_node;
+		}
+	}
+
+	if (pos != head) {
+		target_node = list_entry(pos, struct mfc_free_mem, list);
+		if ((start_addr + size) == target_node->start_addr) {
+			if (merged_node != NULL) {
+				merged_node->size += target_node->size;
+				list_del(&(target_node->list));
+				kfree(target_node);
+			} else {
+				target_node->start_addr = start_addr;
+				target_node->size += size;
+				merged_node = target_node;
+			}
+		}
+	}
+
+	if (merged_node == NULL) {
+		free_node = (struct mfc_free_mem *)kmalloc(sizeof(struct mfc_free_mem), GFP_KERNEL);
+		if (free_node == NULL) {
+			mfc_err("can't return 0x%08x (%u bytes) to the free list\n",
+				start_addr, size);
+		} else {
+			free_node->start_addr = start_addr;
+			free_node->size = size;
+			list_add_tail(&(free_node->list), pos);
+		}
+	}
+
+	mfc_buffer_stats[port_no].used -= size;
 
 	list_del(&(alloc_node->list));
 	kfree(alloc_node);
@@ -284,6 +400,54 @@ out_getphysaddr:
 	return ret;
 }
 
+static struct mfc_alloc_mem *mfc_find_alloc_mem(int inst_no, unsigned int p_addr)
+{
+	struct list_head *pos;
+	int port_no;
+	struct mfc_alloc_mem *alloc_node;
+
+	for (port_no = 0; port_no < MFC_MAX_PORT_NUM; port_no++) {
+		list_for_each(pos, &mfc_alloc_mem_head[port_no]) {
+			alloc_node = list_entry(pos, struct mfc_alloc_mem, list);
+			if (alloc_node->inst_no == inst_no &&
+			    p_addr >= alloc_node->p_addr &&
+			    p_addr < alloc_node->p_addr + alloc_node->size)
+				return alloc_node;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Pin the allocation of inst_no containing p_addr while another device
+ * scans it out. Returns the number of bytes from p_addr to the end of the
+ * allocation, or 0 if p_addr does not belong to the instance.
+ */
+unsigned int mfc_export_buffer(int inst_no, unsigned int p_addr)
+{
+	struct mfc_alloc_mem *alloc_node;
+
+	alloc_node = mfc_find_alloc_mem(inst_no, p_addr);
+	if (!alloc_node) {
+		mfc_err("invalid physical address(0x%08x)\n", p_addr);
+		return 0;
+	}
+
+	alloc_node->export_count++;
+
+	return alloc_node->p_addr + alloc_node->size - p_addr;
+}
+
+void mfc_unexport_buffer(int inst_no, unsigned int p_addr)
+{
+	struct mfc_alloc_mem *alloc_node;
+
+	alloc_node = mfc_find_alloc_mem(inst_no, p_addr);
+	if (alloc_node && alloc_node->export_count)
+		alloc_node->export_count--;
+}
+
 enum mfc_error_code mfc_allocate_buffer(struct mfc_inst_ctx *mfc_ctx, union mfc_args *args, int port_no)
 {
 	int ret;
@@ -307,6 +471,7 @@ enum mfc_error_code mfc_allocate_buffer(struct mfc_inst_ctx *mfc_ctx, union mfc_
 	mfc_debug("start_paddr = 0x%X\n\r", start_paddr);
 
 	if (!start_paddr) {
+		mfc_buffer_stats[port_no].alloc_fails++;
 		mfc_err("There is no more memory\n\r");
 		in_param->out_uaddr = -1;
 		ret = MFCINST_MEMORY_ALLOC_FAIL;
@@ -341,6 +506,11 @@ enum mfc_error_code mfc_allocate_buffer(struct mfc_inst_ctx *mfc_ctx, union mfc_
 	list_add(&(alloc_node->list), &mfc_alloc_mem_head[port_no]);
 	ret = MFCINST_RET_OK;
 
+	mfc_buffer_stats[port_no].allocs++;
+	mfc_buffer_stats[port_no].used += alloc_node->size;
+	if (mfc_buffer_stats[port_no].used > mfc_buffer_stats[port_no].peak_used)
+		mfc_buffer_stats[port_no].peak_used = mfc_buffer_stats[port_no].used;
+
 #if defined(DEBUG)
 	mfc_print_mem_list();
 #endif
@@ -20,6 +20,7 @@
 #define _MFC_BUFFER_MANAGER_H_
 
 #include <linux/list.h>
+#include <linux/seq_file.h>
 #include "mfc_interface.h"
 #include "mfc_opr.h"
 
@@ -33,6 +34,7 @@ struct mfc_alloc_mem  {
 	unsigned char *u_addr;     /* virtual address for user mode process */
 	int size;                  /* memory size                           */
 	int inst_no;               /* instance no                           */
+	int export_count;          /* shared handles pinning this buffer    */
 };
 
 
@@ -45,6 +47,7 @@ struct mfc_free_mem  {
 
 /* Function Prototype */
 void mfc_print_mem_list(void);
+void mfc_print_fragmentation(struct seq_file *s);
 int mfc_init_buffer(void);
 void mfc_merge_fragment(int inst_no);
 void mfc_release_all_buffer(int inst_no);
@@ -52,5 +55,7 @@ void mfc_free_alloc_mem(struct mfc_alloc_mem *alloc_node, int port_no);
 enum mfc_error_code mfc_release_buffer(unsigned char *u_addr);
 enum mfc_error_code mfc_get_phys_addr(struct mfc_inst_ctx *mfc_ctx, union mfc_args *args);
 enum mfc_error_code mfc_allocate_buffer(struct mfc_inst_ctx *mfc_ctx, union mfc_args *args, int port_no);
+unsigned int mfc_export_buffer(int inst_no, unsigned int p_addr);
+void mfc_unexport_buffer(int inst_no, unsigned int p_addr);
 
 #endif /* _MFC_BUFFER_MANAGER_H_ */
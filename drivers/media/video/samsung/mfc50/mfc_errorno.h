@@ -75,6 +75,7 @@ enum mfc_error_code {
 
 	MFCINST_MEMORY_INVALID_ADDR = -8101,
 	MFCINST_MEMORY_MAPPING_FAIL = -8102,
+	MFCINST_MEMORY_BUSY = -8103,
 
 	MFCAPI_RET_FAIL = -9001,
 };
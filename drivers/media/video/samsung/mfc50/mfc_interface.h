@@ -27,10 +27,35 @@
 #define IOCTL_MFC_DEC_EXE			0x00800003
 #define IOCTL_MFC_ENC_EXE			0x00800004
 
+/*
+ * Queue a DEC_EXE/ENC_EXE and return at once.  The ioctl returns a positive
+ * sequence number; WAIT_DONE returns the oldest finished command's arguments
+ * and result in the same mfc_common_args, and its sequence number.  poll()
+ * reports POLLIN while a finished command is waiting to be collected.
+ */
+#define IOCTL_MFC_DEC_EXE_ASYNC			0x00800005
+#define IOCTL_MFC_ENC_EXE_ASYNC			0x00800006
+#define IOCTL_MFC_WAIT_DONE			0x00800007
+
 #define IOCTL_MFC_GET_IN_BUF			0x00800010
 #define IOCTL_MFC_FREE_BUF			0x00800011
 #define IOCTL_MFC_GET_PHYS_ADDR			0x00800012
+/*
+ * Wrap up to two planes of an instance buffer (e.g. the Y and C of a
+ * decoded frame) in a shared buffer fd that FIMC or the framebuffer can
+ * scan out directly. The buffer cannot be freed, and the instance stays
+ * alive, until every copy of the fd has been closed.
+ */
+#define IOCTL_MFC_EXPORT_BUF			0x00800013
 #define IOCTL_MFC_GET_MMAP_SIZE			0x00800014
+/*
+ * Let the instance read frames from a shared buffer fd exported by another
+ * block (e.g. a FIMC capture buffer) and return the plane addresses to put
+ * in in_Y_addr/in_CbCr_addr. The instance holds the buffer until it is
+ * unimported by its Y address or the instance is released.
+ */
+#define IOCTL_MFC_IMPORT_BUF			0x00800015
+#define IOCTL_MFC_UNIMPORT_BUF			0x00800016
 
 #define IOCTL_MFC_SET_CONFIG			0x00800101
 #define IOCTL_MFC_GET_CONFIG			0x00800102
@@ -296,6 +321,17 @@ struct mfc_get_phys_addr_arg {
 	unsigned int p_addr;
 };
 
+struct mfc_export_buf_arg {
+	unsigned int in_paddr[2];            /* [IN]  Physical address of each plane, 0 if unused            */
+	int out_fd;                          /* [OUT] Shared buffer handle                                   */
+};
+
+struct mfc_import_buf_arg {
+	int in_fd;                           /* [IN]  Shared buffer handle (import only)                     */
+	unsigned int Y_paddr;                /* [OUT] Physical address of Y, [IN] for unimport               */
+	unsigned int C_paddr;                /* [OUT] Physical address of CbCr, 0 if single plane            */
+};
+
 struct mfc_mem_alloc_arg {
 	enum ssbsip_mfc_codec_type codec_type;
 	int buff_size;
@@ -328,6 +364,8 @@ union mfc_args {
 	struct mfc_mem_alloc_arg mem_alloc;
 	struct mfc_mem_free_arg mem_free;
 	struct mfc_get_phys_addr_arg get_phys_addr;
+	struct mfc_export_buf_arg export_buf;
+	struct mfc_import_buf_arg import_buf;
 
 	enum mfc_buffer_type buf_type;
 };
@@ -41,6 +41,7 @@
 #include <asm/cacheflush.h>
 #include <mach/map.h>
 #include <plat/map-s5p.h>
+#include <plat/media-buf.h>
 
 #include "mfc_opr.h"
 #include "mfc_logmsg.h"
@@ -1159,6 +1160,30 @@ static enum mfc_error_code mfc_encode_header(struct mfc_inst_ctx *mfc_ctx, union
 	return MFCINST_RET_OK;
 }
 
+/*
+ * Frames imported from another block that never hands them to the CPU
+ * cached need no cache maintenance, and are not in the kernel linear map.
+ */
+static bool mfc_is_uncached_import(struct mfc_inst_ctx *mfc_ctx, unsigned int p_addr)
+{
+	struct s5p_media_buf *buf;
+	unsigned int i, plane;
+
+	for (i = 0; i < MFC_MAX_IMPORT_BUF; i++) {
+		buf = mfc_ctx->import_buf[i];
+		if (!buf || buf->cpu_cached)
+			continue;
+
+		for (plane = 0; plane < buf->nr_planes; plane++) {
+			if (p_addr >= buf->plane[plane].paddr &&
+			    p_addr < buf->plane[plane].paddr + buf->plane[plane].size)
+				return true;
+		}
+	}
+
+	return false;
+}
+
 static enum mfc_error_code mfc_encode_one_frame(struct mfc_inst_ctx *mfc_ctx, union mfc_args *args)
 {
 	struct mfc_enc_exe_arg *enc_arg;
@@ -1210,7 +1235,8 @@ static enum mfc_error_code mfc_encode_one_frame(struct mfc_inst_ctx *mfc_ctx, un
 
 	mfc_ctx->forceSetFrameType = DONT_CARE;
 
-	if (mfc_ctx->buf_type == MFC_BUFFER_CACHE) {
+	if (mfc_ctx->buf_type == MFC_BUFFER_CACHE &&
+	    !mfc_is_uncached_import(mfc_ctx, enc_arg->in_Y_addr)) {
 		unsigned char *in_vir;
 		unsigned int aligned_width;
 		unsigned int aligned_height;
@@ -21,6 +21,9 @@
 #ifndef _MFC_OPR_H_
 #define _MFC_OPR_H_
 
+#include <linux/list.h>
+#include <linux/wait.h>
+#include <linux/ktime.h>
 #include <plat/regs-mfc.h>
 #include "mfc_errorno.h"
 #include "mfc_interface.h"
@@ -144,6 +147,32 @@ enum  mfc_frame_type {
 	MFC_RET_FRAME_B_FRAME = 3
 };
 
+/* Shared buffers an instance can hold for encoder input */
+#define MFC_MAX_IMPORT_BUF		8
+
+struct s5p_media_buf;
+
+/* Outstanding asynchronous EXE commands per instance */
+#define MFC_QUEUE_DEPTH			4
+
+struct mfc_queue_job {
+	unsigned int cmd;
+	int seq;
+	ktime_t queued;
+	struct mfc_common_args param;
+};
+
+struct mfc_inst_stats {
+	unsigned int frames;
+	unsigned int errors;
+	u64 latency_total_us;	/* submit to completion */
+	unsigned int latency_max_us;
+	u64 hw_total_us;	/* time holding the codec */
+	ktime_t window_start;
+	unsigned int window_frames;
+	unsigned int fps_x10;
+};
+
 struct mfc_inst_ctx {
 	int InstNo;
 	unsigned int DPBCnt;
@@ -176,6 +205,24 @@ struct mfc_inst_ctx {
 	struct mfc_shared_mem shared_mem;
 	enum mfc_buffer_type buf_type;
 	unsigned int desc_buff_paddr;
+
+	/* imported frames, protected by mfc_mutex */
+	struct s5p_media_buf *import_buf[MFC_MAX_IMPORT_BUF];
+
+	/*
+	 * Asynchronous command ring, protected by mfc_queue_lock.
+	 * [job_head, job_run) are done and not yet collected,
+	 * [job_run, job_tail) are waiting for the codec.
+	 */
+	struct mfc_queue_job jobs[MFC_QUEUE_DEPTH];
+	unsigned int job_head;
+	unsigned int job_run;
+	unsigned int job_tail;
+	int job_seq;
+	struct list_head run_list;
+	struct list_head inst_list;
+	wait_queue_head_t job_wait;
+	struct mfc_inst_stats stats;
 };
 
 int mfc_load_firmware(const unsigned char *data, size_t size);
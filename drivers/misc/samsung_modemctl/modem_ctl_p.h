@@ -81,11 +81,15 @@ struct modemstats {
 	unsigned rx_dropped;
 	unsigned rx_purged;
 	unsigned rx_received;
+	unsigned rx_drains;
+	unsigned rx_bytes;
+	unsigned rx_time_us;
 
 	unsigned tx_no_delay;
 	unsigned tx_queued;
 	unsigned tx_bp_signaled;
 	unsigned tx_fifo_full;
+	unsigned tx_bytes;
 
 	unsigned pipe_tx;
 	unsigned pipe_rx;
@@ -93,6 +97,9 @@ struct modemstats {
 	unsigned pipe_rx_purged;
 
 	unsigned resets;
+
+	/* filled in when the stats are read and reset */
+	unsigned period_ms;
 };
 
 #define MODEM_COUNT(mc,s) (((mc)->stats.s)++)
@@ -100,6 +107,7 @@ struct modemstats {
 struct modemctl {
 	void __iomem *mmio;
 	struct modemstats stats;
+	unsigned long stats_jiffies;
 
 	/* lock and waitqueue for shared memory state */
 	spinlock_t lock;
@@ -60,11 +60,15 @@ static int stats_show(struct seq_file *sf, void *unused)
 	SHOW(rx_dropped);
 	SHOW(rx_purged);
 	SHOW(rx_received);
+	SHOW(rx_drains);
+	SHOW(rx_bytes);
+	SHOW(rx_time_us);
 
 	SHOW(tx_no_delay);
 	SHOW(tx_queued);
 	SHOW(tx_bp_signaled);
 	SHOW(tx_fifo_full);
+	SHOW(tx_bytes);
 
 	SHOW(pipe_tx);
 	SHOW(pipe_rx);
@@ -73,6 +77,19 @@ static int stats_show(struct seq_file *sf, void *unused)
 
 	SHOW(resets);
 
+	SHOW(period_ms);
+	if (stats->rx_received)
+		seq_printf(sf, "%-20s %llu\n", "rx_ns_per_packet",
+			   div_u64((u64)stats->rx_time_us * 1000,
+				   stats->rx_received));
+	if (stats->period_ms) {
+		/* bits per millisecond is kbit/s */
+		seq_printf(sf, "%-20s %llu\n", "rx_kbps",
+			   div_u64((u64)stats->rx_bytes * 8, stats->period_ms));
+		seq_printf(sf, "%-20s %llu\n", "tx_kbps",
+			   div_u64((u64)stats->tx_bytes * 8, stats->period_ms));
+	}
+
 	return 0;
 }
 
@@ -90,6 +107,8 @@ static int stats_open(struct inode *inode, struct file *file)
 	spin_lock_irqsave(&mc->lock, flags);
 	memcpy(stats, &mc->stats, sizeof(*stats));
 	memset(&mc->stats, 0, sizeof(*stats));
+	stats->period_ms = jiffies_to_msecs(jiffies - mc->stats_jiffies);
+	mc->stats_jiffies = jiffies;
 	spin_unlock_irqrestore(&mc->lock, flags);
 
 	ret = single_open(file, stats_show, stats);
@@ -205,6 +224,8 @@ void modem_debugfs_init(struct modemctl *mc)
 	if (IS_ERR(dent))
 		return;
 
+	mc->stats_jiffies = jiffies;
+
 	debugfs_create_file("crash", 0200, dent, mc, &crash_ops);
 	debugfs_create_file("stats", 0444, dent, mc, &stats_ops);
 	debugfs_create_file("log", 0440, dent, mc, &log_ops);
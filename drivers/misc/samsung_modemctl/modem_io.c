@@ -318,6 +318,7 @@ static void handle_raw_rx(struct modemctl *mc)
 	struct raw_hdr raw;
 	struct sk_buff *skb = NULL;
 	int recvdata = 0;
+	ktime_t t0 = ktime_get();
 
 	/* process inbound packets */
 	while (fifo_read(&mc->raw_rx, &raw, sizeof(raw)) == sizeof(raw)) {
@@ -361,20 +362,24 @@ static void handle_raw_rx(struct modemctl *mc)
 		dev->stats.rx_packets++;
 		dev->stats.rx_bytes += skb->len;
 
+		mc->stats.rx_bytes += skb->len;
 		netif_rx(skb);
 		recvdata = 1;
 		MODEM_COUNT(mc, rx_received);
 	}
 
-	if (recvdata)
+	if (recvdata) {
+		MODEM_COUNT(mc, rx_drains);
+		mc->stats.rx_time_us += ktime_us_delta(ktime_get(), t0);
 		wake_lock_timeout(&mc->ip_rx_wakelock, HZ * 2);
+	}
 	return;
 
 purge_raw_fifo:
 	if (skb)
 		dev_kfree_skb_irq(skb);
 	pr_err("[VNET] purging raw rx fifo!\n");
-	fifo_purge(&mc->raw_tx);
+	fifo_purge(&mc->raw_rx);
 	MODEM_COUNT(mc, rx_purged);
 }
 
@@ -406,6 +411,7 @@ int handle_raw_tx(struct modemctl *mc, struct sk_buff *skb)
 	netdev_id = CHANNEL_TO_NETDEV_ID(vn->rmnet_ch_id);
 	mc->ndev[netdev_id]->stats.tx_packets++;
 	mc->ndev[netdev_id]->stats.tx_bytes += skb->len;
+	mc->stats.tx_bytes += skb->len;
 
 	mc->mmio_signal_bits |= MBD_SEND_RAW;
 
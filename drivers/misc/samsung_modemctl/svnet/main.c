@@ -68,6 +68,7 @@ enum {
 struct svnet_stat {
 	unsigned int st_wq_state;
 	unsigned long st_recv_evt;
+	unsigned long st_merged_evt;
 	unsigned long st_recv_pkt_ph;
 	unsigned long st_recv_pkt_pdp;
 	unsigned long st_do_write;
@@ -232,6 +233,7 @@ static inline int _show_stat(char *buf)
 	p += sprintf(p, "Stat -------- \n");
 	p += sprintf(p, "\twork state: %d\n", stat.st_wq_state);
 	p += sprintf(p, "\trecv mailbox: %lu\n", stat.st_recv_evt);
+	p += sprintf(p, "\tmerged mailbox: %lu\n", stat.st_merged_evt);
 	p += sprintf(p, "\trecv phonet: %lu\n", stat.st_recv_pkt_ph);
 	p += sprintf(p, "\trecv packet: %lu\n", stat.st_recv_pkt_pdp);
 	p += sprintf(p, "\twrite count: %lu\n", stat.st_do_write);
@@ -403,6 +405,21 @@ static int _queue_evt(struct svnet_evt_head *h, u32 event)
 	unsigned long flags;
 	struct svnet_evt *e;
 
+	/* A read drains every ring no matter which bits are set and
+	 * answers every ack request it finds, so a mailbox arriving while
+	 * one is still pending only has to add its ack requests to it:
+	 * one semaphore round trip serves both.
+	 */
+	spin_lock_irqsave(&h->lock, flags);
+	if (!list_empty(&h->list)) {
+		e = list_entry(h->list.prev, struct svnet_evt, list);
+		e->event |= event;
+		stat.st_merged_evt++;
+		spin_unlock_irqrestore(&h->lock, flags);
+		return 0;
+	}
+	spin_unlock_irqrestore(&h->lock, flags);
+
 	e = kmalloc(sizeof(struct svnet_evt), GFP_ATOMIC);
 	if (!e)
 		return -ENOMEM;
@@ -192,6 +192,16 @@ struct sipc {
 	const struct attribute_group *group;
 
 	struct sk_buff_head rfs_rx;
+
+	/* raw packets read in one drain, delivered after the semaphore
+	 * has been given back */
+	struct sk_buff_head rx_batch;
+
+	unsigned long rx_drains;
+	unsigned long rx_packets;
+	unsigned long long rx_bytes;
+	unsigned long long rx_time; /* ns from owning the semaphore to delivery */
+	unsigned long long rx_semtime; /* ns the semaphore was held by rx */
 };
 
 /* sizeof(struct phonethdr) + NET_SKB_PAD > SMP_CACHE_BYTES */
@@ -536,6 +546,7 @@ struct sipc* sipc_open(void (*queue)(u32, void*), struct net_device *ndev)
 	}
 	
 	skb_queue_head_init(&si->rfs_rx);
+	__skb_queue_head_init(&si->rx_batch);
 
 	/* process init message */
 	_init_proc(si);
@@ -1019,10 +1030,41 @@ static inline void _get_raw_hdr(struct raw_hdr *h, int *res,
 		*control = h->control;
 }
 
-static inline void _phonet_rx(struct net_device *ndev,
-		struct sk_buff *skb, int res)
+static inline void _rx_queue(struct sipc *si, struct sk_buff *skb)
+{
+	si->rx_packets++;
+	si->rx_bytes += skb->len;
+
+	/* the pdp device may be deactivated before the batch is flushed */
+	dev_hold(skb->dev);
+	__skb_queue_tail(&si->rx_batch, skb);
+}
+
+static void _rx_flush(struct sipc *si)
 {
 	int r;
+	struct sk_buff *skb;
+	struct net_device *ndev;
+
+	if (skb_queue_empty(&si->rx_batch))
+		return;
+
+	local_bh_disable();
+	skb = __skb_dequeue(&si->rx_batch);
+	while (skb) {
+		ndev = skb->dev;
+		r = netif_receive_skb(skb);
+		if (r != NET_RX_SUCCESS)
+			dev_dbg(&ndev->dev, "rx dropped: %d\n", r);
+		dev_put(ndev);
+		skb = __skb_dequeue(&si->rx_batch);
+	}
+	local_bh_enable();
+}
+
+static inline void _phonet_hdr(struct net_device *ndev,
+		struct sk_buff *skb, int res)
+{
 	struct phonethdr *ph;
 
 	skb->protocol = __constant_htons(ETH_P_PHONET);
@@ -1039,6 +1081,14 @@ static inline void _phonet_rx(struct net_device *ndev,
 	ndev->stats.rx_bytes += skb->len;
 
 	skb_reset_mac_header(skb);
+}
+
+static inline void _phonet_rx(struct net_device *ndev,
+		struct sk_buff *skb, int res)
+{
+	int r;
+
+	_phonet_hdr(ndev, skb, res);
 
 	r = netif_rx_ni(skb);
 	if (r != NET_RX_SUCCESS)
@@ -1047,13 +1097,13 @@ static inline void _phonet_rx(struct net_device *ndev,
 	_dbg("%s: res 0x%02x packet %p len %d\n", __func__, res, skb, skb->len);
 }
 
-static int _read_pn(struct net_device *ndev, struct ringbuf *rb, int len,
-		int res)
+static int _read_pn(struct sipc *si, struct ringbuf *rb, int len, int res)
 {
 	int r;
 	struct sk_buff *skb;
 	char *p;
 	int read_len = len + sizeof(hdlc_end);
+	struct net_device *ndev = si->svndev;
 
 	_dbg("%s: res 0x%02x data %d\n", __func__, res, len);
 
@@ -1070,7 +1120,8 @@ static int _read_pn(struct net_device *ndev, struct ringbuf *rb, int len,
 		return -EBADMSG;
 	}
 
-	_phonet_rx(ndev, skb, res);
+	_phonet_hdr(ndev, skb, res);
+	_rx_queue(si, skb);
 
 	return r;
 }
@@ -1195,8 +1246,8 @@ free_skb:
 	return r;
 }
 
-static int _read_pdp(struct ringbuf *rb, int len,
-		int res)
+/* called with pdp_mutex held */
+static int _read_pdp(struct sipc *si, struct ringbuf *rb, int len, int res)
 {
 	int r;
 	struct sk_buff *skb;
@@ -1206,47 +1257,35 @@ static int _read_pdp(struct ringbuf *rb, int len,
 
 	_dbg("%s: res 0x%02x data %d\n", __func__, res, len);
 
-	mutex_lock(&pdp_mutex);
-
 	ndev = pdp_devs[PDP_ID(res)];
 	if (!ndev) {
 		// drop data
-		r = __read(rb, NULL, read_len);
-		mutex_unlock(&pdp_mutex);
-		return r;
+		return __read(rb, NULL, read_len);
 	}
 
-	skb = netdev_alloc_skb(ndev, read_len);
-	if (unlikely(!skb)) {
-		mutex_unlock(&pdp_mutex);
+	/* keep the IP header word aligned for the stack */
+	skb = netdev_alloc_skb_ip_align(ndev, read_len);
+	if (unlikely(!skb))
 		return -ENOMEM;
-	}
 
 	p = skb_put(skb, len);
 	r = __read(rb, p, read_len);
 	if (r != read_len) {
-		mutex_unlock(&pdp_mutex);
 		kfree_skb(skb);
 		return -EBADMSG;
 	}
 	ndev->stats.rx_packets++;
 	ndev->stats.rx_bytes += skb->len;
 
-	mutex_unlock(&pdp_mutex);
-
-	read_len = r;
-
 	skb->protocol = __constant_htons(ETH_P_IP);
 
 	skb_reset_mac_header(skb);
 
 	_dbg("%s: pdp packet %p len %d\n", __func__, skb, skb->len);
 
-	r = netif_rx_ni(skb);
-	if (r != NET_RX_SUCCESS)
-		dev_err(&ndev->dev, "pdp rx error: %d\n", r);
+	_rx_queue(si, skb);
 
-	return read_len;
+	return r;
 }
 
 static int _read_raw(struct sipc *si, int inbuf, struct ringbuf *rb)
@@ -1256,6 +1295,9 @@ static int _read_raw(struct sipc *si, int inbuf, struct ringbuf *rb)
 	int res, data_len;
 	u32 tail;
 
+	/* once for the whole drain rather than per packet */
+	mutex_lock(&pdp_mutex);
+
 	while (inbuf > 0) {
 		tail = rb->rb_in_tail;
 
@@ -1263,7 +1305,8 @@ static int _read_raw(struct sipc *si, int inbuf, struct ringbuf *rb)
 		if (r < sizeof(buf) ||
 				strncmp(buf, hdlc_start, sizeof(hdlc_start))) {
 			dev_err(&si->svndev->dev, "Bad message: %c %d\n", buf[0], r);
-			return -EBADMSG;
+			r = -EBADMSG;
+			goto out;
 		}
 		inbuf -= r;
 
@@ -1273,22 +1316,26 @@ static int _read_raw(struct sipc *si, int inbuf, struct ringbuf *rb)
 		data_len -= sizeof(struct raw_hdr);
 
 		if (res >= PN_PDP_START && res <= PN_PDP_END) {
-			r = _read_pdp(rb, data_len, res);
+			r = _read_pdp(si, rb, data_len, res);
 		} else {
-			r = _read_pn(si->svndev, rb, data_len, res);
+			r = _read_pn(si, rb, data_len, res);
 		}
 
 		if (r < 0) {
 			if (r == -ENOMEM)
 				rb->rb_in_tail = tail;
 
-			return r;
+			goto out;
 		}
 
 		inbuf -= r;
 	}
+	r = 0;
 
-	return 0;
+out:
+	mutex_unlock(&pdp_mutex);
+
+	return r;
 }
 
 static int _read_rfs(struct sipc *si, int inbuf, struct ringbuf *rb)
@@ -1575,6 +1622,7 @@ int sipc_read(struct sipc *si, u32 mailbox, int *cond)
 	int r = 0;
 	int i;
 	u32 res = 0;
+	unsigned long long t;
 
 	if (!si)
 		return -EINVAL;
@@ -1583,6 +1631,8 @@ int sipc_read(struct sipc *si, u32 mailbox, int *cond)
 	if (r)
 		return r;
 
+	t = cpu_clock(smp_processor_id());
+
 	for (i=0;i<IPCIDX_MAX;i++) {
 		int inbuf;
 		struct ringbuf *rb;
@@ -1612,7 +1662,7 @@ int sipc_read(struct sipc *si, u32 mailbox, int *cond)
 		}
 
 		if (mailbox & mb_data[i].mask_req_ack)
-			res = mb_data[i].mask_res_ack;
+			res |= mb_data[i].mask_res_ack;
 	}
 
 #if !defined(CONFIG_ARIES_NTT)
@@ -1621,9 +1671,17 @@ int sipc_read(struct sipc *si, u32 mailbox, int *cond)
 
 	_put_auth(si);
 
+	si->rx_semtime += cpu_clock(smp_processor_id()) - t;
+
 	if (res)
 		onedram_write_mailbox(MB_DATA(res));
 
+	/* the modem can refill the rings while the stack runs */
+	_rx_flush(si);
+
+	si->rx_drains++;
+	si->rx_time += cpu_clock(smp_processor_id()) - t;
+
 	*cond =	skb_queue_len(&si->rfs_rx);
 
 	return r;
@@ -1700,6 +1758,27 @@ static inline ssize_t _debug_show_pdp(struct sipc *si, char *buf)
 	return p - buf;
 }
 
+static inline ssize_t _debug_show_rx(struct sipc *si, char *buf)
+{
+	char *p = buf;
+	unsigned long long pkt_time = 0;
+	unsigned long long sem_time = 0;
+
+	if (si->rx_packets)
+		pkt_time = div_u64(si->rx_time, si->rx_packets);
+	if (si->rx_drains)
+		sem_time = div_u64(si->rx_semtime, si->rx_drains);
+
+	p += sprintf(p, "\nRaw rx ---------\n");
+	p += sprintf(p, "Drains:\t\t%lu\n", si->rx_drains);
+	p += sprintf(p, "Packets:\t%lu\n", si->rx_packets);
+	p += sprintf(p, "Bytes:\t\t%llu\n", si->rx_bytes);
+	p += sprintf(p, "CPU per packet:\t%llu ns\n", pkt_time);
+	p += sprintf(p, "Sem. per drain:\t%llu ns\n", sem_time);
+
+	return p - buf;
+}
+
 ssize_t sipc_debug_show(struct sipc *si, char *buf)
 {
 	char *p = buf;
@@ -1711,6 +1790,8 @@ ssize_t sipc_debug_show(struct sipc *si, char *buf)
 
 	p += _debug_show_pdp(si, p);
 
+	p += _debug_show_rx(si, p);
+
 	p += sprintf(p, "\nDebug command -----------\n");
 	p += sprintf(p, "R0\tcopy FMT out to in\n");
 	p += sprintf(p, "R1\tcopy RAW out to in\n");
@@ -542,6 +542,12 @@ static int __devinit sdhci_s3c_probe(struct platform_device *pdev)
 	/* PIO currently has problems with multi-block IO */
 	host->quirks |= SDHCI_QUIRK_NO_MULTIBLOCK;
 
+#else
+
+	/* The ADMA2 engine takes a zero length descriptor as zero bytes,
+	 * not 64KiB, so keep scatter/gather segments below that. */
+	host->quirks |= SDHCI_QUIRK_BROKEN_ADMA_ZEROLEN_DESC;
+
 #endif /* CONFIG_MMC_SDHCI_S3C_DMA */
 
 	/* It seems we do not get an DATA transfer complete on non-busy
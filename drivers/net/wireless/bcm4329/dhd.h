@@ -149,6 +149,9 @@ typedef struct dhd_pub {
 	/* Last error return */
 	int bcmerror;
 	uint tickcnt;
+	uint wd_lazyticks;	/* Watchdog ticks taken on the deferrable timer */
+	uint wd_stops;		/* Times the watchdog was stopped with the bus up */
+	uint wd_restarts;	/* Times traffic or an interrupt restarted it */
 
 	/* Last error from dongle */
 	int dongle_error;
@@ -298,6 +301,7 @@ extern void * dhd_os_open_image(char * filename);
 extern int dhd_os_get_image_block(char * buf, int len, void * image);
 extern void dhd_os_close_image(void * image);
 extern void dhd_os_wd_timer(void *bus, uint wdtick);
+extern void dhd_os_wd_timer_idle(void *bus, bool lazy);
 extern void dhd_os_sdlock(dhd_pub_t * pub);
 extern void dhd_os_sdunlock(dhd_pub_t * pub);
 extern void dhd_os_sdlock_txq(dhd_pub_t * pub);
@@ -294,7 +294,10 @@ typedef struct dhd_info {
 	struct mutex proto_sem;
 	wait_queue_head_t ioctl_resp_wait;
 	struct timer_list timer;
+	struct timer_list timer_lazy;	/* deferrable twin of timer */
 	bool wd_timer_valid;
+	bool wd_lazy;			/* tick on timer_lazy instead */
+	bool wd_idle;			/* stopped by dhd_os_wd_timer_idle() */
 	struct tasklet_struct tasklet;
 	spinlock_t	sdlock;
 	spinlock_t	txqlock;
@@ -464,6 +467,10 @@ module_param(dhd_rxbound, uint, 0);
 extern uint dhd_deferred_tx;
 module_param(dhd_deferred_tx, uint, 0);
 
+/* Rx superframes (glom) */
+extern uint dhd_rxglom;
+module_param(dhd_rxglom, uint, 0);
+
 
 
 #ifdef SDTEST
@@ -1260,12 +1267,14 @@ dhd_rx_frame(dhd_pub_t *dhdp, int ifidx, void *pktbuf, int numpkt)
 {
 	dhd_info_t *dhd = (dhd_info_t *)dhdp->info;
 	struct sk_buff *skb;
+	struct sk_buff *skb_head = NULL, *skb_tail = NULL, *skb_next;
 	uchar *eth;
 	uint len;
 	void * data, *pnext, *save_pktbuf;
 	int i;
 	dhd_if_t *ifp;
 	wl_event_msg_t event;
+	int rxifidx = ifidx;	/* interface of every frame in the chain */
 
 	DHD_TRACE(("%s: Enter\n", __FUNCTION__));
 
@@ -1273,6 +1282,9 @@ dhd_rx_frame(dhd_pub_t *dhdp, int ifidx, void *pktbuf, int numpkt)
 
 	for (i = 0; pktbuf && i < numpkt; i++, pktbuf = pnext) {
 
+		/* An event frame may name another interface, for itself only */
+		ifidx = rxifidx;
+
 		pnext = PKTNEXT(dhdp->osh, pktbuf);
 		PKTSETNEXT(wl->sh.osh, pktbuf, NULL);
 
@@ -1335,12 +1347,17 @@ dhd_rx_frame(dhd_pub_t *dhdp, int ifidx, void *pktbuf, int numpkt)
 		} else {
 			/* If the receive is not processed inside an ISR,
 			 * the softirqd must be woken explicitly to service
-			 * the NET_RX_SOFTIRQ.  In 2.6 kernels, this is handled
-			 * by netif_rx_ni(), but in earlier kernels, we need
-			 * to do it manually.
+			 * the NET_RX_SOFTIRQ.  In 2.6 kernels, the frames are
+			 * collected here and handed to the stack as one batch
+			 * below, but in earlier kernels, we need to do it
+			 * manually.
 			 */
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 0)
-			netif_rx_ni(skb);
+			if (skb_tail)
+				skb_tail->next = skb;
+			else
+				skb_head = skb;
+			skb_tail = skb;
 #else
 			ulong flags;
 			netif_rx(skb);
@@ -1350,6 +1367,20 @@ dhd_rx_frame(dhd_pub_t *dhdp, int ifidx, void *pktbuf, int numpkt)
 #endif /* LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 0) */
 		}
 	}
+
+	/* Run the whole batch through the stack with bottom halves disabled
+	 * once, instead of a netif_rx_ni() backlog round trip and softirq
+	 * run for every frame.
+	 */
+	if (skb_head) {
+		local_bh_disable();
+		for (skb = skb_head; skb; skb = skb_next) {
+			skb_next = skb->next;
+			skb->next = NULL;
+			netif_receive_skb(skb);
+		}
+		local_bh_enable();
+	}
 	dhd_os_wake_lock_timeout_enable(dhdp);
 }
 
@@ -1413,6 +1444,28 @@ dhd_get_stats(struct net_device *net)
 	return &ifp->stats;
 }
 
+/* Re-arm the watchdog one period out on whichever timer is current */
+static void
+dhd_wd_arm(dhd_info_t *dhd)
+{
+	ulong expires = jiffies + dhd_watchdog_ms * HZ / 1000;
+
+	if (dhd->wd_lazy) {
+		del_timer(&dhd->timer);
+		mod_timer(&dhd->timer_lazy, expires);
+	} else {
+		del_timer(&dhd->timer_lazy);
+		mod_timer(&dhd->timer, expires);
+	}
+}
+
+static void
+dhd_wd_stop(dhd_info_t *dhd)
+{
+	del_timer_sync(&dhd->timer);
+	del_timer_sync(&dhd->timer_lazy);
+}
+
 static int
 dhd_watchdog_thread(void *data)
 {
@@ -1438,6 +1491,8 @@ dhd_watchdog_thread(void *data)
 			dhd_os_sdlock(&dhd->pub);
 			if (dhd->pub.dongle_reset == FALSE) {
 				DHD_TIMER(("%s:\n", __FUNCTION__));
+				if (dhd->wd_lazy)
+					dhd->pub.wd_lazyticks++;
 				/* Call the bus module watchdog */
 				dhd_bus_watchdog(&dhd->pub);
 
@@ -1446,7 +1501,7 @@ dhd_watchdog_thread(void *data)
 
 				/* Reschedule the watchdog */
 				if (dhd->wd_timer_valid)
-					mod_timer(&dhd->timer, jiffies + dhd_watchdog_ms * HZ / 1000);
+					dhd_wd_arm(dhd);
 			}
 			dhd_os_sdunlock(&dhd->pub);
 			dhd_os_wake_unlock(&dhd->pub);
@@ -1475,6 +1530,8 @@ dhd_watchdog(ulong data)
 	}
 
 	dhd_os_sdlock(&dhd->pub);
+	if (dhd->wd_lazy)
+		dhd->pub.wd_lazyticks++;
 	/* Call the bus module watchdog */
 	dhd_bus_watchdog(&dhd->pub);
 
@@ -1483,7 +1540,7 @@ dhd_watchdog(ulong data)
 
 	/* Reschedule the watchdog */
 	if (dhd->wd_timer_valid)
-		mod_timer(&dhd->timer, jiffies + dhd_watchdog_ms * HZ / 1000);
+		dhd_wd_arm(dhd);
 	dhd_os_sdunlock(&dhd->pub);
 	dhd_os_wake_unlock(&dhd->pub);
 }
@@ -2152,6 +2209,10 @@ dhd_attach(osl_t *osh, struct dhd_bus *bus, uint bus_hdrlen)
 	init_timer(&dhd->timer);
 	dhd->timer.data = (ulong)dhd;
 	dhd->timer.function = dhd_watchdog;
+	/* Used once the backplane clock is released: need not wake the CPU */
+	init_timer_deferrable(&dhd->timer_lazy);
+	dhd->timer_lazy.data = (ulong)dhd;
+	dhd->timer_lazy.function = dhd_watchdog;
 
 	/* Initialize thread based operation and lock */
 	mutex_init(&dhd->sdsem);
@@ -2260,7 +2321,7 @@ dhd_bus_start(dhd_pub_t *dhdp)
 	/* Host registration for OOB interrupt */
 	if (bcmsdh_register_oob_intr(dhdp)) {
 		dhd->wd_timer_valid = FALSE;
-		del_timer_sync(&dhd->timer);
+		dhd_wd_stop(dhd);
 		DHD_ERROR(("%s Host failed to resgister for OOB\n", __FUNCTION__));
 		dhd_os_sdunlock(dhdp);
 		return -ENODEV;
@@ -2273,7 +2334,7 @@ dhd_bus_start(dhd_pub_t *dhdp)
 	/* If bus is not ready, can't come up */
 	if (dhd->pub.busstate != DHD_BUS_DATA) {
 		dhd->wd_timer_valid = FALSE;
-		del_timer_sync(&dhd->timer);
+		dhd_wd_stop(dhd);
 		DHD_ERROR(("%s failed bus is not ready\n", __FUNCTION__));
 		dhd_os_sdunlock(dhdp);
 		return -ENODEV;
@@ -2534,7 +2595,7 @@ dhd_bus_detach(dhd_pub_t *dhdp)
 
 			/* Clear the watchdog timer */
 			dhd->wd_timer_valid = FALSE;
-			del_timer_sync(&dhd->timer);
+			dhd_wd_stop(dhd);
 		}
 	}
 }
@@ -2812,9 +2873,14 @@ dhd_os_wd_timer(void *bus, uint wdtick)
 	if (pub->busstate != DHD_BUS_DOWN) {
 		if (wdtick) {
 			dhd_watchdog_ms = (uint)wdtick;
+			if (dhd->wd_idle) {
+				dhd->wd_idle = FALSE;
+				pub->wd_restarts++;
+			}
 			dhd->wd_timer_valid = TRUE;
+			dhd->wd_lazy = FALSE;
 			/* Re arm the timer, at last watchdog period */
-			mod_timer(&dhd->timer, jiffies + dhd_watchdog_ms * HZ / 1000);
+			dhd_wd_arm(dhd);
 		} else if (dhd->wd_timer_valid == TRUE) {
 			/* Totally stop the timer */
 			dhd->wd_timer_valid = FALSE;
@@ -2823,10 +2889,37 @@ dhd_os_wd_timer(void *bus, uint wdtick)
 	}
 	dhd_os_spin_unlock(pub, flags);
 	if (del_timer_flag) {
-		del_timer_sync(&dhd->timer);
+		dhd_wd_stop(dhd);
 	}
 }
 
+/*
+ * Called by the bus watchdog from the tick itself when the backplane
+ * clock is off. With lazy set the watchdog keeps running on the
+ * deferrable timer, otherwise it is not re-armed at all; the next
+ * dhd_os_wd_timer() call from clock control puts it back on the
+ * regular timer.
+ */
+void
+dhd_os_wd_timer_idle(void *bus, bool lazy)
+{
+	dhd_pub_t *pub = bus;
+	dhd_info_t *dhd = (dhd_info_t *)pub->info;
+	unsigned long flags;
+
+	flags = dhd_os_spin_lock(pub);
+	if (dhd->wd_timer_valid) {
+		if (lazy) {
+			dhd->wd_lazy = TRUE;
+		} else {
+			dhd->wd_timer_valid = FALSE;
+			dhd->wd_idle = TRUE;
+			pub->wd_stops++;
+		}
+	}
+	dhd_os_spin_unlock(pub, flags);
+}
+
 void *
 dhd_os_open_image(char *filename)
 {
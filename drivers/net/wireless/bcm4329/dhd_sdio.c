@@ -206,6 +206,15 @@ typedef struct dhd_bus {
 	void		*glom;			/* Packet chain for glommed superframe */
 	uint		glomerr;		/* Glom packet read errors */
 
+	void		*rxq_head;		/* Frames read in this pass, not yet sent up */
+	void		*rxq_tail;		/* Last frame of rxq_head chain */
+	int		rxq_ifidx;		/* Interface of the queued frames */
+	uint		rxq_cnt;		/* Number of queued frames */
+
+	void		*txdone_head;		/* Frames sent in this pass, not yet completed */
+	void		*txdone_tail;		/* Last frame of txdone_head chain */
+	bool		txdone_defer;		/* Hold tx completions until the pass ends */
+
 	uint8		*rxbuf;			/* Buffer for receiving control packets */
 	uint		rxblen;			/* Allocated length of rxbuf */
 	uint8		*rxctl;			/* Aligned pointer into rxbuf */
@@ -289,6 +298,8 @@ typedef struct dhd_bus {
 	uint		rxglomfail;		/* Failed deglom attempts */
 	uint		rxglomframes;		/* Number of glom frames (superframes) */
 	uint		rxglompkts;		/* Number of packets from glom frames */
+	uint		rxbatches;		/* Number of batches handed to the stack */
+	uint		txbatches;		/* Number of tx queue dequeue batches */
 	uint		f2rxhdrs;		/* Number of header reads */
 	uint		f2rxdata;		/* Number of frame data reads */
 	uint		f2txdata;		/* Number of f2 frame writes */
@@ -323,6 +334,9 @@ uint dhd_txbound;
 uint dhd_rxbound;
 uint dhd_txminmax;
 
+/* Let the dongle glom rx frames into superframes (one SDIO read each) */
+uint dhd_rxglom = TRUE;
+
 /* override the RAM size if possible */
 #define DONGLE_MIN_MEMSIZE (128 *1024)
 int dhd_dongle_memsize;
@@ -1031,6 +1045,17 @@ dhdsdio_txpkt(dhd_bus_t *bus, void *pkt, uint chan, bool free_pkt)
 done:
 	/* restore pkt buffer pointer before calling tx complete routine */
 	PKTPULL(osh, pkt, SDPCM_HDRLEN + pad);
+
+	/* Batched sends complete all together, see dhdsdio_txdone() */
+	if (bus->txdone_defer && free_pkt && (ret == 0)) {
+		if (bus->txdone_tail)
+			PKTSETNEXT(osh, bus->txdone_tail, pkt);
+		else
+			bus->txdone_head = pkt;
+		bus->txdone_tail = pkt;
+		return ret;
+	}
+
 	dhd_os_sdunlock(bus->dhd);
 	dhd_txcomplete(bus->dhd, pkt, ret != 0);
 	dhd_os_sdlock(bus->dhd);
@@ -1140,14 +1165,36 @@ dhd_bus_txdata(struct dhd_bus *bus, void *pkt)
 	return ret;
 }
 
+/* Complete the frames sent by a dhdsdio_sendfromq() pass, dropping
+ * the bus lock once for all of them instead of once per frame.
+ */
+static void
+dhdsdio_txdone(dhd_bus_t *bus)
+{
+	osl_t *osh = bus->dhd->osh;
+	void *pkts, *pkt;
+
+	if ((pkts = bus->txdone_head) == NULL)
+		return;
+	bus->txdone_head = bus->txdone_tail = NULL;
+
+	dhd_os_sdunlock(bus->dhd);
+	for (pkt = pkts; pkt; pkt = PKTNEXT(osh, pkt))
+		dhd_txcomplete(bus->dhd, pkt, FALSE);
+	dhd_os_sdlock(bus->dhd);
+
+	PKTFREE(osh, pkts, TRUE);
+}
+
 static uint
 dhdsdio_sendfromq(dhd_bus_t *bus, uint maxframes)
 {
-	void *pkt;
+	void *pkt, *pnext, *pkts;
 	uint32 intstatus = 0;
 	uint retries = 0;
 	int ret = 0, prec_out;
 	uint cnt = 0;
+	uint batch;
 	uint datalen;
 	uint8 tx_prec_map;
 
@@ -1159,37 +1206,64 @@ dhdsdio_sendfromq(dhd_bus_t *bus, uint maxframes)
 	tx_prec_map = ~bus->flowcontrol;
 
 	/* Send frames until the limit or some other event */
-	for (cnt = 0; (cnt < maxframes) && DATAOK(bus); cnt++) {
+	while ((cnt < maxframes) && DATAOK(bus)) {
+		/* Take as many frames as the dongle window and the limit allow
+		 * in one go, then send them back to back. Poll mode checks the
+		 * device after each frame and may stop early: no batching.
+		 */
+		batch = MIN(maxframes - cnt, (uint8)(bus->tx_max - bus->tx_seq));
+		if (!bus->intr)
+			batch = 1;
+		pkts = NULL;
 		dhd_os_sdlock_txq(bus->dhd);
-		if ((pkt = pktq_mdeq(&bus->txq, tx_prec_map, &prec_out)) == NULL) {
-			dhd_os_sdunlock_txq(bus->dhd);
-			break;
+		for (pnext = NULL; batch; batch--) {
+			if ((pkt = pktq_mdeq(&bus->txq, tx_prec_map, &prec_out)) == NULL)
+				break;
+			if (pnext)
+				PKTSETNEXT(bus->dhd->osh, pnext, pkt);
+			else
+				pkts = pkt;
+			pnext = pkt;
 		}
 		dhd_os_sdunlock_txq(bus->dhd);
-		datalen = PKTLEN(bus->dhd->osh, pkt) - SDPCM_HDRLEN;
+		if (pkts == NULL)
+			break;
+		bus->txbatches++;
+
+		bus->txdone_defer = TRUE;
+		for (pkt = pkts; pkt; pkt = pnext, cnt++) {
+			pnext = PKTNEXT(bus->dhd->osh, pkt);
+			PKTSETNEXT(bus->dhd->osh, pkt, NULL);
+			datalen = PKTLEN(bus->dhd->osh, pkt) - SDPCM_HDRLEN;
 
 #ifndef SDTEST
-		ret = dhdsdio_txpkt(bus, pkt, SDPCM_DATA_CHANNEL, TRUE);
+			ret = dhdsdio_txpkt(bus, pkt, SDPCM_DATA_CHANNEL, TRUE);
 #else
-		ret = dhdsdio_txpkt(bus, pkt,
-		        (bus->ext_loop ? SDPCM_TEST_CHANNEL : SDPCM_DATA_CHANNEL), TRUE);
+			ret = dhdsdio_txpkt(bus, pkt,
+			        (bus->ext_loop ? SDPCM_TEST_CHANNEL : SDPCM_DATA_CHANNEL), TRUE);
 #endif
-		if (ret)
-			bus->dhd->tx_errors++;
-		else
-			bus->dhd->dstats.tx_bytes += datalen;
-
-		/* In poll mode, need to check for other events */
-		if (!bus->intr && cnt)
-		{
-			/* Check device status, signal pending interrupt */
-			R_SDREG(intstatus, &regs->intstatus, retries);
-			bus->f2txdata++;
-			if (bcmsdh_regfail(bus->sdh))
-				break;
-			if (intstatus & bus->hostintmask)
-				bus->ipend = TRUE;
+			if (ret)
+				bus->dhd->tx_errors++;
+			else
+				bus->dhd->dstats.tx_bytes += datalen;
+
+			/* In poll mode, need to check for other events */
+			if (!bus->intr && cnt)
+			{
+				/* Check device status, signal pending interrupt */
+				R_SDREG(intstatus, &regs->intstatus, retries);
+				bus->f2txdata++;
+				if (bcmsdh_regfail(bus->sdh))
+					break;
+				if (intstatus & bus->hostintmask)
+					bus->ipend = TRUE;
+			}
 		}
+		bus->txdone_defer = FALSE;
+		dhdsdio_txdone(bus);
+
+		if (pkt)
+			break;
 	}
 
 	/* Deflow-control stack if needed */
@@ -1512,6 +1586,8 @@ dhd_bus_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
 	            bus->fc_rcvd, bus->fc_xoff, bus->fc_xon);
 	bcm_bprintf(strbuf, "rxglomfail %d, rxglomframes %d, rxglompkts %d\n",
 	            bus->rxglomfail, bus->rxglomframes, bus->rxglompkts);
+	bcm_bprintf(strbuf, "rxbatches %d, txbatches %d\n",
+	            bus->rxbatches, bus->txbatches);
 	bcm_bprintf(strbuf, "f2rx (hdrs/data) %d (%d/%d), f2tx %d f1regs %d\n",
 	            (bus->f2rxhdrs + bus->f2rxdata), bus->f2rxhdrs, bus->f2rxdata,
 	            bus->f2txdata, bus->f1regdata);
@@ -1527,6 +1603,7 @@ dhd_bus_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
 		dhd_dump_pct(strbuf, "Rx: glom pct", (100 * bus->rxglompkts),
 		             bus->dhd->rx_packets);
 		dhd_dump_pct(strbuf, ", pkts/glom", bus->rxglompkts, bus->rxglomframes);
+		dhd_dump_pct(strbuf, ", pkts/batch", bus->dhd->rx_packets, bus->rxbatches);
 		bcm_bprintf(strbuf, "\n");
 
 		dhd_dump_pct(strbuf, "Tx: pkts/f2wr", bus->dhd->tx_packets, bus->f2txdata);
@@ -1534,6 +1611,7 @@ dhd_bus_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
 		dhd_dump_pct(strbuf, ", pkts/sd", bus->dhd->tx_packets,
 		             (bus->f2txdata + bus->f1regdata));
 		dhd_dump_pct(strbuf, ", pkts/int", bus->dhd->tx_packets, bus->intrcount);
+		dhd_dump_pct(strbuf, ", pkts/batch", bus->dhd->tx_packets, bus->txbatches);
 		bcm_bprintf(strbuf, "\n");
 
 		dhd_dump_pct(strbuf, "Total: pkts/f2rw",
@@ -1578,6 +1656,7 @@ dhd_bus_clearcounts(dhd_pub_t *dhdp)
 	bus->rx_hdrfail = bus->rx_badhdr = bus->rx_badseq = 0;
 	bus->tx_sderrs = bus->fc_rcvd = bus->fc_xoff = bus->fc_xon = 0;
 	bus->rxglomfail = bus->rxglomframes = bus->rxglompkts = 0;
+	bus->rxbatches = bus->txbatches = 0;
 	bus->f2rxhdrs = bus->f2rxdata = bus->f2txdata = bus->f1regdata = 0;
 }
 
@@ -2988,6 +3067,51 @@ done:
 	dhd_os_ioctl_resp_wake(bus->dhd);
 }
 
+/* Send up the frames queued by dhdsdio_rxq_add() in one call */
+static void
+dhdsdio_rxq_flush(dhd_bus_t *bus)
+{
+	void *pkts = bus->rxq_head;
+	uint cnt = bus->rxq_cnt;
+
+	if (!cnt)
+		return;
+
+	bus->rxq_head = bus->rxq_tail = NULL;
+	bus->rxq_cnt = 0;
+	bus->rxbatches++;
+
+	/* Unlock during rx call */
+	dhd_os_sdunlock(bus->dhd);
+	dhd_rx_frame(bus->dhd, bus->rxq_ifidx, pkts, cnt);
+	dhd_os_sdlock(bus->dhd);
+}
+
+/* Queue a frame, or a chain of num frames, read in this dhdsdio_readframes()
+ * pass. The stack gets them all at the end of the pass, bounded by rxbound,
+ * rather than one call per frame.
+ */
+static void
+dhdsdio_rxq_add(dhd_bus_t *bus, int ifidx, void *pkt, uint num)
+{
+	void *plast;
+
+	/* dhd_rx_frame() takes a single interface per call */
+	if (bus->rxq_cnt && (bus->rxq_ifidx != ifidx))
+		dhdsdio_rxq_flush(bus);
+
+	if (bus->rxq_tail)
+		PKTSETNEXT(bus->dhd->osh, bus->rxq_tail, pkt);
+	else
+		bus->rxq_head = pkt;
+
+	for (plast = pkt; PKTNEXT(bus->dhd->osh, plast); plast = PKTNEXT(bus->dhd->osh, plast))
+		;
+	bus->rxq_tail = plast;
+	bus->rxq_ifidx = ifidx;
+	bus->rxq_cnt += num;
+}
+
 static uint8
 dhdsdio_rxglom(dhd_bus_t *bus, uint8 rxseq)
 {
@@ -3358,11 +3482,8 @@ dhdsdio_rxglom(dhd_bus_t *bus, uint8 rxseq)
 #endif /* DHD_DEBUG */
 		}
 		dhd_os_sdunlock_rxq(bus->dhd);
-		if (num) {
-			dhd_os_sdunlock(bus->dhd);
-			dhd_rx_frame(bus->dhd, ifidx, save_pfirst, num);
-			dhd_os_sdlock(bus->dhd);
-		}
+		if (num)
+			dhdsdio_rxq_add(bus, ifidx, save_pfirst, num);
 
 		bus->rxglomframes++;
 		bus->rxglompkts += num;
@@ -3929,11 +4050,9 @@ deliver:
 		}
 
 
-		/* Unlock during rx call */
-		dhd_os_sdunlock(bus->dhd);
-		dhd_rx_frame(bus->dhd, ifidx, pkt, 1);
-		dhd_os_sdlock(bus->dhd);
+		dhdsdio_rxq_add(bus, ifidx, pkt, 1);
 	}
+	dhdsdio_rxq_flush(bus);
 	rxcount = maxframes - rxleft;
 #ifdef DHD_DEBUG
 	/* Message if we hit the limit */
@@ -4564,6 +4683,23 @@ dhdsdio_testrcv(dhd_bus_t *bus, void *pkt, uint seq)
 }
 #endif /* SDTEST */
 
+/* Whether the watchdog has periodic work besides the clock idle timeout */
+static bool
+dhdsdio_wd_polling(dhd_bus_t *bus)
+{
+	if (bus->poll)
+		return TRUE;
+#ifdef DHD_DEBUG
+	if (bus->dhd->busstate == DHD_BUS_DATA && dhd_console_ms != 0)
+		return TRUE;
+#endif /* DHD_DEBUG */
+#ifdef SDTEST
+	if (bus->pktgen_count)
+		return TRUE;
+#endif /* SDTEST */
+	return FALSE;
+}
+
 extern bool
 dhd_bus_watchdog(dhd_pub_t *dhdp)
 {
@@ -4576,9 +4712,11 @@ dhd_bus_watchdog(dhd_pub_t *dhdp)
 	if (bus->dhd->dongle_reset)
 		return FALSE;
 
-	/* Ignore the timer if simulating bus down */
-	if (bus->sleeping)
+	/* Ignore the timer if simulating bus down; stop it until wake */
+	if (bus->sleeping) {
+		dhd_os_wd_timer_idle(bus->dhd, FALSE);
 		return FALSE;
+	}
 
 	/* Poll period: check device if appropriate. */
 	if (bus->poll && (++bus->polltick >= bus->pollrate)) {
@@ -4649,6 +4787,14 @@ dhd_bus_watchdog(dhd_pub_t *dhdp)
 		}
 	}
 
+	/* With only the SD clock left there is no idle timeout to run: keep
+	 * ticking on the deferrable timer if something still polls, else stop
+	 * until clock control asks for the backplane again.  While the HT
+	 * clock is held the tick stays exact so it is released on time.
+	 */
+	if (bus->clkstate == CLK_SDONLY)
+		dhd_os_wd_timer_idle(bus->dhd, dhdsdio_wd_polling(bus));
+
 	return bus->ipend;
 }
 
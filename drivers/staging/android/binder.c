@@ -16,9 +16,11 @@
  */
 
 #include <asm/cacheflush.h>
+#include <linux/ashmem.h>
 #include <linux/fdtable.h>
 #include <linux/file.h>
 #include <linux/fs.h>
+#include <linux/ktime.h>
 #include <linux/list.h>
 #include <linux/miscdevice.h>
 #include <linux/mm.h>
@@ -97,6 +99,7 @@ enum {
 	BINDER_DEBUG_BUFFER_ALLOC           = 1U << 13,
 	BINDER_DEBUG_PRIORITY_CAP           = 1U << 14,
 	BINDER_DEBUG_BUFFER_ALLOC_ASYNC     = 1U << 15,
+	BINDER_DEBUG_LARGE_PAYLOAD          = 1U << 16,
 };
 static uint32_t binder_debug_mask = BINDER_DEBUG_USER_ERROR |
 	BINDER_DEBUG_FAILED_TRANSACTION | BINDER_DEBUG_DEAD_TRANSACTION;
@@ -105,6 +108,15 @@ module_param_named(debug_mask, binder_debug_mask, uint, S_IWUSR | S_IRUGO);
 static int binder_debug_no_lock;
 module_param_named(proc_no_lock, binder_debug_no_lock, bool, S_IWUSR | S_IRUGO);
 
+/*
+ * Payloads at least this large are counted as large copies; they are still
+ * copied like any other.  Data of that size belongs in an ashmem region
+ * passed as a BINDER_TYPE_FD object, which moves it by reference instead of
+ * through the target's binder buffer.
+ */
+static uint32_t binder_large_payload = 64 * SZ_1K;
+module_param_named(large_payload, binder_large_payload, uint, S_IWUSR | S_IRUGO);
+
 static DECLARE_WAIT_QUEUE_HEAD(binder_user_error_wait);
 static int binder_stop_on_user_error;
 
@@ -150,6 +162,9 @@ struct binder_stats {
 	int bc[_IOC_NR(BC_DEAD_BINDER_DONE) + 1];
 	int obj_created[BINDER_STAT_COUNT];
 	int obj_deleted[BINDER_STAT_COUNT];
+	u64 copied_bytes;
+	u64 ref_bytes;
+	int large_copies;
 };
 
 static struct binder_stats binder_stats;
@@ -164,6 +179,42 @@ static inline void binder_stats_created(enum binder_stat_types type)
 	binder_stats.obj_created[type]++;
 }
 
+/*
+ * Transaction latency, in microseconds, bucketed by power of two.
+ * "delivery" is the time from BC_TRANSACTION/BC_REPLY until a reader
+ * thread picks the work up, "call" is the full round trip of a
+ * synchronous call, measured when BR_REPLY reaches the caller.
+ * Updated with binder_lock held.
+ */
+#define BINDER_LATENCY_BUCKETS 21
+
+struct binder_latency {
+	unsigned int count;
+	unsigned int max_us;
+	u64 total_us;
+	unsigned int hist[BINDER_LATENCY_BUCKETS];
+};
+
+static struct binder_latency binder_delivery_latency;
+static struct binder_latency binder_call_latency;
+
+static void binder_latency_add(struct binder_latency *lat, ktime_t start)
+{
+	s64 us = ktime_us_delta(ktime_get(), start);
+	int bucket;
+
+	if (us < 0)
+		us = 0;
+	else if (us > UINT_MAX)
+		us = UINT_MAX;
+	bucket = min_t(int, fls(us), BINDER_LATENCY_BUCKETS - 1);
+	lat->hist[bucket]++;
+	lat->count++;
+	lat->total_us += us;
+	if (us > lat->max_us)
+		lat->max_us = us;
+}
+
 struct binder_transaction_log_entry {
 	int debug_id;
 	int call_type;
@@ -222,6 +273,7 @@ struct binder_node {
 	int internal_strong_refs;
 	int local_weak_refs;
 	int local_strong_refs;
+	int tmp_refs; /* of local_strong_refs, held while filling a buffer */
 	void __user *ptr;
 	void __user *cookie;
 	unsigned has_strong_ref:1;
@@ -294,6 +346,13 @@ struct binder_proc {
 	void *buffer;
 	ptrdiff_t user_buffer_offset;
 
+	/*
+	 * alloc_lock protects the buffer allocator below and nests inside
+	 * binder_lock.  binder_transaction() keeps holding it while it drops
+	 * binder_lock to fill a new buffer, so that the copy from the sender
+	 * does not stall unrelated processes.
+	 */
+	struct mutex alloc_lock;
 	struct list_head buffers;
 	struct rb_root free_buffers;
 	struct rb_root allocated_buffers;
@@ -312,6 +371,8 @@ struct binder_proc {
 	int ready_threads;
 	long default_priority;
 	struct dentry *debugfs_entry;
+	int tmp_ref; /* transactions filling a buffer without binder_lock */
+	int is_dead;
 };
 
 enum {
@@ -355,6 +416,8 @@ struct binder_transaction {
 	long	priority;
 	long	saved_priority;
 	uid_t	sender_euid;
+	ktime_t	start;
+	ktime_t	call_start;
 };
 
 static void
@@ -705,6 +768,7 @@ err_no_vma:
 	return -ENOMEM;
 }
 
+/* Called with proc->alloc_lock held, binder_lock need not be. */
 static struct binder_buffer *binder_alloc_buf(struct binder_proc *proc,
 					      size_t data_size,
 					      size_t offsets_size, int is_async)
@@ -1375,6 +1439,24 @@ static void binder_transaction_buffer_release(struct binder_proc *proc,
 	}
 }
 
+static void binder_stat_payload(struct binder_proc *proc,
+				struct binder_thread *thread,
+				struct binder_proc *target_proc,
+				struct binder_transaction_data *tr)
+{
+	size_t size = tr->data_size + tr->offsets_size;
+
+	binder_stats.copied_bytes += size;
+	proc->stats.copied_bytes += size;
+	if (size < binder_large_payload)
+		return;
+	binder_stats.large_copies++;
+	proc->stats.large_copies++;
+	binder_debug(BINDER_DEBUG_LARGE_PAYLOAD,
+		     "binder: %d:%d copied %zd byte payload to %d\n",
+		     proc->pid, thread->pid, size, target_proc->pid);
+}
+
 static void binder_transaction(struct binder_proc *proc,
 			       struct binder_thread *thread,
 			       struct binder_transaction_data *tr, int reply)
@@ -1488,14 +1570,8 @@ static void binder_transaction(struct binder_proc *proc,
 			}
 		}
 	}
-	if (target_thread) {
+	if (target_thread)
 		e->to_thread = target_thread->pid;
-		target_list = &target_thread->todo;
-		target_wait = &target_thread->wait;
-	} else {
-		target_list = &target_proc->todo;
-		target_wait = &target_proc->wait;
-	}
 	e->to_proc = target_proc->pid;
 
 	/* TODO: reuse incoming transaction for reply */
@@ -1543,32 +1619,100 @@ static void binder_transaction(struct binder_proc *proc,
 	t->code = tr->code;
 	t->flags = tr->flags;
 	t->priority = task_nice(current);
+	t->start = ktime_get();
+	if (reply)
+		t->call_start = in_reply_to->start;
+	if (target_node)
+		binder_inc_node(target_node, 1, 0, NULL);
+
+	/*
+	 * Allocate and fill the buffer with only the target's allocator
+	 * locked.  binder_lock goes first, so waiting for another sender's
+	 * copy into the same target doesn't stall everyone else.  tmp_ref
+	 * keeps target_proc itself around should it be released in the
+	 * meantime, and binder_alloc_buf() fails once its vma is gone;
+	 * everything else is revalidated once binder_lock is taken again.
+	 */
+	target_proc->tmp_ref++;
+	if (target_node)
+		target_node->tmp_refs++;
+	mutex_unlock(&binder_lock);
+	mutex_lock(&target_proc->alloc_lock);
+
+	return_error = BR_OK;
 	t->buffer = binder_alloc_buf(target_proc, tr->data_size,
 		tr->offsets_size, !reply && (t->flags & TF_ONE_WAY));
+	if (t->buffer) {
+		t->buffer->allow_user_free = 0;
+		t->buffer->debug_id = t->debug_id;
+		t->buffer->transaction = t;
+		t->buffer->target_node = target_node;
+
+		if (copy_from_user(t->buffer->data, tr->data.ptr.buffer,
+				   tr->data_size)) {
+			binder_user_error("binder: %d:%d got transaction with "
+				"invalid data ptr\n", proc->pid, thread->pid);
+			return_error = BR_FAILED_REPLY;
+		} else if (copy_from_user(t->buffer->data +
+					  ALIGN(tr->data_size, sizeof(void *)),
+					  tr->data.ptr.offsets,
+					  tr->offsets_size)) {
+			binder_user_error("binder: %d:%d got transaction with "
+				"invalid offsets ptr\n", proc->pid, thread->pid);
+			return_error = BR_FAILED_REPLY;
+		}
+	}
+
+	mutex_unlock(&target_proc->alloc_lock);
+	mutex_lock(&binder_lock);
+
+	target_proc->tmp_ref--;
+	if (target_node)
+		target_node->tmp_refs--;
+	if (target_proc->is_dead) {
+		/*
+		 * binder_deferred_release() already freed its buffers and
+		 * cleared t->buffer.  The node is dead but kept our
+		 * reference, drop it.
+		 */
+		if (target_node)
+			binder_dec_node(target_node, 1, 0);
+		if (!target_proc->tmp_ref)
+			kfree(target_proc);
+		return_error = BR_DEAD_REPLY;
+		goto err_dead_target_proc;
+	}
 	if (t->buffer == NULL) {
 		return_error = BR_FAILED_REPLY;
 		goto err_binder_alloc_buf_failed;
 	}
-	t->buffer->allow_user_free = 0;
-	t->buffer->debug_id = t->debug_id;
-	t->buffer->transaction = t;
-	t->buffer->target_node = target_node;
-	if (target_node)
-		binder_inc_node(target_node, 1, 0, NULL);
-
 	offp = (size_t *)(t->buffer->data + ALIGN(tr->data_size, sizeof(void *)));
-
-	if (copy_from_user(t->buffer->data, tr->data.ptr.buffer, tr->data_size)) {
-		binder_user_error("binder: %d:%d got transaction with invalid "
-			"data ptr\n", proc->pid, thread->pid);
-		return_error = BR_FAILED_REPLY;
+	if (return_error != BR_OK)
 		goto err_copy_data_failed;
+	binder_stat_payload(proc, thread, target_proc, tr);
+
+	if (reply) {
+		if (in_reply_to->from != target_thread) {
+			return_error = BR_DEAD_REPLY;
+			goto err_copy_data_failed;
+		}
+	} else if (target_thread) {
+		struct binder_transaction *tmp;
+
+		/* the thread we picked may have exited meanwhile */
+		target_thread = NULL;
+		for (tmp = thread->transaction_stack; tmp;
+		     tmp = tmp->from_parent)
+			if (tmp->from && tmp->from->proc == target_proc)
+				target_thread = tmp->from;
+		t->to_thread = target_thread;
 	}
-	if (copy_from_user(offp, tr->data.ptr.offsets, tr->offsets_size)) {
-		binder_user_error("binder: %d:%d got transaction with invalid "
-			"offsets ptr\n", proc->pid, thread->pid);
-		return_error = BR_FAILED_REPLY;
-		goto err_copy_data_failed;
+	if (target_thread) {
+		target_list = &target_thread->todo;
+		target_wait = &target_thread->wait;
+	} else {
+		target_list = &target_proc->todo;
+		target_wait = &target_proc->wait;
 	}
 	if (!IS_ALIGNED(tr->offsets_size, sizeof(size_t))) {
 		binder_user_error("binder: %d:%d got transaction with "
@@ -1672,6 +1816,7 @@ static void binder_transaction(struct binder_proc *proc,
 		case BINDER_TYPE_FD: {
 			int target_fd;
 			struct file *file;
+			size_t ref_size;
 
 			if (reply) {
 				if (!(in_reply_to->flags & TF_ACCEPT_FDS)) {
@@ -1701,6 +1846,9 @@ static void binder_transaction(struct binder_proc *proc,
 				goto err_get_unused_fd_failed;
 			}
 			task_fd_install(target_proc, target_fd, file);
+			ref_size = ashmem_file_size(file);
+			binder_stats.ref_bytes += ref_size;
+			proc->stats.ref_bytes += ref_size;
 			binder_debug(BINDER_DEBUG_TRANSACTION,
 				     "        fd %ld -> %d\n", fp->handle, target_fd);
 			/* TODO: fput? */
@@ -1751,8 +1899,14 @@ err_bad_offset:
 err_copy_data_failed:
 	binder_transaction_buffer_release(target_proc, t->buffer, offp);
 	t->buffer->transaction = NULL;
+	mutex_lock(&target_proc->alloc_lock);
 	binder_free_buf(target_proc, t->buffer);
+	mutex_unlock(&target_proc->alloc_lock);
+	target_node = NULL; /* released with the buffer */
 err_binder_alloc_buf_failed:
+	if (target_node)
+		binder_dec_node(target_node, 1, 0);
+err_dead_target_proc:
 	kfree(tcomplete);
 	binder_stats_deleted(BINDER_STAT_TRANSACTION_COMPLETE);
 err_alloc_tcomplete_failed:
@@ -1933,7 +2087,9 @@ int binder_thread_write(struct binder_proc *proc, struct binder_thread *thread,
 				return -EFAULT;
 			ptr += sizeof(void *);
 
+			mutex_lock(&proc->alloc_lock);
 			buffer = binder_buffer_lookup(proc, data_ptr);
+			mutex_unlock(&proc->alloc_lock);
 			if (buffer == NULL) {
 				binder_user_error("binder: %d:%d "
 					"BC_FREE_BUFFER u%p no match\n",
@@ -1964,7 +2120,9 @@ int binder_thread_write(struct binder_proc *proc, struct binder_thread *thread,
 					list_move_tail(buffer->target_node->async_todo.next, &thread->todo);
 			}
 			binder_transaction_buffer_release(proc, buffer, NULL);
+			mutex_lock(&proc->alloc_lock);
 			binder_free_buf(proc, buffer);
+			mutex_unlock(&proc->alloc_lock);
 			break;
 		}
 
@@ -2447,6 +2605,9 @@ retry:
 		ptr += sizeof(tr);
 
 		binder_stat_br(proc, thread, cmd);
+		binder_latency_add(&binder_delivery_latency, t->start);
+		if (cmd == BR_REPLY)
+			binder_latency_add(&binder_call_latency, t->call_start);
 		binder_debug(BINDER_DEBUG_TRANSACTION,
 			     "binder: %d:%d %s %d %d:%d, cmd %d"
 			     "size %zd-%zd ptr %p-%p\n",
@@ -2884,6 +3045,7 @@ static int binder_open(struct inode *nodp, struct file *filp)
 	proc->tsk = current;
 	INIT_LIST_HEAD(&proc->todo);
 	init_waitqueue_head(&proc->wait);
+	mutex_init(&proc->alloc_lock);
 	proc->default_priority = task_nice(current);
 	mutex_lock(&binder_lock);
 	binder_stats_created(BINDER_STAT_PROC);
@@ -2973,7 +3135,7 @@ static void binder_deferred_release(struct binder_proc *proc)
 		nodes++;
 		rb_erase(&node->rb_node, &proc->nodes);
 		list_del_init(&node->work.entry);
-		if (hlist_empty(&node->refs)) {
+		if (hlist_empty(&node->refs) && !node->tmp_refs) {
 			kfree(node);
 			binder_stats_deleted(BINDER_STAT_NODE);
 		} else {
@@ -2981,7 +3143,8 @@ static void binder_deferred_release(struct binder_proc *proc)
 			int death = 0;
 
 			node->proc = NULL;
-			node->local_strong_refs = 0;
+			/* transactions still filling a buffer drop theirs */
+			node->local_strong_refs = node->tmp_refs;
 			node->local_weak_refs = 0;
 			hlist_add_head(&node->dead_node, &binder_dead_nodes);
 
@@ -3013,6 +3176,7 @@ static void binder_deferred_release(struct binder_proc *proc)
 	binder_release_work(&proc->todo);
 	buffers = 0;
 
+	mutex_lock(&proc->alloc_lock);
 	while ((n = rb_first(&proc->allocated_buffers))) {
 		struct binder_buffer *buffer = rb_entry(n, struct binder_buffer,
 							rb_node);
@@ -3051,6 +3215,7 @@ static void binder_deferred_release(struct binder_proc *proc)
 		kfree(proc->pages);
 		vfree(proc->buffer);
 	}
+	mutex_unlock(&proc->alloc_lock);
 
 	put_task_struct(proc->tsk);
 
@@ -3061,7 +3226,9 @@ static void binder_deferred_release(struct binder_proc *proc)
 		     proc->pid, threads, nodes, incoming_refs, outgoing_refs,
 		     active_transactions, buffers, page_count);
 
-	kfree(proc);
+	proc->is_dead = 1;
+	if (!proc->tmp_ref)
+		kfree(proc);
 }
 
 static void binder_deferred_func(struct work_struct *work)
@@ -3259,6 +3426,7 @@ static void print_binder_proc(struct seq_file *m,
 	struct rb_node *n;
 	size_t start_pos = m->count;
 	size_t header_pos;
+	int do_lock = !binder_debug_no_lock;
 
 	seq_printf(m, "proc %d\n", proc->pid);
 	header_pos = m->count;
@@ -3279,9 +3447,13 @@ static void print_binder_proc(struct seq_file *m,
 			print_binder_ref(m, rb_entry(n, struct binder_ref,
 						     rb_node_desc));
 	}
+	if (do_lock)
+		mutex_lock(&proc->alloc_lock);
 	for (n = rb_first(&proc->allocated_buffers); n != NULL; n = rb_next(n))
 		print_binder_buffer(m, "  buffer",
 				    rb_entry(n, struct binder_buffer, rb_node));
+	if (do_lock)
+		mutex_unlock(&proc->alloc_lock);
 	list_for_each_entry(w, &proc->todo, entry)
 		print_binder_work(m, "  ", "  pending transaction", w);
 	list_for_each_entry(w, &proc->delivered_death, entry) {
@@ -3375,6 +3547,13 @@ static void print_binder_stats(struct seq_file *m, const char *prefix,
 				stats->obj_created[i] - stats->obj_deleted[i],
 				stats->obj_created[i]);
 	}
+
+	if (stats->copied_bytes || stats->ref_bytes)
+		seq_printf(m, "%spayload: copied %llu by reference %llu "
+			   "large copies %d\n", prefix,
+			   (unsigned long long)stats->copied_bytes,
+			   (unsigned long long)stats->ref_bytes,
+			   stats->large_copies);
 }
 
 static void print_binder_proc_stats(struct seq_file *m,
@@ -3383,6 +3562,7 @@ static void print_binder_proc_stats(struct seq_file *m,
 	struct binder_work *w;
 	struct rb_node *n;
 	int count, strong, weak;
+	int do_lock = !binder_debug_no_lock;
 
 	seq_printf(m, "proc %d\n", proc->pid);
 	count = 0;
@@ -3411,8 +3591,12 @@ static void print_binder_proc_stats(struct seq_file *m,
 	seq_printf(m, "  refs: %d s %d w %d\n", count, strong, weak);
 
 	count = 0;
+	if (do_lock)
+		mutex_lock(&proc->alloc_lock);
 	for (n = rb_first(&proc->allocated_buffers); n != NULL; n = rb_next(n))
 		count++;
+	if (do_lock)
+		mutex_unlock(&proc->alloc_lock);
 	seq_printf(m, "  buffers: %d\n", count);
 
 	count = 0;
@@ -3506,6 +3690,42 @@ static int binder_proc_show(struct seq_file *m, void *unused)
 	return 0;
 }
 
+static void print_binder_latency(struct seq_file *m, const char *name,
+				 struct binder_latency *lat)
+{
+	int i;
+
+	seq_printf(m, "%s: count %u avg %llu max %u\n", name, lat->count,
+		   lat->count ? div_u64(lat->total_us, lat->count) : 0,
+		   lat->max_us);
+	for (i = 0; i < BINDER_LATENCY_BUCKETS; i++) {
+		if (!lat->hist[i])
+			continue;
+		if (i == 0)
+			seq_printf(m, "  %10u: %u\n", 0, lat->hist[i]);
+		else if (i == BINDER_LATENCY_BUCKETS - 1)
+			seq_printf(m, "  %10u+: %u\n", 1U << (i - 1),
+				   lat->hist[i]);
+		else
+			seq_printf(m, "  %10u-%u: %u\n", 1U << (i - 1),
+				   (1U << i) - 1, lat->hist[i]);
+	}
+}
+
+static int binder_latency_show(struct seq_file *m, void *unused)
+{
+	int do_lock = !binder_debug_no_lock;
+
+	if (do_lock)
+		mutex_lock(&binder_lock);
+	seq_puts(m, "binder latency (usecs):\n");
+	print_binder_latency(m, "delivery", &binder_delivery_latency);
+	print_binder_latency(m, "call", &binder_call_latency);
+	if (do_lock)
+		mutex_unlock(&binder_lock);
+	return 0;
+}
+
 static void print_binder_transaction_log_entry(struct seq_file *m,
 					struct binder_transaction_log_entry *e)
 {
@@ -3551,6 +3771,7 @@ BINDER_DEBUG_ENTRY(state);
 BINDER_DEBUG_ENTRY(stats);
 BINDER_DEBUG_ENTRY(transactions);
 BINDER_DEBUG_ENTRY(transaction_log);
+BINDER_DEBUG_ENTRY(latency);
 
 static int __init binder_init(void)
 {
@@ -3591,6 +3812,11 @@ static int __init binder_init(void)
 				    binder_debugfs_dir_entry_root,
 				    &binder_transaction_log_failed,
 				    &binder_transaction_log_fops);
+		debugfs_create_file("latency",
+				    S_IRUGO,
+				    binder_debugfs_dir_entry_root,
+				    NULL,
+				    &binder_latency_fops);
 	}
 	return ret;
 }
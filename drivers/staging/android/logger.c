@@ -24,39 +24,66 @@
 #include <linux/uaccess.h>
 #include <linux/poll.h>
 #include <linux/slab.h>
+#include <linux/spinlock.h>
 #include <linux/time.h>
+#include <linux/timer.h>
 #include "logger.h"
 
 #include <asm/ioctls.h>
 
+/*
+ * Payloads up to this many bytes are staged on the writer's stack; longer
+ * ones go through a kmalloc'ed buffer. Either way the copy from user-space
+ * happens before the log lock is taken, so the lock is never held across a
+ * page fault.
+ */
+#define LOGGER_STACK_PAYLOAD	256
+
+/*
+ * Blocked readers are woken once 'wake_bytes' have been written since the
+ * last wakeup, or 'wake_delay_ms' after the first unannounced write,
+ * whichever comes first. A delay of 0 wakes them on every write.
+ */
+static int logger_wake_bytes = 4096;
+module_param_named(wake_bytes, logger_wake_bytes, int, S_IWUSR | S_IRUGO);
+
+static int logger_wake_delay_ms = 20;
+module_param_named(wake_delay_ms, logger_wake_delay_ms, int,
+		   S_IWUSR | S_IRUGO);
+
 /*
  * struct logger_log - represents a specific log, such as 'main' or 'radio'
  *
  * This structure lives from module insertion until module removal, so it does
  * not need additional reference counting. The structure is protected by the
- * mutex 'mutex'.
+ * spinlock 'lock'.
  */
 struct logger_log {
 	unsigned char 		*buffer;/* the ring buffer itself */
 	struct miscdevice	misc;	/* misc device representing the log */
 	wait_queue_head_t	wq;	/* wait queue for readers */
 	struct list_head	readers; /* this log's readers */
-	struct mutex		mutex;	/* mutex protecting buffer */
+	spinlock_t		lock;	/* lock protecting buffer */
 	size_t			w_off;	/* current write head offset */
 	size_t			head;	/* new readers start here */
 	size_t			size;	/* size of the log */
+	size_t			unwoken; /* bytes written since last wakeup */
+	struct timer_list	wake_timer; /* deferred reader wakeup */
 };
 
 /*
  * struct logger_reader - a logging device open for reading
  *
  * This object lives from open to release, so we don't need additional
- * reference counting. The structure is protected by log->mutex.
+ * reference counting. 'list' and 'r_off' are protected by log->lock,
+ * 'mutex' serializes readers sharing the file and guards 'buf'.
  */
 struct logger_reader {
 	struct logger_log	*log;	/* associated log */
 	struct list_head	list;	/* entry in logger_log's list */
 	size_t			r_off;	/* current read head offset */
+	struct mutex		mutex;	/* serializes read() on this reader */
+	unsigned char		*buf;	/* one entry, copied out under lock */
 };
 
 /* logger_offset - returns index 'n' into the log via (optimized) modulus */
@@ -89,7 +116,7 @@ static inline struct logger_log *file_get_log(struct file *file)
  * get_entry_len - Grabs the length of the payload of the next entry starting
  * from 'off'.
  *
- * Caller needs to hold log->mutex.
+ * Caller needs to hold log->lock.
  */
 static __u32 get_entry_len(struct logger_log *log, size_t off)
 {
@@ -108,15 +135,13 @@ static __u32 get_entry_len(struct logger_log *log, size_t off)
 }
 
 /*
- * do_read_log_to_user - reads exactly 'count' bytes from 'log' into the
- * user-space buffer 'buf'. Returns 'count' on success.
+ * do_read_log - reads exactly 'count' bytes from 'log' into the reader's
+ * bounce buffer and advances its read head.
  *
- * Caller must hold log->mutex.
+ * Caller must hold log->lock.
  */
-static ssize_t do_read_log_to_user(struct logger_log *log,
-				   struct logger_reader *reader,
-				   char __user *buf,
-				   size_t count)
+static void do_read_log(struct logger_log *log, struct logger_reader *reader,
+			size_t count)
 {
 	size_t len;
 
@@ -126,20 +151,16 @@ static ssize_t do_read_log_to_user(struct logger_log *log,
 	 * the log, whichever comes first.
 	 */
 	len = min(count, log->size - reader->r_off);
-	if (copy_to_user(buf, log->buffer + reader->r_off, len))
-		return -EFAULT;
+	memcpy(reader->buf, log->buffer + reader->r_off, len);
 
 	/*
 	 * Second, we read any remaining bytes, starting back at the head of
 	 * the log.
 	 */
 	if (count != len)
-		if (copy_to_user(buf + len, log->buffer, count - len))
-			return -EFAULT;
+		memcpy(reader->buf + len, log->buffer, count - len);
 
 	reader->r_off = logger_offset(reader->r_off + count);
-
-	return count;
 }
 
 /*
@@ -162,13 +183,14 @@ static ssize_t logger_read(struct file *file, char __user *buf,
 	ssize_t ret;
 	DEFINE_WAIT(wait);
 
+	mutex_lock(&reader->mutex);
 start:
 	while (1) {
 		prepare_to_wait(&log->wq, &wait, TASK_INTERRUPTIBLE);
 
-		mutex_lock(&log->mutex);
+		spin_lock(&log->lock);
 		ret = (log->w_off == reader->r_off);
-		mutex_unlock(&log->mutex);
+		spin_unlock(&log->lock);
 		if (!ret)
 			break;
 
@@ -187,28 +209,33 @@ start:
 
 	finish_wait(&log->wq, &wait);
 	if (ret)
-		return ret;
+		goto out;
 
-	mutex_lock(&log->mutex);
+	spin_lock(&log->lock);
 
 	/* is there still something to read or did we race? */
 	if (unlikely(log->w_off == reader->r_off)) {
-		mutex_unlock(&log->mutex);
+		spin_unlock(&log->lock);
 		goto start;
 	}
 
 	/* get the size of the next entry */
 	ret = get_entry_len(log, reader->r_off);
 	if (count < ret) {
+		spin_unlock(&log->lock);
 		ret = -EINVAL;
 		goto out;
 	}
 
-	/* get exactly one entry from the log */
-	ret = do_read_log_to_user(log, reader, buf, ret);
+	/* get exactly one entry from the log, copy it out once unlocked */
+	do_read_log(log, reader, ret);
+	spin_unlock(&log->lock);
+
+	if (copy_to_user(buf, reader->buf, ret))
+		ret = -EFAULT;
 
 out:
-	mutex_unlock(&log->mutex);
+	mutex_unlock(&reader->mutex);
 
 	return ret;
 }
@@ -217,7 +244,7 @@ out:
  * get_next_entry - return the offset of the first valid entry at least 'len'
  * bytes after 'off'.
  *
- * Caller must hold log->mutex.
+ * Caller must hold log->lock.
  */
 static size_t get_next_entry(struct logger_log *log, size_t off, size_t len)
 {
@@ -255,7 +282,7 @@ static inline int clock_interval(size_t a, size_t b, size_t c)
  * We do this by "pulling forward" the readers and start head to the first
  * entry after the new write head.
  *
- * The caller needs to hold log->mutex.
+ * The caller needs to hold log->lock.
  */
 static void fix_up_readers(struct logger_log *log, size_t len)
 {
@@ -274,7 +301,7 @@ static void fix_up_readers(struct logger_log *log, size_t len)
 /*
  * do_write_log - writes 'len' bytes from 'buf' to 'log'
  *
- * The caller needs to hold log->mutex.
+ * The caller needs to hold log->lock.
  */
 static void do_write_log(struct logger_log *log, const void *buf, size_t count)
 {
@@ -291,29 +318,32 @@ static void do_write_log(struct logger_log *log, const void *buf, size_t count)
 }
 
 /*
- * do_write_log_user - writes 'len' bytes from the user-space buffer 'buf' to
- * the log 'log'
- *
- * The caller needs to hold log->mutex.
- *
- * Returns 'count' on success, negative error code on failure.
+ * logger_wake_timer - deferred wakeup of blocked readers, armed by writers
+ * that did not reach the wakeup watermark on their own.
  */
-static ssize_t do_write_log_from_user(struct logger_log *log,
-				      const void __user *buf, size_t count)
+static void logger_wake_timer(unsigned long data)
 {
-	size_t len;
-
-	len = min(count, log->size - log->w_off);
-	if (len && copy_from_user(log->buffer + log->w_off, buf, len))
-		return -EFAULT;
-
-	if (count != len)
-		if (copy_from_user(log->buffer, buf + len, count - len))
-			return -EFAULT;
+	struct logger_log *log = (struct logger_log *) data;
 
-	log->w_off = logger_offset(log->w_off + count);
+	wake_up_interruptible(&log->wq);
+}
 
-	return count;
+/*
+ * logger_kick_readers - wakes blocked readers now if enough has been written
+ * since the last wakeup, otherwise makes sure the wake timer is running.
+ *
+ * 'wake' is the caller's verdict on the watermark, taken under log->lock.
+ */
+static void logger_kick_readers(struct logger_log *log, int wake)
+{
+	if (!waitqueue_active(&log->wq))
+		return;
+
+	if (wake || logger_wake_delay_ms <= 0)
+		wake_up_interruptible(&log->wq);
+	else if (!timer_pending(&log->wake_timer))
+		mod_timer(&log->wake_timer,
+			  jiffies + msecs_to_jiffies(logger_wake_delay_ms));
 }
 
 /*
@@ -325,10 +355,12 @@ ssize_t logger_aio_write(struct kiocb *iocb, const struct iovec *iov,
 			 unsigned long nr_segs, loff_t ppos)
 {
 	struct logger_log *log = file_get_log(iocb->ki_filp);
-	size_t orig = log->w_off;
+	unsigned char stack_payload[LOGGER_STACK_PAYLOAD];
+	unsigned char *payload = stack_payload;
 	struct logger_entry header;
 	struct timespec now;
 	ssize_t ret = 0;
+	int wake;
 
 	now = current_kernel_time();
 
@@ -342,41 +374,57 @@ ssize_t logger_aio_write(struct kiocb *iocb, const struct iovec *iov,
 	if (unlikely(!header.len))
 		return 0;
 
-	mutex_lock(&log->mutex);
+	if (header.len > sizeof(stack_payload)) {
+		payload = kmalloc(header.len, GFP_KERNEL);
+		if (unlikely(!payload))
+			return -ENOMEM;
+	}
 
 	/*
-	 * Fix up any readers, pulling them forward to the first readable
-	 * entry after (what will be) the new write offset. We do this now
-	 * because if we partially fail, we can end up with clobbered log
-	 * entries that encroach on readable buffer.
+	 * Gather the whole payload first. A faulting user buffer then fails
+	 * the write before anything touched the log, so nothing needs to be
+	 * rolled back and readers never see a partial entry.
 	 */
-	fix_up_readers(log, sizeof(struct logger_entry) + header.len);
-
-	do_write_log(log, &header, sizeof(struct logger_entry));
-
 	while (nr_segs-- > 0) {
 		size_t len;
-		ssize_t nr;
 
 		/* figure out how much of this vector we can keep */
 		len = min_t(size_t, iov->iov_len, header.len - ret);
 
-		/* write out this segment's payload */
-		nr = do_write_log_from_user(log, iov->iov_base, len);
-		if (unlikely(nr < 0)) {
-			log->w_off = orig;
-			mutex_unlock(&log->mutex);
-			return nr;
+		if (len && copy_from_user(payload + ret, iov->iov_base, len)) {
+			ret = -EFAULT;
+			goto out;
 		}
 
 		iov++;
-		ret += nr;
+		ret += len;
 	}
+	header.len = ret;
 
-	mutex_unlock(&log->mutex);
+	spin_lock(&log->lock);
 
-	/* wake up any blocked readers */
-	wake_up_interruptible(&log->wq);
+	/*
+	 * Fix up any readers, pulling them forward to the first readable
+	 * entry after (what will be) the new write offset.
+	 */
+	fix_up_readers(log, sizeof(struct logger_entry) + header.len);
+
+	do_write_log(log, &header, sizeof(struct logger_entry));
+	do_write_log(log, payload, header.len);
+
+	log->unwoken += sizeof(struct logger_entry) + header.len;
+	wake = log->unwoken >= logger_wake_bytes;
+	if (wake)
+		log->unwoken = 0;
+
+	spin_unlock(&log->lock);
+
+	/* wake up any blocked readers, or have the timer do it shortly */
+	logger_kick_readers(log, wake);
+
+out:
+	if (payload != stack_payload)
+		kfree(payload);
 
 	return ret;
 }
@@ -408,13 +456,20 @@ static int logger_open(struct inode *inode, struct file *file)
 		if (!reader)
 			return -ENOMEM;
 
+		reader->buf = kmalloc(LOGGER_ENTRY_MAX_LEN, GFP_KERNEL);
+		if (!reader->buf) {
+			kfree(reader);
+			return -ENOMEM;
+		}
+
 		reader->log = log;
 		INIT_LIST_HEAD(&reader->list);
+		mutex_init(&reader->mutex);
 
-		mutex_lock(&log->mutex);
+		spin_lock(&log->lock);
 		reader->r_off = log->head;
 		list_add_tail(&reader->list, &log->readers);
-		mutex_unlock(&log->mutex);
+		spin_unlock(&log->lock);
 
 		file->private_data = reader;
 	} else
@@ -432,7 +487,12 @@ static int logger_release(struct inode *ignored, struct file *file)
 {
 	if (file->f_mode & FMODE_READ) {
 		struct logger_reader *reader = file->private_data;
+		struct logger_log *log = reader->log;
+
+		spin_lock(&log->lock);
 		list_del(&reader->list);
+		spin_unlock(&log->lock);
+		kfree(reader->buf);
 		kfree(reader);
 	}
 
@@ -462,10 +522,10 @@ static unsigned int logger_poll(struct file *file, poll_table *wait)
 
 	poll_wait(file, &log->wq, wait);
 
-	mutex_lock(&log->mutex);
+	spin_lock(&log->lock);
 	if (log->w_off != reader->r_off)
 		ret |= POLLIN | POLLRDNORM;
-	mutex_unlock(&log->mutex);
+	spin_unlock(&log->lock);
 
 	return ret;
 }
@@ -476,7 +536,7 @@ static long logger_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 	struct logger_reader *reader;
 	long ret = -ENOTTY;
 
-	mutex_lock(&log->mutex);
+	spin_lock(&log->lock);
 
 	switch (cmd) {
 	case LOGGER_GET_LOG_BUF_SIZE:
@@ -516,7 +576,7 @@ static long logger_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 		break;
 	}
 
-	mutex_unlock(&log->mutex);
+	spin_unlock(&log->lock);
 
 	return ret;
 }
@@ -549,10 +609,12 @@ static struct logger_log VAR = { \
 	}, \
 	.wq = __WAIT_QUEUE_HEAD_INITIALIZER(VAR .wq), \
 	.readers = LIST_HEAD_INIT(VAR .readers), \
-	.mutex = __MUTEX_INITIALIZER(VAR .mutex), \
+	.lock = __SPIN_LOCK_UNLOCKED(VAR .lock), \
 	.w_off = 0, \
 	.head = 0, \
 	.size = SIZE, \
+	.wake_timer = TIMER_INITIALIZER(logger_wake_timer, 0, \
+					(unsigned long) &VAR), \
 };
 
 DEFINE_LOGGER_DEVICE(log_main, LOGGER_LOG_MAIN, 256*1024)
@@ -131,13 +131,433 @@ static int s3cfb_draw_logo(struct fb_info *fb)
 	return 0;
 }
 #endif
+static ATOMIC_NOTIFIER_HEAD(s3cfb_vsync_notifier);
+static atomic_t s3cfb_vsync_users = ATOMIC_INIT(0);
+static struct s3cfb_global *s3cfb_vsync_fbdev;
+
+/*
+ * The frame interrupt stays on while userspace asked for it, an
+ * in-kernel user is registered, a window waits for vsyncs or the caller
+ * needs it (@force).
+ */
+static inline bool s3cfb_flip_pending(struct s3cfb_flip_queue *q)
+{
+	return q->latched || q->count;
+}
+
+/* a window waits for vsyncs: flips are queued or a buffer is retiring */
+static bool s3cfb_vsync_needed(struct s3cfb_global *fbdev)
+{
+	struct s3c_platform_fb *pdata = to_fb_plat(fbdev->dev);
+	struct s3cfb_window *win;
+	int i;
+
+	for (i = 0; i < pdata->nr_wins; i++) {
+		win = fbdev->fb[i]->par;
+		if (win->retired || s3cfb_flip_pending(&win->flip))
+			return true;
+	}
+
+	return false;
+}
+
+static void s3cfb_update_vsync_int(struct s3cfb_global *fbdev, bool force)
+{
+	unsigned long flags;
+	int on;
+
+	spin_lock_irqsave(&fbdev->flip_lock, flags);
+
+	on = fbdev->vsync_user || force || atomic_read(&s3cfb_vsync_users) ||
+	     s3cfb_vsync_needed(fbdev);
+	if (!on)
+		fbdev->vsync_ts = ktime_set(0, 0);
+
+	/* late resume turns it back on */
+	if (fbdev->enabled) {
+		if (on)
+			s3cfb_set_global_interrupt(fbdev, 1);
+		s3cfb_set_vsync_interrupt(fbdev, on);
+	}
+
+	spin_unlock_irqrestore(&fbdev->flip_lock, flags);
+}
+
+int s3cfb_register_vsync_notifier(struct notifier_block *nb)
+{
+	int ret;
+
+	ret = atomic_notifier_chain_register(&s3cfb_vsync_notifier, nb);
+	if (!ret) {
+		atomic_inc(&s3cfb_vsync_users);
+		if (s3cfb_vsync_fbdev)
+			s3cfb_update_vsync_int(s3cfb_vsync_fbdev, false);
+	}
+
+	return ret;
+}
+EXPORT_SYMBOL(s3cfb_register_vsync_notifier);
+
+int s3cfb_unregister_vsync_notifier(struct notifier_block *nb)
+{
+	int ret;
+
+	ret = atomic_notifier_chain_unregister(&s3cfb_vsync_notifier, nb);
+	if (!ret) {
+		atomic_dec(&s3cfb_vsync_users);
+		if (s3cfb_vsync_fbdev)
+			s3cfb_update_vsync_int(s3cfb_vsync_fbdev, false);
+	}
+
+	return ret;
+}
+EXPORT_SYMBOL(s3cfb_unregister_vsync_notifier);
+
+/*
+ * A window that shows a new flip again within this many vsyncs of the
+ * previous one is taken to be animating, and the frames it repeated in
+ * between are counted as missed.
+ */
+#define S3CFB_FLIP_JANK_VSYNCS	4
+
+/*
+ * Without flips, commits or damage for this long the panel is switched
+ * to fbdev->idle_refresh_hz, if set.
+ */
+#define S3CFB_IDLE_MS		500
+
+/* the content frame rate is measured over this period */
+#define S3CFB_RATE_MS		1000
+
+/*
+ * At a reduced rate, faster content measures the same as content that
+ * really runs at that rate. Go back to lcd->freq to find out only after
+ * this many periods in a row that may have been held back, and wait
+ * twice as long each time doing so finds the content rate unchanged.
+ */
+#define S3CFB_RATE_HOLD		2
+#define S3CFB_RATE_BACKOFF_MAX	3
+
+static inline bool s3cfb_dynamic_refresh(struct s3cfb_global *fbdev)
+{
+	return fbdev->lcd->min_freq > 0 &&
+		fbdev->lcd->min_freq < fbdev->lcd->freq;
+}
+
+/*
+ * Only updates through this driver are seen. FIMC feeding a window or
+ * driving flips through the vsync notifier bypasses it.
+ */
+static bool s3cfb_external_update(struct s3cfb_global *fbdev)
+{
+	struct s3c_platform_fb *pdata = to_fb_plat(fbdev->dev);
+	struct s3cfb_window *win;
+	int i;
+
+	if (atomic_read(&s3cfb_vsync_users))
+		return true;
+
+	for (i = 0; i < pdata->nr_wins; i++) {
+		win = fbdev->fb[i]->par;
+		if (win->enabled && win->path != DATA_PATH_DMA)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Lowest refresh rate the panel allows that is a whole multiple of the
+ * content rate, so every frame is shown for the same number of vsyncs.
+ */
+static u32 s3cfb_pick_refresh(struct s3cfb_global *fbdev, u32 content_hz)
+{
+	struct s3cfb_lcd *lcd = fbdev->lcd;
+	u32 hz;
+
+	if (!content_hz || content_hz >= lcd->freq * 9 / 10)
+		return lcd->freq;
+
+	for (hz = content_hz; hz <= lcd->freq; hz += content_hz) {
+		if (hz >= lcd->min_freq)
+			return hz;
+	}
+
+	return lcd->freq;
+}
+
+/* called with flip_lock held */
+static void s3cfb_apply_refresh(struct s3cfb_global *fbdev, u32 hz)
+{
+	if (hz == fbdev->refresh_hz)
+		return;
+
+	/* the idle rate stays until the next update restores refresh_hz */
+	if (!fbdev->refresh_idle) {
+		if (s3cfb_set_refresh(fbdev, hz))
+			return;
+		fbdev->vsync_ts = ktime_set(0, 0);
+	}
+
+	fbdev->refresh_hz = hz;
+	fbdev->refresh.switches++;
+}
+
+/* called with flip_lock held */
+static void s3cfb_note_activity(struct s3cfb_global *fbdev)
+{
+	fbdev->last_activity = fbdev->vsync_count;
+
+	if (!fbdev->refresh_idle)
+		return;
+
+	s3cfb_set_refresh(fbdev, fbdev->refresh_hz);
+	fbdev->refresh_idle = 0;
+	fbdev->vsync_ts = ktime_set(0, 0);
+}
+
+/* called with flip_lock held for each new frame of content */
+static void s3cfb_note_frame(struct s3cfb_global *fbdev)
+{
+	fbdev->refresh.frames++;
+	s3cfb_note_activity(fbdev);
+}
+
+/* called from the frame interrupt with flip_lock held */
+static void s3cfb_idle_vsync(struct s3cfb_global *fbdev)
+{
+	u32 idle_vsyncs;
+
+	if (fbdev->refresh_idle) {
+		fbdev->damage.idle_vsyncs++;
+		fbdev->damage.idle_ns += fbdev->vsync_period_ns;
+		return;
+	}
+
+	if (!fbdev->idle_refresh_hz)
+		return;
+
+	if (s3cfb_external_update(fbdev)) {
+		fbdev->last_activity = fbdev->vsync_count;
+		return;
+	}
+
+	idle_vsyncs = fbdev->lcd->freq * S3CFB_IDLE_MS / MSEC_PER_SEC;
+	if (fbdev->vsync_count - fbdev->last_activity < idle_vsyncs)
+		return;
+
+	if (s3cfb_set_refresh(fbdev, fbdev->idle_refresh_hz))
+		return;
+
+	fbdev->refresh_idle = 1;
+	fbdev->vsync_ts = ktime_set(0, 0);
+	fbdev->damage.idle_entries++;
+}
+
+/*
+ * Called from the frame interrupt with flip_lock held. Follows the
+ * content rate hint if there is one, otherwise the rate at which new
+ * frames arrived over the last S3CFB_RATE_MS. The divider is updated
+ * here, between frames, and latched by FIMD at the next frame start.
+ */
+static void s3cfb_rate_vsync(struct s3cfb_global *fbdev, ktime_t now)
+{
+	struct s3cfb_lcd *lcd = fbdev->lcd;
+	s64 elapsed;
+	u32 fps, hz, probe_hz;
+
+	if (fbdev->refresh_idle || fbdev->refresh_hz < lcd->freq) {
+		fbdev->refresh.reduced_vsyncs++;
+		fbdev->refresh.reduced_ns += fbdev->vsync_period_ns;
+	}
+
+	if (!s3cfb_dynamic_refresh(fbdev))
+		return;
+
+	elapsed = ktime_to_ns(ktime_sub(now, fbdev->refresh.start));
+	if (elapsed < S3CFB_RATE_MS * NSEC_PER_MSEC)
+		return;
+
+	fps = div_u64((u64)fbdev->refresh.frames * NSEC_PER_SEC +
+		      elapsed / 2, elapsed);
+	fbdev->refresh.frames = 0;
+	fbdev->refresh.start = now;
+
+	probe_hz = fbdev->refresh.probe_hz;
+	fbdev->refresh.probe_hz = 0;
+
+	if (fbdev->content_hint)
+		hz = s3cfb_pick_refresh(fbdev, fbdev->content_hint);
+	else if (s3cfb_external_update(fbdev))
+		hz = lcd->freq;
+	else if (fbdev->refresh_hz < lcd->freq &&
+		 fps * 10 >= fbdev->refresh_hz * 9) {
+		/* maybe held back by the current rate */
+		if (++fbdev->refresh.held <
+		    S3CFB_RATE_HOLD << fbdev->refresh.backoff)
+			return;
+		fbdev->refresh.probe_hz = fbdev->refresh_hz;
+		hz = lcd->freq;
+	} else {
+		hz = s3cfb_pick_refresh(fbdev, fps);
+
+		/* first period back at lcd->freq after being held back */
+		if (probe_hz && abs((int)hz - (int)probe_hz) <= 3) {
+			if (fbdev->refresh.backoff < S3CFB_RATE_BACKOFF_MAX)
+				fbdev->refresh.backoff++;
+		} else if (probe_hz) {
+			fbdev->refresh.backoff = 0;
+		}
+	}
+	fbdev->refresh.held = 0;
+
+	/* ignore jitter in the measured rate */
+	if (hz != lcd->freq && !fbdev->content_hint &&
+	    abs((int)hz - (int)fbdev->refresh_hz) <= 3)
+		return;
+
+	s3cfb_apply_refresh(fbdev, hz);
+}
+
+/* called with flip_lock held */
+static void s3cfb_flip_program(struct s3cfb_global *fbdev, int id,
+			       unsigned int yoffset)
+{
+	struct fb_info *fb = fbdev->fb[id];
+	struct s3cfb_window *win = fb->par;
+
+	if (win->owner == DMA_MEM_OTHER)
+		fb->fix.smem_start = win->other_mem_addr;
+
+	fb->var.yoffset = yoffset;
+	s3cfb_set_buffer_address(fbdev, id);
+}
+
+/* called with flip_lock held */
+static void s3cfb_flip_complete(struct s3cfb_global *fbdev,
+				struct s3cfb_flip_queue *q, ktime_t now)
+{
+	unsigned int idx = q->latched % S3CFB_FLIP_HISTORY;
+	u32 gap = fbdev->vsync_count - q->shown_vsync;
+
+	q->done_ts[idx] = now;
+	q->done_vsync[idx] = fbdev->vsync_count;
+	q->done = q->latched;
+	q->latched = 0;
+
+	if (q->shown_vsync && gap > 1 && gap <= S3CFB_FLIP_JANK_VSYNCS)
+		fbdev->repeated_frames += gap - 1;
+
+	q->shown_vsync = fbdev->vsync_count;
+	fbdev->flips++;
+}
+
+/*
+ * The frame interrupt fires when FIMD has just latched the shadow
+ * registers for the frame now being scanned out, so the flip written
+ * before it is on screen and the next queued one can be programmed.
+ */
+static void s3cfb_flip_vsync(struct s3cfb_global *fbdev, ktime_t now)
+{
+	struct s3c_platform_fb *pdata = to_fb_plat(fbdev->dev);
+	struct s3cfb_flip_queue *q;
+	s64 delta;
+	int i;
+
+	spin_lock(&fbdev->flip_lock);
+
+	if (ktime_to_ns(fbdev->vsync_ts) && fbdev->vsync_period_ns) {
+		delta = ktime_to_ns(ktime_sub(now, fbdev->vsync_ts));
+		if (delta > fbdev->vsync_period_ns * 3 / 2)
+			fbdev->missed_vsyncs += div_u64(delta +
+				fbdev->vsync_period_ns / 2,
+				fbdev->vsync_period_ns) - 1;
+	}
+
+	fbdev->vsync_count++;
+	fbdev->vsync_ts = now;
+
+	for (i = 0; i < pdata->nr_wins; i++) {
+		q = &((struct s3cfb_window *)fbdev->fb[i]->par)->flip;
+
+		if (q->latched)
+			s3cfb_flip_complete(fbdev, q, now);
+
+		if (q->count) {
+			s3cfb_flip_program(fbdev, i, q->yoffset[q->head]);
+			q->latched = q->seq[q->head];
+			q->head = (q->head + 1) % S3CFB_FLIP_DEPTH;
+			q->count--;
+		}
+	}
+
+	s3cfb_rate_vsync(fbdev, now);
+	s3cfb_idle_vsync(fbdev);
+
+	spin_unlock(&fbdev->flip_lock);
+}
+
+/*
+ * Nothing is scanned out any more: report every outstanding flip as
+ * done so that waiters return, and restart the missed vsync accounting.
+ */
+static void s3cfb_flip_flush(struct s3cfb_global *fbdev)
+{
+	struct s3c_platform_fb *pdata = to_fb_plat(fbdev->dev);
+	struct s3cfb_flip_queue *q;
+	unsigned long flags;
+	ktime_t now = ktime_get();
+	int i;
+
+	spin_lock_irqsave(&fbdev->flip_lock, flags);
+
+	fbdev->enabled = 0;
+
+	for (i = 0; i < pdata->nr_wins; i++) {
+		q = &((struct s3cfb_window *)fbdev->fb[i]->par)->flip;
+
+		while (s3cfb_flip_pending(q)) {
+			if (!q->latched) {
+				q->latched = q->seq[q->head];
+				q->head = (q->head + 1) % S3CFB_FLIP_DEPTH;
+				q->count--;
+			}
+			s3cfb_flip_complete(fbdev, q, now);
+		}
+		q->shown_vsync = 0;
+		q->skip = false;
+	}
+
+	/* late resume reprograms the nominal clock */
+	fbdev->refresh_idle = 0;
+	fbdev->refresh_hz = fbdev->lcd->freq;
+	fbdev->refresh.frames = 0;
+	fbdev->refresh.start = now;
+	fbdev->refresh.held = 0;
+	fbdev->refresh.probe_hz = 0;
+	fbdev->last_activity = fbdev->vsync_count;
+	if (fbdev->lcd->freq)
+		fbdev->vsync_period_ns = NSEC_PER_SEC / fbdev->lcd->freq;
+	fbdev->vsync_ts = ktime_set(0, 0);
+
+	spin_unlock_irqrestore(&fbdev->flip_lock, flags);
+
+	wake_up_all(&fbdev->vsync_wait);
+}
+
 static irqreturn_t s3cfb_irq_frame(int irq, void *data)
 {
 	struct s3cfb_global *fbdev = (struct s3cfb_global *)data;
 
 	s3cfb_clear_interrupt(fbdev);
 
+	s3cfb_flip_vsync(fbdev, ktime_get());
+
+	atomic_notifier_call_chain(&s3cfb_vsync_notifier,
+				   S3CFB_EVENT_VSYNC, fbdev);
+
 	complete_all(&fbdev->fb_complete);
+	wake_up_all(&fbdev->vsync_wait);
 
 	return IRQ_HANDLED;
 }
@@ -480,12 +900,25 @@ static int s3cfb_pan_display(struct fb_var_screeninfo *var, struct fb_info *fb)
 	struct s3cfb_window *win = fb->par;
 	struct s3cfb_global *fbdev =
 		platform_get_drvdata(to_platform_device(fb->device));
+	unsigned long flags;
 
 	if (var->yoffset + var->yres > var->yres_virtual) {
 		dev_err(fbdev->dev, "invalid yoffset value\n");
 		return -EINVAL;
 	}
 
+	/* the queued flips would overwrite this one at the next vsync */
+	if (s3cfb_flip_pending(&win->flip))
+		return -EBUSY;
+
+	spin_lock_irqsave(&fbdev->flip_lock, flags);
+
+	/* the caller can't be told, so a pan is never skipped */
+	win->flip.skip = false;
+	s3cfb_note_frame(fbdev);
+
+	spin_unlock_irqrestore(&fbdev->flip_lock, flags);
+
 	if (win->owner == DMA_MEM_OTHER)
 		fix->smem_start = win->other_mem_addr;
 
@@ -547,6 +980,107 @@ static int s3cfb_open(struct fb_info *fb, int user)
 
 	return ret;
 }
+/*
+ * Wait until the vsync counter reaches @vsync, with the frame interrupt
+ * on meanwhile. Not interruptible: the callers are about to hand back a
+ * buffer FIMD may still be reading. While the output is off nothing is
+ * scanned out, so there is nothing to wait for.
+ */
+static void s3cfb_wait_vsync_count(struct s3cfb_global *fbdev, u32 vsync)
+{
+	s3cfb_update_vsync_int(fbdev, true);
+
+	while ((s32)(fbdev->vsync_count - vsync) < 0) {
+		if (!wait_event_timeout(fbdev->vsync_wait,
+				(s32)(fbdev->vsync_count - vsync) >= 0,
+				msecs_to_jiffies(100)) && !fbdev->enabled)
+			break;
+	}
+}
+
+/*
+ * Drop the buffer an overlay commit replaced, once FIMD has stopped
+ * reading it. If that vsync has not happened yet, wait for it.
+ */
+static void s3cfb_put_retired(struct s3cfb_global *fbdev,
+			      struct s3cfb_window *win)
+{
+	if (!win->retired)
+		return;
+
+	s3cfb_wait_vsync_count(fbdev, win->retired_vsync);
+
+	s5p_media_buf_put(win->retired);
+	win->retired = NULL;
+
+	/* the frame interrupt was kept on for it */
+	s3cfb_update_vsync_int(fbdev, false);
+}
+
+/*
+ * Scan out a buffer exported by another device (e.g. an MFC decoded frame)
+ * instead of window memory, or stop doing so when fd is negative. The
+ * previous buffer is only handed back after the next vsync, once FIMD has
+ * latched the new address.
+ */
+static int s3cfb_set_shared_buf(struct s3cfb_global *fbdev,
+				struct fb_info *fb, int fd)
+{
+	struct fb_fix_screeninfo *fix = &fb->fix;
+	struct fb_var_screeninfo *var = &fb->var;
+	struct s3cfb_window *win = fb->par;
+	struct s5p_media_buf *shared = NULL, *old = win->shared;
+
+	/* DMA_MEM_OTHER without a shared buffer is FIMC's */
+	if (win->owner == DMA_MEM_FIMD ||
+	    (win->owner == DMA_MEM_OTHER && !old))
+		return -EBUSY;
+
+	s3cfb_put_retired(fbdev, win);
+
+	if (fd >= 0) {
+		shared = s5p_media_buf_get(fd);
+		if (IS_ERR(shared))
+			return PTR_ERR(shared);
+
+		if (shared->plane[0].size < fix->line_length * var->yres) {
+			dev_err(fbdev->dev, "[fb%d] shared buffer from %s "
+				"is too small\n", win->id, shared->exporter);
+			s5p_media_buf_put(shared);
+			return -EINVAL;
+		}
+
+		win->owner = DMA_MEM_OTHER;
+		win->other_mem_addr = shared->plane[0].paddr;
+		win->other_mem_size = shared->plane[0].size;
+		var->yoffset = 0;
+	} else {
+		if (!old)
+			return 0;
+
+		if (win->enabled)
+			s3cfb_set_window(fbdev, win->id, 0);
+
+		win->owner = DMA_MEM_NONE;
+		win->other_mem_addr = 0;
+		win->other_mem_size = 0;
+	}
+
+	win->shared = shared;
+	fix->smem_start = win->other_mem_addr;
+	fix->smem_len = win->other_mem_size;
+	s3cfb_set_buffer_address(fbdev, win->id);
+
+	if (old) {
+		/* see s3cfb_overlay_commit() for the extra vsync */
+		s3cfb_wait_vsync_count(fbdev, fbdev->vsync_count + 2);
+		s5p_media_buf_put(old);
+		s3cfb_update_vsync_int(fbdev, false);
+	}
+
+	return 0;
+}
+
 static int s3cfb_release_window(struct fb_info *fb)
 {
 	struct s3cfb_global *fbdev =
@@ -558,6 +1092,11 @@ static int s3cfb_release_window(struct fb_info *fb)
 		s3cfb_set_window(fbdev, win->id, 0);
 		s3cfb_unmap_video_memory(fb);
 		s3cfb_set_buffer_address(fbdev, win->id);
+
+		if (win->shared)
+			s3cfb_set_shared_buf(fbdev, fb, -1);
+
+		s3cfb_put_retired(fbdev, win);
 	}
 
 	win->x = 0;
@@ -585,12 +1124,13 @@ static int s3cfb_release(struct fb_info *fb, int user)
 
 static int s3cfb_wait_for_vsync(struct s3cfb_global *ctrl)
 {
+	u32 count = ctrl->vsync_count;
 	int ret;
 
 	dev_dbg(ctrl->dev, "waiting for VSYNC interrupt\n");
 
-	ret = wait_for_completion_interruptible_timeout(
-		&ctrl->fb_complete, msecs_to_jiffies(100));
+	ret = wait_event_interruptible_timeout(ctrl->vsync_wait,
+			ctrl->vsync_count != count, msecs_to_jiffies(100));
 	if (ret == 0)
 		return -ETIMEDOUT;
 	if (ret < 0)
@@ -600,6 +1140,405 @@ static int s3cfb_wait_for_vsync(struct s3cfb_global *ctrl)
 
 	return ret;
 }
+
+static int s3cfb_flip_async(struct s3cfb_global *fbdev, struct fb_info *fb,
+			    struct s3cfb_flip *flip)
+{
+	struct s3cfb_window *win = fb->par;
+	struct s3cfb_flip_queue *q = &win->flip;
+	unsigned long flags;
+	unsigned int tail;
+	int ret = 0;
+
+	if (flip->yoffset + fb->var.yres > fb->var.yres_virtual)
+		return -EINVAL;
+
+	if (!s3cfb_get_vsync_interrupt(fbdev)) {
+		s3cfb_set_global_interrupt(fbdev, 1);
+		s3cfb_set_vsync_interrupt(fbdev, 1);
+	}
+
+	spin_lock_irqsave(&fbdev->flip_lock, flags);
+
+	if (!fbdev->enabled) {
+		ret = -EAGAIN;
+		goto out;
+	}
+
+	if (q->count == S3CFB_FLIP_DEPTH) {
+		ret = -EBUSY;
+		goto out;
+	}
+
+	if (!++q->last_seq)
+		q->last_seq++;
+	flip->seq = q->last_seq;
+	flip->flags = 0;
+
+	/* nothing changed: keep the current buffer and report it as shown */
+	if (q->skip && !s3cfb_flip_pending(q)) {
+		q->skip = false;
+		q->done = flip->seq;
+		q->done_ts[flip->seq % S3CFB_FLIP_HISTORY] = fbdev->vsync_ts;
+		q->done_vsync[flip->seq % S3CFB_FLIP_HISTORY] =
+			fbdev->vsync_count;
+		flip->flags |= S3CFB_FLIP_SKIPPED;
+		fbdev->damage.skipped_flips++;
+		goto out;
+	}
+
+	q->skip = false;
+	s3cfb_note_frame(fbdev);
+
+	if (!s3cfb_flip_pending(q)) {
+		s3cfb_flip_program(fbdev, win->id, flip->yoffset);
+		q->latched = flip->seq;
+	} else {
+		tail = (q->head + q->count) % S3CFB_FLIP_DEPTH;
+		q->yoffset[tail] = flip->yoffset;
+		q->seq[tail] = flip->seq;
+		q->count++;
+	}
+
+out:
+	spin_unlock_irqrestore(&fbdev->flip_lock, flags);
+
+	return ret;
+}
+
+static bool s3cfb_flip_done(struct s3cfb_global *fbdev,
+			    struct s3cfb_flip_queue *q, u32 seq)
+{
+	unsigned long flags;
+	bool done;
+
+	spin_lock_irqsave(&fbdev->flip_lock, flags);
+	done = (s32)(q->done - seq) >= 0;
+	spin_unlock_irqrestore(&fbdev->flip_lock, flags);
+
+	return done;
+}
+
+static int s3cfb_wait_flip(struct s3cfb_global *fbdev, struct fb_info *fb,
+			   struct s3cfb_flip *flip)
+{
+	struct s3cfb_window *win = fb->par;
+	struct s3cfb_flip_queue *q = &win->flip;
+	unsigned long flags;
+	unsigned int idx;
+	int ret;
+
+	if (!flip->seq || (s32)(flip->seq - q->last_seq) > 0)
+		return -EINVAL;
+
+	ret = wait_event_interruptible_timeout(fbdev->vsync_wait,
+			s3cfb_flip_done(fbdev, q, flip->seq),
+			msecs_to_jiffies(100 * (S3CFB_FLIP_DEPTH + 1)));
+	if (ret == 0)
+		return -ETIMEDOUT;
+	if (ret < 0)
+		return ret;
+
+	spin_lock_irqsave(&fbdev->flip_lock, flags);
+
+	if (q->done - flip->seq >= S3CFB_FLIP_HISTORY) {
+		ret = -ENOENT;
+	} else {
+		idx = flip->seq % S3CFB_FLIP_HISTORY;
+		flip->timestamp = ktime_to_ns(q->done_ts[idx]);
+		flip->vsync = q->done_vsync[idx];
+		ret = 0;
+	}
+
+	spin_unlock_irqrestore(&fbdev->flip_lock, flags);
+
+	return ret;
+}
+
+static int s3cfb_wait_vsync_info(struct s3cfb_global *fbdev,
+				 struct s3cfb_vsync_info *info)
+{
+	unsigned long flags;
+	int ret;
+
+	ret = s3cfb_wait_for_vsync(fbdev);
+	if (ret < 0)
+		return ret;
+
+	spin_lock_irqsave(&fbdev->flip_lock, flags);
+	info->timestamp = ktime_to_ns(fbdev->vsync_ts);
+	info->count = fbdev->vsync_count;
+	spin_unlock_irqrestore(&fbdev->flip_lock, flags);
+
+	return 0;
+}
+static int s3cfb_check_layer(struct s3cfb_global *fbdev,
+			     struct s3cfb_layer *layer,
+			     struct s5p_media_buf **shared)
+{
+	struct s3c_platform_fb *pdata = to_fb_plat(fbdev->dev);
+	struct s3cfb_lcd *lcd = fbdev->lcd;
+	struct fb_info *fb;
+	struct fb_var_screeninfo *var;
+	struct s3cfb_window *win;
+	size_t size;
+
+	*shared = NULL;
+
+	if (layer->win < 0 || layer->win >= pdata->nr_wins)
+		return -EINVAL;
+
+	fb = fbdev->fb[layer->win];
+	var = &fb->var;
+	win = fb->par;
+
+	if (!layer->enabled)
+		return 0;
+
+	if (win->path != DATA_PATH_DMA || s3cfb_flip_pending(&win->flip))
+		return -EBUSY;
+
+	if (layer->x < 0 || layer->y < 0 ||
+	    layer->x + var->xres > lcd->width ||
+	    layer->y + var->yres > lcd->height ||
+	    layer->yoffset + var->yres > var->yres_virtual ||
+	    layer->blending > PIXEL_BLENDING || layer->alpha > 0xf)
+		return -EINVAL;
+
+	if (layer->fd < 0) {
+		if (!fb->fix.smem_start)
+			return -EINVAL;
+		return 0;
+	}
+
+	if (win->owner == DMA_MEM_FIMD ||
+	    (win->owner == DMA_MEM_OTHER && !win->shared))
+		return -EBUSY;
+
+	*shared = s5p_media_buf_get(layer->fd);
+	if (IS_ERR(*shared)) {
+		int ret = PTR_ERR(*shared);
+
+		*shared = NULL;
+		return ret;
+	}
+
+	size = fb->fix.line_length * (layer->yoffset + var->yres);
+	if ((*shared)->plane[0].size < size) {
+		dev_err(fbdev->dev, "[fb%d] shared buffer from %s "
+			"is too small\n", layer->win, (*shared)->exporter);
+		s5p_media_buf_put(*shared);
+		*shared = NULL;
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/*
+ * Called with the shadow registers of the window held. Turning the window
+ * on or off is not held back by them.
+ */
+static void s3cfb_apply_layer(struct s3cfb_global *fbdev,
+			      struct s3cfb_layer *layer,
+			      struct s5p_media_buf *shared)
+{
+	struct fb_info *fb = fbdev->fb[layer->win];
+	struct s3cfb_window *win = fb->par;
+	unsigned long flags;
+
+	if (!layer->enabled) {
+		if (win->enabled)
+			s3cfb_set_window(fbdev, layer->win, 0);
+		return;
+	}
+
+	if (shared) {
+		win->retired = win->shared;
+		win->shared = shared;
+		win->owner = DMA_MEM_OTHER;
+		win->other_mem_addr = shared->plane[0].paddr;
+		win->other_mem_size = shared->plane[0].size;
+		fb->fix.smem_len = win->other_mem_size;
+	}
+
+	win->x = layer->x;
+	win->y = layer->y;
+	s3cfb_set_window_position(fbdev, layer->win);
+
+	if (layer->win > 0) {
+		win->alpha.mode = layer->blending;
+		win->alpha.channel = 0;
+		win->alpha.value = S3CFB_AVALUE(layer->alpha, layer->alpha,
+						layer->alpha);
+		s3cfb_set_alpha_blending(fbdev, layer->win);
+	}
+
+	spin_lock_irqsave(&fbdev->flip_lock, flags);
+	if (win->owner == DMA_MEM_OTHER)
+		fb->fix.smem_start = win->other_mem_addr;
+	fb->var.yoffset = layer->yoffset;
+	s3cfb_set_buffer_address(fbdev, layer->win);
+	spin_unlock_irqrestore(&fbdev->flip_lock, flags);
+
+	if (!win->enabled)
+		s3cfb_set_window(fbdev, layer->win, 1);
+}
+
+/*
+ * Update several windows at once. The shadow registers of every window
+ * in the commit are held while it is programmed and released together,
+ * so the whole set is latched by FIMD at the same vsync. The exception
+ * is the channel enable in WINSHMAP, which the protect bits do not
+ * cover: a window turned on or off by the commit changes as soon as it
+ * is written, and may tear.
+ */
+static int s3cfb_overlay_commit(struct s3cfb_global *fbdev,
+				struct s3cfb_overlay *ovl)
+{
+	struct s5p_media_buf *shared[S3CFB_MAX_LAYERS] = { NULL, };
+	struct s3cfb_window *win;
+	unsigned long flags;
+	u32 mask = 0, vsync;
+	unsigned int i;
+	int ret = 0;
+
+	if (!ovl->nr_layers || ovl->nr_layers > S3CFB_MAX_LAYERS)
+		return -EINVAL;
+
+	mutex_lock(&fbdev->lock);
+
+	for (i = 0; i < ovl->nr_layers; i++) {
+		ret = s3cfb_check_layer(fbdev, &ovl->layer[i], &shared[i]);
+		if (ret)
+			goto err;
+
+		if (mask & (1 << ovl->layer[i].win)) {
+			ret = -EINVAL;
+			goto err;
+		}
+		mask |= 1 << ovl->layer[i].win;
+
+		/* one frame's worth of retired buffers at a time */
+		win = fbdev->fb[ovl->layer[i].win]->par;
+		if (shared[i])
+			s3cfb_put_retired(fbdev, win);
+	}
+
+	s3cfb_hold_shadow(fbdev, mask);
+
+	for (i = 0; i < ovl->nr_layers; i++)
+		s3cfb_apply_layer(fbdev, &ovl->layer[i], shared[i]);
+
+	spin_lock_irqsave(&fbdev->flip_lock, flags);
+	s3cfb_release_shadow(fbdev);
+	s3cfb_note_frame(fbdev);
+	vsync = fbdev->vsync_count;
+	spin_unlock_irqrestore(&fbdev->flip_lock, flags);
+
+	/*
+	 * The frame interrupt may still be pending for a vsync that has
+	 * already passed, so the old buffers are only safe one vsync later.
+	 */
+	for (i = 0; i < ovl->nr_layers; i++) {
+		win = fbdev->fb[ovl->layer[i].win]->par;
+		if (shared[i])
+			win->retired_vsync = vsync + 2;
+	}
+
+	/* count vsyncs until the retired buffers are put */
+	s3cfb_update_vsync_int(fbdev, false);
+
+	ovl->vsync = vsync + 1;
+
+	mutex_unlock(&fbdev->lock);
+
+	return 0;
+
+err:
+	mutex_unlock(&fbdev->lock);
+
+	for (i = 0; i < ovl->nr_layers; i++) {
+		if (shared[i])
+			s5p_media_buf_put(shared[i]);
+	}
+
+	return ret;
+}
+
+static int s3cfb_set_damage(struct s3cfb_global *fbdev, struct fb_info *fb,
+			    struct s3cfb_damage *damage)
+{
+	struct fb_var_screeninfo *var = &fb->var;
+	struct s3cfb_window *win = fb->par;
+	struct s3cfb_rect *r;
+	unsigned long flags;
+	u64 pixels = 0;
+	unsigned int i;
+
+	if (damage->nr_rects > S3CFB_MAX_DAMAGE)
+		return -EINVAL;
+
+	for (i = 0; i < damage->nr_rects; i++) {
+		r = &damage->rect[i];
+		if (r->x >= var->xres || r->y >= var->yres ||
+		    r->w > var->xres - r->x || r->h > var->yres - r->y)
+			return -EINVAL;
+
+		pixels += r->w * r->h;
+	}
+
+	/* overlapping rectangles are counted twice */
+	if (pixels > var->xres * var->yres)
+		pixels = var->xres * var->yres;
+
+	spin_lock_irqsave(&fbdev->flip_lock, flags);
+
+	fbdev->damage.reports++;
+	fbdev->damage.damaged_pixels += pixels;
+	fbdev->damage.window_pixels += var->xres * var->yres;
+
+	if (damage->nr_rects) {
+		win->flip.skip = false;
+		s3cfb_note_activity(fbdev);
+	} else {
+		win->flip.skip = true;
+		fbdev->damage.static_reports++;
+	}
+
+	spin_unlock_irqrestore(&fbdev->flip_lock, flags);
+
+	return 0;
+}
+
+/*
+ * Userspace knows the rate of what it is about to show (e.g. a video at
+ * 24 fps) before the flip rate settles. 0 goes back to measuring it.
+ */
+static int s3cfb_set_content_rate(struct s3cfb_global *fbdev, u32 hz)
+{
+	unsigned long flags;
+
+	if (hz > fbdev->lcd->freq)
+		return -EINVAL;
+
+	if (!s3cfb_dynamic_refresh(fbdev))
+		return 0;
+
+	spin_lock_irqsave(&fbdev->flip_lock, flags);
+
+	fbdev->content_hint = hz;
+	fbdev->refresh.frames = 0;
+	fbdev->refresh.start = ktime_get();
+	fbdev->refresh.held = 0;
+	fbdev->refresh.probe_hz = 0;
+	s3cfb_apply_refresh(fbdev, s3cfb_pick_refresh(fbdev, hz));
+
+	spin_unlock_irqrestore(&fbdev->flip_lock, flags);
+
+	return 0;
+}
+
 static int s3cfb_ioctl(struct fb_info *fb, unsigned int cmd, unsigned long arg)
 {
 	struct s3cfb_global *fbdev =
@@ -616,7 +1555,13 @@ static int s3cfb_ioctl(struct fb_info *fb, unsigned int cmd, unsigned long arg)
 		struct s3cfb_user_window user_window;
 		struct s3cfb_user_plane_alpha user_alpha;
 		struct s3cfb_user_chroma user_chroma;
+		struct s3cfb_flip flip;
+		struct s3cfb_vsync_info vsync_info;
+		struct s3cfb_overlay overlay;
+		struct s3cfb_damage damage;
+		u32 rate;
 		int vsync;
+		int fd;
 	} p;
 
 	switch (cmd) {
@@ -685,13 +1630,76 @@ static int s3cfb_ioctl(struct fb_info *fb, unsigned int cmd, unsigned long arg)
 		if (get_user(p.vsync, (int __user *)arg))
 			ret = -EFAULT;
 		else {
-			if (p.vsync)
-				s3cfb_set_global_interrupt(fbdev, 1);
+			fbdev->vsync_user = p.vsync;
+			s3cfb_update_vsync_int(fbdev, false);
+		}
+		break;
+
+	case S3CFB_FLIP_ASYNC:
+		if (copy_from_user(&p.flip, (struct s3cfb_flip __user *)arg,
+				   sizeof(p.flip)))
+			ret = -EFAULT;
+		else {
+			ret = s3cfb_flip_async(fbdev, fb, &p.flip);
+			if (!ret && copy_to_user((struct s3cfb_flip __user *)arg,
+						 &p.flip, sizeof(p.flip)))
+				ret = -EFAULT;
+		}
+		break;
+
+	case S3CFB_WAIT_FLIP:
+		if (copy_from_user(&p.flip, (struct s3cfb_flip __user *)arg,
+				   sizeof(p.flip)))
+			ret = -EFAULT;
+		else {
+			ret = s3cfb_wait_flip(fbdev, fb, &p.flip);
+			if (!ret && copy_to_user((struct s3cfb_flip __user *)arg,
+						 &p.flip, sizeof(p.flip)))
+				ret = -EFAULT;
+		}
+		break;
 
-			s3cfb_set_vsync_interrupt(fbdev, p.vsync);
+	case S3CFB_WAIT_VSYNC:
+		ret = s3cfb_wait_vsync_info(fbdev, &p.vsync_info);
+		if (!ret && copy_to_user((struct s3cfb_vsync_info __user *)arg,
+					 &p.vsync_info, sizeof(p.vsync_info)))
+			ret = -EFAULT;
+		break;
+
+	case S3CFB_OVERLAY_COMMIT:
+		if (copy_from_user(&p.overlay, (struct s3cfb_overlay __user *)arg,
+				   sizeof(p.overlay)))
+			ret = -EFAULT;
+		else {
+			ret = s3cfb_overlay_commit(fbdev, &p.overlay);
+			if (!ret && put_user(p.overlay.vsync,
+				&((struct s3cfb_overlay __user *)arg)->vsync))
+				ret = -EFAULT;
 		}
 		break;
 
+	case S3CFB_SET_DAMAGE:
+		if (copy_from_user(&p.damage, (struct s3cfb_damage __user *)arg,
+				   sizeof(p.damage)))
+			ret = -EFAULT;
+		else
+			ret = s3cfb_set_damage(fbdev, fb, &p.damage);
+		break;
+
+	case S3CFB_SET_CONTENT_RATE:
+		if (get_user(p.rate, (u32 __user *)arg))
+			ret = -EFAULT;
+		else
+			ret = s3cfb_set_content_rate(fbdev, p.rate);
+		break;
+
+	case S3CFB_SET_WIN_SHARED_BUF:
+		if (get_user(p.fd, (int __user *)arg))
+			ret = -EFAULT;
+		else
+			ret = s3cfb_set_shared_buf(fbdev, fb, p.fd);
+		break;
+
 	case S3CFB_GET_CURR_FB_INFO:
 		next_fb_info.phy_start_addr = fix->smem_start;
 		next_fb_info.xres = var->xres;
@@ -934,6 +1942,213 @@ static int s3cfb_sysfs_store_win_power(struct device *dev,
 static DEVICE_ATTR(win_power, S_IRUGO | S_IWUSR,
 		   s3cfb_sysfs_show_win_power, s3cfb_sysfs_store_win_power);
 
+static ssize_t s3cfb_sysfs_show_flip_stats(struct device *dev,
+					   struct device_attribute *attr,
+					   char *buf)
+{
+	struct s3cfb_global *fbdev = dev_get_drvdata(dev);
+	u32 vsyncs, missed, flips, repeated;
+	unsigned long flags;
+
+	spin_lock_irqsave(&fbdev->flip_lock, flags);
+	vsyncs = fbdev->vsync_count;
+	missed = fbdev->missed_vsyncs;
+	flips = fbdev->flips;
+	repeated = fbdev->repeated_frames;
+	spin_unlock_irqrestore(&fbdev->flip_lock, flags);
+
+	return sprintf(buf, "vsyncs %u\nmissed_vsyncs %u\nflips %u\n"
+		       "repeated_frames %u\n", vsyncs, missed, flips, repeated);
+}
+
+static DEVICE_ATTR(flip_stats, S_IRUGO, s3cfb_sysfs_show_flip_stats, NULL);
+
+static ssize_t s3cfb_sysfs_show_idle_refresh(struct device *dev,
+					     struct device_attribute *attr,
+					     char *buf)
+{
+	struct s3cfb_global *fbdev = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%u\n", fbdev->idle_refresh_hz);
+}
+
+static ssize_t s3cfb_sysfs_store_idle_refresh(struct device *dev,
+					      struct device_attribute *attr,
+					      const char *buf, size_t len)
+{
+	struct s3cfb_global *fbdev = dev_get_drvdata(dev);
+	unsigned long flags, hz;
+
+	if (strict_strtoul(buf, 10, &hz) < 0)
+		return -EINVAL;
+
+	if (hz >= fbdev->lcd->freq)
+		return -EINVAL;
+
+	spin_lock_irqsave(&fbdev->flip_lock, flags);
+	s3cfb_note_activity(fbdev);
+	fbdev->idle_refresh_hz = hz;
+	spin_unlock_irqrestore(&fbdev->flip_lock, flags);
+
+	return len;
+}
+
+static DEVICE_ATTR(idle_refresh, S_IRUGO | S_IWUSR,
+		   s3cfb_sysfs_show_idle_refresh, s3cfb_sysfs_store_idle_refresh);
+
+static ssize_t s3cfb_sysfs_show_min_refresh(struct device *dev,
+					    struct device_attribute *attr,
+					    char *buf)
+{
+	struct s3cfb_global *fbdev = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%d\n", fbdev->lcd->min_freq);
+}
+
+/*
+ * Lowest rate dynamic refresh may pick, overriding the board's min_freq
+ * for panels that have not been checked for flicker yet. 0 turns it off.
+ */
+static ssize_t s3cfb_sysfs_store_min_refresh(struct device *dev,
+					     struct device_attribute *attr,
+					     const char *buf, size_t len)
+{
+	struct s3cfb_global *fbdev = dev_get_drvdata(dev);
+	struct s3cfb_lcd *lcd = fbdev->lcd;
+	unsigned long flags, hz;
+
+	if (strict_strtoul(buf, 10, &hz) < 0)
+		return -EINVAL;
+
+	if (hz >= lcd->freq)
+		return -EINVAL;
+
+	spin_lock_irqsave(&fbdev->flip_lock, flags);
+
+	lcd->min_freq = hz;
+	fbdev->refresh.frames = 0;
+	fbdev->refresh.start = ktime_get();
+	fbdev->refresh.held = 0;
+	fbdev->refresh.probe_hz = 0;
+	fbdev->refresh.backoff = 0;
+	if (s3cfb_dynamic_refresh(fbdev) && fbdev->content_hint)
+		s3cfb_apply_refresh(fbdev,
+			s3cfb_pick_refresh(fbdev, fbdev->content_hint));
+	else
+		s3cfb_apply_refresh(fbdev, lcd->freq);
+
+	spin_unlock_irqrestore(&fbdev->flip_lock, flags);
+
+	return len;
+}
+
+static DEVICE_ATTR(min_refresh, S_IRUGO | S_IWUSR,
+		   s3cfb_sysfs_show_min_refresh, s3cfb_sysfs_store_min_refresh);
+
+/*
+ * saved_frames is what the panel would have scanned out at lcd->freq
+ * during idle periods minus what it did scan out, and saved_scanout_kb
+ * is the memory traffic of those frames for the enabled DMA windows.
+ */
+static ssize_t s3cfb_sysfs_show_damage_stats(struct device *dev,
+					     struct device_attribute *attr,
+					     char *buf)
+{
+	struct s3c_platform_fb *pdata = to_fb_plat(dev);
+	struct s3cfb_global *fbdev = dev_get_drvdata(dev);
+	struct fb_var_screeninfo *var;
+	struct s3cfb_window *win;
+	unsigned long flags;
+	u64 nominal, saved = 0, frame_bytes = 0;
+	int i;
+
+	for (i = 0; i < pdata->nr_wins; i++) {
+		win = fbdev->fb[i]->par;
+		var = &fbdev->fb[i]->var;
+		if (win->enabled && win->path == DATA_PATH_DMA)
+			frame_bytes += var->xres * var->yres *
+				       var->bits_per_pixel / 8;
+	}
+
+	spin_lock_irqsave(&fbdev->flip_lock, flags);
+
+	nominal = div_u64(fbdev->damage.idle_ns * fbdev->lcd->freq,
+			  NSEC_PER_SEC);
+	if (nominal > fbdev->damage.idle_vsyncs)
+		saved = nominal - fbdev->damage.idle_vsyncs;
+
+	i = sprintf(buf, "reports %u\nstatic_reports %u\nskipped_flips %u\n"
+		    "damaged_pixels %llu\nwindow_pixels %llu\n"
+		    "idle_entries %u\nidle_vsyncs %u\nsaved_frames %llu\n"
+		    "saved_scanout_kb %llu\n",
+		    fbdev->damage.reports, fbdev->damage.static_reports,
+		    fbdev->damage.skipped_flips, fbdev->damage.damaged_pixels,
+		    fbdev->damage.window_pixels, fbdev->damage.idle_entries,
+		    fbdev->damage.idle_vsyncs, saved,
+		    div_u64(saved * frame_bytes, 1024));
+
+	spin_unlock_irqrestore(&fbdev->flip_lock, flags);
+
+	return i;
+}
+
+static DEVICE_ATTR(damage_stats, S_IRUGO, s3cfb_sysfs_show_damage_stats, NULL);
+
+/*
+ * Refresh rate accounting. reduced_vsyncs and saved_frames cover every
+ * frame below lcd->freq, idle periods included, and saved_scanout_kb
+ * is the memory traffic of the saved frames for the enabled DMA windows.
+ */
+static ssize_t s3cfb_sysfs_show_refresh_stats(struct device *dev,
+					      struct device_attribute *attr,
+					      char *buf)
+{
+	struct s3c_platform_fb *pdata = to_fb_plat(dev);
+	struct s3cfb_global *fbdev = dev_get_drvdata(dev);
+	struct s3cfb_lcd *lcd = fbdev->lcd;
+	struct fb_var_screeninfo *var;
+	struct s3cfb_window *win;
+	unsigned long flags;
+	u64 nominal, saved = 0, frame_bytes = 0;
+	u32 period;
+	int i;
+
+	for (i = 0; i < pdata->nr_wins; i++) {
+		win = fbdev->fb[i]->par;
+		var = &fbdev->fb[i]->var;
+		if (win->enabled && win->path == DATA_PATH_DMA)
+			frame_bytes += var->xres * var->yres *
+				       var->bits_per_pixel / 8;
+	}
+
+	spin_lock_irqsave(&fbdev->flip_lock, flags);
+
+	nominal = div_u64(fbdev->refresh.reduced_ns * lcd->freq,
+			  NSEC_PER_SEC);
+	if (nominal > fbdev->refresh.reduced_vsyncs)
+		saved = nominal - fbdev->refresh.reduced_vsyncs;
+	period = fbdev->vsync_period_ns;
+
+	i = sprintf(buf, "refresh_hz %u\nactual_millihz %u\nmin_hz %d\n"
+		    "max_hz %d\ncontent_hint %u\nswitches %u\n"
+		    "reduced_vsyncs %u\nsaved_frames %llu\n"
+		    "saved_scanout_kb %llu\n",
+		    fbdev->refresh_idle ? fbdev->idle_refresh_hz :
+		    fbdev->refresh_hz,
+		    period ? (u32)div_u64(1000ULL * NSEC_PER_SEC, period) : 0,
+		    s3cfb_dynamic_refresh(fbdev) ? lcd->min_freq : lcd->freq,
+		    lcd->freq, fbdev->content_hint, fbdev->refresh.switches,
+		    fbdev->refresh.reduced_vsyncs, saved,
+		    div_u64(saved * frame_bytes, 1024));
+
+	spin_unlock_irqrestore(&fbdev->flip_lock, flags);
+
+	return i;
+}
+
+static DEVICE_ATTR(refresh_stats, S_IRUGO,
+		   s3cfb_sysfs_show_refresh_stats, NULL);
+
 static int __devinit s3cfb_probe(struct platform_device *pdev)
 {
 	struct s3c_platform_fb *pdata;
@@ -1054,6 +2269,15 @@ static int __devinit s3cfb_probe(struct platform_device *pdev)
 	s3cfb_set_alpha_value_width(fbdev, pdata->default_win);
 
 	s3cfb_display_on(fbdev);
+	fbdev->enabled = 1;
+
+	spin_lock_init(&fbdev->flip_lock);
+	fbdev->vsync_user = 1;
+	init_waitqueue_head(&fbdev->vsync_wait);
+	if (fbdev->lcd->freq)
+		fbdev->vsync_period_ns = NSEC_PER_SEC / fbdev->lcd->freq;
+	fbdev->refresh_hz = fbdev->lcd->freq;
+	fbdev->refresh.start = ktime_get();
 
 	fbdev->irq = platform_get_irq(pdev, 0);
 	if (request_irq(fbdev->irq, s3cfb_irq_frame, IRQF_SHARED,
@@ -1085,6 +2309,29 @@ static int __devinit s3cfb_probe(struct platform_device *pdev)
 	if (ret < 0)
 		dev_err(fbdev->dev, "failed to add sysfs entries\n");
 
+	ret = device_create_file(&(pdev->dev), &dev_attr_flip_stats);
+	if (ret < 0)
+		dev_err(fbdev->dev, "failed to add sysfs entries\n");
+
+	ret = device_create_file(&(pdev->dev), &dev_attr_idle_refresh);
+	if (ret < 0)
+		dev_err(fbdev->dev, "failed to add sysfs entries\n");
+
+	ret = device_create_file(&(pdev->dev), &dev_attr_min_refresh);
+	if (ret < 0)
+		dev_err(fbdev->dev, "failed to add sysfs entries\n");
+
+	ret = device_create_file(&(pdev->dev), &dev_attr_damage_stats);
+	if (ret < 0)
+		dev_err(fbdev->dev, "failed to add sysfs entries\n");
+
+	ret = device_create_file(&(pdev->dev), &dev_attr_refresh_stats);
+	if (ret < 0)
+		dev_err(fbdev->dev, "failed to add sysfs entries\n");
+
+	s3cfb_vsync_fbdev = fbdev;
+	s3cfb_update_vsync_int(fbdev, false);
+
 	dev_info(fbdev->dev, "registered successfully\n");
 
 	return 0;
@@ -1141,11 +2388,17 @@ static int __devexit s3cfb_remove(struct platform_device *pdev)
 	int i;
 
 	device_remove_file(&(pdev->dev), &dev_attr_win_power);
+	device_remove_file(&(pdev->dev), &dev_attr_flip_stats);
+	device_remove_file(&(pdev->dev), &dev_attr_idle_refresh);
+	device_remove_file(&(pdev->dev), &dev_attr_min_refresh);
+	device_remove_file(&(pdev->dev), &dev_attr_damage_stats);
+	device_remove_file(&(pdev->dev), &dev_attr_refresh_stats);
 
 #ifdef CONFIG_HAS_EARLYSUSPEND
 	unregister_early_suspend(&fbdev->early_suspend);
 #endif
 
+	s3cfb_vsync_fbdev = NULL;
 	free_irq(fbdev->irq, fbdev);
 	iounmap(fbdev->regs);
 
@@ -1193,6 +2446,9 @@ void s3cfb_early_suspend(struct early_suspend *h)
 #endif
 
 	s3cfb_display_off(fbdev);
+	s3cfb_flip_flush(fbdev);
+	atomic_notifier_call_chain(&s3cfb_vsync_notifier,
+				   S3CFB_EVENT_DISPLAY_OFF, fbdev);
 #ifdef CONFIG_FB_S3C_MDNIE
 	s3c_mdnie_off();
 #endif
@@ -1252,6 +2508,7 @@ void s3cfb_late_resume(struct early_suspend *h)
 	s3cfb_set_alpha_value_width(fbdev, pdata->default_win);
 
 	s3cfb_display_on(fbdev);
+	fbdev->enabled = 1;
 
 	for (i = pdata->default_win;
 		i < pdata->nr_wins + pdata->default_win; i++) {
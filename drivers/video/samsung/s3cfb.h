@@ -13,15 +13,20 @@
 #ifndef _S3CFB_H
 #define _S3CFB_H
 
+#include <linux/types.h>
 #ifdef __KERNEL__
 #include <linux/wait.h>
 #include <linux/mutex.h>
+#include <linux/spinlock.h>
+#include <linux/ktime.h>
 #include <linux/fb.h>
+#include <linux/notifier.h>
 #ifdef CONFIG_HAS_WAKELOCK
 #include <linux/wakelock.h>
 #include <linux/earlysuspend.h>
 #endif
 #include <plat/fb.h>
+#include <plat/media-buf.h>
 #endif
 
 /*
@@ -159,6 +164,9 @@ struct s3cfb_lcd_timing {
  * @p_height:	        height of lcd in mm
  * @bpp:		bits per pixel
  * @freq:		vframe frequency
+ * @min_freq:		lowest vframe frequency the panel may be run at,
+ *			0 if it must stay at @freq; min_refresh in sysfs
+ *			overrides it
  * @timing:		timing values
  * @polarity:		polarity settings
  * @init_ldi:		pointer to LDI init function
@@ -171,6 +179,7 @@ struct s3cfb_lcd {
 	int	p_height;
 	int	bpp;
 	int	freq;
+	int	min_freq;
 	struct	s3cfb_lcd_timing timing;
 	struct	s3cfb_lcd_polarity polarity;
 
@@ -178,6 +187,37 @@ struct s3cfb_lcd {
 	void	(*deinit_ldi)(void);
 };
 
+/*
+ * struct s3cfb_flip_queue
+ * @yoffset:		queued buffers, waiting for the current one to latch
+ * @seq:		sequence number of each queued buffer
+ * @head:		oldest entry in @yoffset
+ * @count:		number of queued entries
+ * @last_seq:		sequence number of the last accepted flip
+ * @latched:		flip written to the shadow registers, 0 if none
+ * @done:		last flip that reached the screen
+ * @shown_vsync:	vsync count at which @done reached the screen
+ * @done_ts:		vsync timestamp of recent flips, indexed by seq
+ * @done_vsync:		vsync count of recent flips, indexed by seq
+ * @skip:		the next flip carries no damage and is not programmed
+*/
+#define S3CFB_FLIP_DEPTH	2
+#define S3CFB_FLIP_HISTORY	8
+
+struct s3cfb_flip_queue {
+	unsigned int	yoffset[S3CFB_FLIP_DEPTH];
+	u32		seq[S3CFB_FLIP_DEPTH];
+	unsigned int	head;
+	unsigned int	count;
+	u32		last_seq;
+	u32		latched;
+	u32		done;
+	u32		shown_vsync;
+	ktime_t		done_ts[S3CFB_FLIP_HISTORY];
+	u32		done_vsync[S3CFB_FLIP_HISTORY];
+	bool		skip;
+};
+
 /*
  * struct s3cfb_window
  * @id:			window id
@@ -185,12 +225,16 @@ struct s3cfb_lcd {
  * @x:			left x of start offset
  * @y:			top y of start offset
  * @path:		data path (dma/fifo)
+ * @shared:		imported buffer being scanned out (DMA_MEM_OTHER)
+ * @retired:		shared buffer replaced by an overlay commit
+ * @retired_vsync:	vsync count after which @retired is no longer read
  * @local_channel:	local channel for fifo path (0/1)
  * @dma_burst:		dma burst length (4/8/16)
  * @unpacked:		if unpacked format is
  * @pseudo_pal:		pseudo palette for fb layer
  * @alpha:		alpha blending structure
  * @chroma:		chroma key structure
+ * @flip:		asynchronous flips (S3CFB_FLIP_ASYNC)
 */
 struct s3cfb_window {
 	int			id;
@@ -202,11 +246,15 @@ struct s3cfb_window {
 	enum			s3cfb_mem_owner_t owner;
 	unsigned int	other_mem_addr;
 	unsigned int	other_mem_size;
+	struct			s5p_media_buf *shared;
+	struct			s5p_media_buf *retired;
+	u32			retired_vsync;
 	int			local_channel;
 	int			dma_burst;
 	unsigned int		pseudo_pal[16];
 	struct			s3cfb_alpha alpha;
 	struct			s3cfb_chroma chroma;
+	struct			s3cfb_flip_queue flip;
 };
 
 /*
@@ -219,6 +267,24 @@ struct s3cfb_window {
  * @output:		output path (RGB/I80/Etc)
  * @rgb_mode:		RGB mode
  * @lcd:		pointer to lcd structure
+ * @shadow_hold:	windows whose shadow registers are held for a commit
+ * @vclk_src_hz:	rate of the VCLK source picked by s3cfb_set_clock()
+ * @flip_lock:		protects the flip queues and the vsync counters
+ * @vsync_user:		frame interrupt setting from S3CFB_SET_VSYNC_INT
+ * @vsync_wait:		woken on every frame interrupt
+ * @vsync_count:	number of frame interrupts seen
+ * @vsync_ts:		time of the last frame interrupt, 0 after a gap
+ * @vsync_period_ns:	nominal frame period, from lcd->freq
+ * @missed_vsyncs:	frame interrupts that arrived late or not at all
+ * @flips:		asynchronous flips that reached the screen
+ * @repeated_frames:	frames shown twice in the middle of a flip sequence
+ * @idle_refresh_hz:	refresh rate used while nothing changes, 0 if off
+ * @refresh_idle:	panel currently runs at @idle_refresh_hz
+ * @last_activity:	vsync count of the last flip, commit or damage
+ * @damage:		S3CFB_SET_DAMAGE and idle refresh statistics
+ * @refresh_hz:		refresh rate picked for the content being shown
+ * @content_hint:	content rate from S3CFB_SET_CONTENT_RATE, 0 if none
+ * @refresh:		content rate measurement and refresh statistics
 */
 struct s3cfb_global {
 	/* general */
@@ -233,6 +299,46 @@ struct s3cfb_global {
 	struct fb_info		**fb;
 	struct completion	fb_complete;
 
+	/* vsync */
+	spinlock_t		flip_lock;
+	int			vsync_user;
+	wait_queue_head_t	vsync_wait;
+	u32			vsync_count;
+	ktime_t			vsync_ts;
+	u32			vsync_period_ns;
+	u32			missed_vsyncs;
+	u32			flips;
+	u32			repeated_frames;
+
+	/* damage */
+	u32			idle_refresh_hz;
+	int			refresh_idle;
+	u32			last_activity;
+	struct {
+		u32		reports;
+		u32		static_reports;
+		u32		skipped_flips;
+		u64		damaged_pixels;
+		u64		window_pixels;
+		u32		idle_entries;
+		u32		idle_vsyncs;
+		u64		idle_ns;
+	} damage;
+
+	/* dynamic refresh */
+	u32			refresh_hz;
+	u32			content_hint;
+	struct {
+		u32		frames;
+		ktime_t		start;
+		u32		switches;
+		u32		reduced_vsyncs;
+		u64		reduced_ns;
+		u32		held;
+		u32		probe_hz;
+		u32		backoff;
+	} refresh;
+
 	/* fimd */
 	int			enabled;
 	int			dsi;
@@ -241,6 +347,8 @@ struct s3cfb_global {
 	enum s3cfb_rgb_mode_t	rgb_mode;
 	struct s3cfb_lcd	*lcd;
 	u32			pixclock_hz;
+	u32			shadow_hold;
+	u32			vclk_src_hz;
 
 #ifdef CONFIG_HAS_WAKELOCK
 	struct early_suspend	early_suspend;
@@ -290,6 +398,89 @@ struct s3cfb_next_info {
 	unsigned int lcd_offset_y;
 };
 
+/*
+ * S3CFB_FLIP_ASYNC takes @yoffset and returns the @seq of the new flip.
+ * S3CFB_WAIT_FLIP takes @seq, waits until that flip is on screen and
+ * fills in the vsync it was latched at. Timestamps are CLOCK_MONOTONIC
+ * in nanoseconds.
+ *
+ * S3CFB_FLIP_SKIPPED is returned by S3CFB_FLIP_ASYNC when an empty
+ * S3CFB_SET_DAMAGE said the buffer has no changes: the previous buffer
+ * stays on screen and the new one is free again right away.
+ */
+#define S3CFB_FLIP_SKIPPED	(1 << 0)
+
+struct s3cfb_flip {
+	__u32 yoffset;
+	__u32 seq;
+	__u64 timestamp;
+	__u32 vsync;
+	__u32 flags;
+};
+
+struct s3cfb_vsync_info {
+	__u64 timestamp;
+	__u32 count;
+};
+
+/*
+ * One entry per hardware window for S3CFB_OVERLAY_COMMIT. FIMD blends
+ * the windows in index order, window 0 at the bottom, so the window a
+ * layer is committed to is also its z-order.
+ *
+ * @fd:		buffer exported by another device, or -1 to keep scanning
+ *		out the window's current buffer
+ * @yoffset:	line offset into the buffer
+ * @blending:	PLANE_BLENDING or PIXEL_BLENDING
+ * @alpha:	plane alpha, 0 (transparent) to 15 (opaque)
+ *
+ * Window 0 cannot blend, so @blending and @alpha are ignored for it.
+ */
+#define S3CFB_MAX_LAYERS	5
+
+struct s3cfb_layer {
+	__s32 win;
+	__s32 enabled;
+	__s32 fd;
+	__u32 yoffset;
+	__s32 x;
+	__s32 y;
+	__u32 blending;
+	__u32 alpha;
+};
+
+/*
+ * Buffer, position and blending changes of all layers reach the screen
+ * at the same vsync. Turning a window on or off does not wait for it and
+ * may tear. @vsync returns the first vsync count at which the commit can
+ * be visible, to be matched against S3CFB_WAIT_VSYNC.
+ */
+struct s3cfb_overlay {
+	__u32 nr_layers;
+	struct s3cfb_layer layer[S3CFB_MAX_LAYERS];
+	__u32 vsync;
+};
+
+/*
+ * Region of a window that changed in the buffer about to be flipped,
+ * in window coordinates. No rectangles means nothing changed: the next
+ * S3CFB_FLIP_ASYNC of the window completes without being programmed,
+ * and the panel may drop to the idle refresh rate.
+ */
+#define S3CFB_MAX_DAMAGE	8
+
+struct s3cfb_rect {
+	__u32 x;
+	__u32 y;
+	__u32 w;
+	__u32 h;
+};
+
+struct s3cfb_damage {
+	__u32 nr_rects;
+	struct s3cfb_rect rect[S3CFB_MAX_DAMAGE];
+};
+
 /*
  * C U S T O M  I O C T L S
  *
@@ -313,6 +504,24 @@ struct s3cfb_next_info {
 #define S3CFB_SET_WIN_ADDR		_IOW('F', 309, unsigned long)
 #define S3CFB_SET_WIN_MEM		_IOW('F', 310, \
 						enum s3cfb_mem_owner_t)
+#define S3CFB_SET_WIN_SHARED_BUF	_IOW('F', 311, int)
+#define S3CFB_FLIP_ASYNC		_IOWR('F', 312, struct s3cfb_flip)
+#define S3CFB_WAIT_FLIP			_IOWR('F', 313, struct s3cfb_flip)
+#define S3CFB_WAIT_VSYNC		_IOR('F', 314, \
+						struct s3cfb_vsync_info)
+#define S3CFB_OVERLAY_COMMIT		_IOWR('F', 315, struct s3cfb_overlay)
+#define S3CFB_SET_DAMAGE		_IOW('F', 316, struct s3cfb_damage)
+#define S3CFB_SET_CONTENT_RATE		_IOW('F', 317, __u32)
+
+/*
+ * V S Y N C  N O T I F I E R
+ *
+ * Called from the frame interrupt, and once with S3CFB_EVENT_DISPLAY_OFF
+ * when the panel is switched off and nothing is scanned out any more.
+ * Holding a notifier keeps the vsync interrupt enabled.
+*/
+#define S3CFB_EVENT_VSYNC		0
+#define S3CFB_EVENT_DISPLAY_OFF		1
 
 /*
  * E X T E R N S
@@ -328,6 +537,7 @@ extern int s3cfb_display_on(struct s3cfb_global *ctrl);
 extern int s3cfb_display_off(struct s3cfb_global *ctrl);
 extern int s3cfb_frame_off(struct s3cfb_global *ctrl);
 extern int s3cfb_set_clock(struct s3cfb_global *ctrl);
+extern int s3cfb_set_refresh(struct s3cfb_global *ctrl, int hz);
 extern int s3cfb_set_polarity(struct s3cfb_global *ctrl);
 extern int s3cfb_set_timing(struct s3cfb_global *ctrl);
 extern int s3cfb_set_lcd_size(struct s3cfb_global *ctrl);
@@ -350,6 +560,10 @@ extern int s3cfb_set_window_size(struct s3cfb_global *ctrl, int id);
 extern int s3cfb_set_buffer_address(struct s3cfb_global *ctrl, int id);
 extern int s3cfb_set_buffer_size(struct s3cfb_global *ctrl, int id);
 extern int s3cfb_set_chroma_key(struct s3cfb_global *ctrl, int id);
+extern int s3cfb_hold_shadow(struct s3cfb_global *ctrl, u32 mask);
+extern int s3cfb_release_shadow(struct s3cfb_global *ctrl);
+extern int s3cfb_register_vsync_notifier(struct notifier_block *nb);
+extern int s3cfb_unregister_vsync_notifier(struct notifier_block *nb);
 
 #ifdef CONFIG_HAS_WAKELOCK
 #ifdef CONFIG_HAS_EARLYSUSPEND
@@ -15,6 +15,7 @@
 #include <linux/fb.h>
 #include <linux/io.h>
 #include <linux/clk.h>
+#include <linux/math64.h>
 #include <mach/map.h>
 #include <plat/clock.h>
 #include <plat/fb.h>
@@ -210,6 +211,8 @@ int s3cfb_set_clock(struct s3cfb_global *ctrl)
 	cfg |= S3C_VIDCON0_CLKVAL_F(div - 1);
 	writel(cfg, ctrl->regs + S3C_VIDCON0);
 
+	ctrl->vclk_src_hz = src_clk;
+
 	dev_dbg(ctrl->dev, "parent clock: %d, vclk: %d, vclk div: %d\n",
 			src_clk, vclk, div);
 
@@ -217,6 +220,43 @@ int s3cfb_set_clock(struct s3cfb_global *ctrl)
 	return 0;
 }
 
+/*
+ * Run the panel at @hz instead of lcd->freq by changing only the VCLK
+ * divider, so timings stay as they are and the new rate takes effect at
+ * the start of the next frame. Updates ctrl->vsync_period_ns, so the
+ * caller must hold ctrl->flip_lock.
+ */
+int s3cfb_set_refresh(struct s3cfb_global *ctrl, int hz)
+{
+	struct s3cfb_lcd *lcd = ctrl->lcd;
+	u32 cfg, vclk, div, frame;
+
+	if (hz <= 0 || hz > lcd->freq || !ctrl->vclk_src_hz)
+		return -EINVAL;
+
+	frame = ctrl->pixclock_hz / lcd->freq;
+	vclk = frame * hz;
+
+	div = ctrl->vclk_src_hz / vclk;
+	if (ctrl->vclk_src_hz % vclk)
+		div++;
+
+	if (div > 256)
+		div = 256;
+
+	cfg = readl(ctrl->regs + S3C_VIDCON0);
+	cfg &= ~(S3C_VIDCON0_CLKVALUP_MASK | S3C_VIDCON0_CLKVAL_F(-1));
+	cfg |= S3C_VIDCON0_CLKVALUP_START_FRAME | S3C_VIDCON0_CLKVAL_F(div - 1);
+	writel(cfg, ctrl->regs + S3C_VIDCON0);
+
+	ctrl->vsync_period_ns = div_u64((u64)frame * div * NSEC_PER_SEC,
+					ctrl->vclk_src_hz);
+
+	dev_dbg(ctrl->dev, "refresh %d Hz, vclk div: %d\n", hz, div);
+
+	return 0;
+}
+
 int s3cfb_set_polarity(struct s3cfb_global *ctrl)
 {
 	struct s3cfb_lcd_polarity *pol;
@@ -600,7 +640,7 @@ int s3cfb_set_buffer_address(struct s3cfb_global *ctrl, int id)
 	writel(start_addr, ctrl->regs + S3C_VIDADDR_START0(id));
 	writel(end_addr, ctrl->regs + S3C_VIDADDR_END0(id));
 
-	if (pdata->hw_ver == 0x62) {
+	if (pdata->hw_ver == 0x62 && !(ctrl->shadow_hold & (1 << id))) {
 		shw = readl(ctrl->regs + S3C_WINSHMAP);
 		shw &= ~(S3C_WINSHMAP_PROTECT(id));
 		writel(shw, ctrl->regs + S3C_WINSHMAP);
@@ -683,9 +723,11 @@ int s3cfb_set_window_position(struct s3cfb_global *ctrl, int id)
 
 	writel(cfg, ctrl->regs + S3C_VIDOSD_B(id));
 
-	shw = readl(ctrl->regs + S3C_WINSHMAP);
-	shw &= ~(S3C_WINSHMAP_PROTECT(id));
-	writel(shw, ctrl->regs + S3C_WINSHMAP);
+	if (!(ctrl->shadow_hold & (1 << id))) {
+		shw = readl(ctrl->regs + S3C_WINSHMAP);
+		shw &= ~(S3C_WINSHMAP_PROTECT(id));
+		writel(shw, ctrl->regs + S3C_WINSHMAP);
+	}
 
 	dev_dbg(ctrl->dev, "[fb%d] offset: (%d, %d, %d, %d)\n", id,
 		win->x, win->y, win->x + var->xres - 1, win->y + var->yres - 1);
@@ -728,6 +770,53 @@ int s3cfb_set_buffer_size(struct s3cfb_global *ctrl, int id)
 	return 0;
 }
 
+/*
+ * Keep the shadow registers of the windows in @mask from being updated
+ * until s3cfb_release_shadow(), so that everything written in between
+ * reaches the screen at the same vsync.
+ */
+int s3cfb_hold_shadow(struct s3cfb_global *ctrl, u32 mask)
+{
+	struct s3c_platform_fb *pdata = to_fb_plat(ctrl->dev);
+	u32 shw;
+	int id;
+
+	if (pdata->hw_ver != 0x62)
+		return 0;
+
+	shw = readl(ctrl->regs + S3C_WINSHMAP);
+	for (id = 0; id < pdata->nr_wins; id++) {
+		if (mask & (1 << id))
+			shw |= S3C_WINSHMAP_PROTECT(id);
+	}
+	writel(shw, ctrl->regs + S3C_WINSHMAP);
+
+	ctrl->shadow_hold = mask;
+
+	return 0;
+}
+
+int s3cfb_release_shadow(struct s3cfb_global *ctrl)
+{
+	struct s3c_platform_fb *pdata = to_fb_plat(ctrl->dev);
+	u32 shw;
+	int id;
+
+	if (!ctrl->shadow_hold)
+		return 0;
+
+	shw = readl(ctrl->regs + S3C_WINSHMAP);
+	for (id = 0; id < pdata->nr_wins; id++) {
+		if (ctrl->shadow_hold & (1 << id))
+			shw &= ~(S3C_WINSHMAP_PROTECT(id));
+	}
+	writel(shw, ctrl->regs + S3C_WINSHMAP);
+
+	ctrl->shadow_hold = 0;
+
+	return 0;
+}
+
 int s3cfb_set_chroma_key(struct s3cfb_global *ctrl, int id)
 {
 	struct s3cfb_window *win = ctrl->fb[id]->par;
@@ -302,6 +302,16 @@ static inline int yaffs_hash_fn(int n)
 	return n % YAFFS_NOBJECT_BUCKETS;
 }
 
+/*
+ * Name index hash. Keyed on the parent directory and the name sum so
+ * that siblings with different names land in different buckets.
+ */
+
+static inline int yaffs_name_hash_fn(const struct yaffs_obj *dir, u16 sum)
+{
+	return (dir->obj_id * 31 + sum) % YAFFS_NNAME_BUCKETS;
+}
+
 /*
  * Access functions to useful fake objects.
  * Note that root might have a presence in NAND if permissions are set.
@@ -686,8 +696,42 @@ static u16 yaffs_calc_name_sum(const YCHAR * name)
 	return sum;
 }
 
+/*---------------- Directory name index ------------
+ *
+ * Every object with a parent sits in dev->name_bucket, hashed on
+ * (parent, sum). A directory's index is only trusted once a full walk
+ * of its children found every name loaded (names_indexed); adding a
+ * lazy-loaded child, or a nameless one during the scan, drops the
+ * directory back to walking.
+ * Callers hold the gross lock, name_lock keeps yaffs_find_by_name_fast()
+ * readers consistent.
+ */
+
+static void yaffs_name_rehash(struct yaffs_obj *obj)
+{
+	struct yaffs_obj *parent = obj->parent;
+
+	list_del_init(&obj->name_link);
+	if (!parent)
+		return;
+
+	list_add(&obj->name_link,
+		 &obj->my_dev->name_bucket[yaffs_name_hash_fn(parent, obj->sum)]);
+
+	/* Once mounted, a nameless child is a new object parked in
+	 * lost-n-found until yaffs_create_obj() names it, and naming it
+	 * rehashes it here. Only the scan leaves children without names.
+	 */
+	if (obj->lazy_loaded ||
+	    (!obj->sum && !obj->my_dev->name_index_ready))
+		parent->names_indexed = 0;
+}
+
 void yaffs_set_obj_name(struct yaffs_obj *obj, const YCHAR * name)
 {
+	struct yaffs_dev *dev = obj->my_dev;
+
+	spin_lock(&dev->name_lock);
 #ifndef CONFIG_YAFFS_NO_SHORT_NAMES
 	memset(obj->short_name, 0, sizeof(obj->short_name));
 	if (name && 
@@ -698,6 +742,8 @@ void yaffs_set_obj_name(struct yaffs_obj *obj, const YCHAR * name)
 		obj->short_name[0] = _Y('\0');
 #endif
 	obj->sum = yaffs_calc_name_sum(name);
+	yaffs_name_rehash(obj);
+	spin_unlock(&dev->name_lock);
 }
 
 void yaffs_set_obj_name_from_oh(struct yaffs_obj *obj,
@@ -1281,8 +1327,11 @@ static void yaffs_remove_obj_from_dir(struct yaffs_obj *obj)
 	if (dev && dev->param.remove_obj_fn)
 		dev->param.remove_obj_fn(obj);
 
+	spin_lock(&dev->name_lock);
 	list_del_init(&obj->siblings);
 	obj->parent = NULL;
+	list_del_init(&obj->name_link);
+	spin_unlock(&dev->name_lock);
 
 	yaffs_verify_dir(parent);
 }
@@ -1313,8 +1362,11 @@ void yaffs_add_obj_to_dir(struct yaffs_obj *directory, struct yaffs_obj *obj)
 	yaffs_remove_obj_from_dir(obj);
 
 	/* Now add it */
+	spin_lock(&obj->my_dev->name_lock);
 	list_add(&obj->siblings, &directory->variant.dir_variant.children);
 	obj->parent = directory;
+	yaffs_name_rehash(obj);
+	spin_unlock(&obj->my_dev->name_lock);
 
 	if (directory == obj->my_dev->unlinked_dir
 	    || directory == obj->my_dev->del_dir) {
@@ -1856,6 +1908,7 @@ static struct yaffs_obj *yaffs_alloc_empty_obj(struct yaffs_dev *dev)
 		obj->variant_type = YAFFS_OBJECT_TYPE_UNKNOWN;
 		INIT_LIST_HEAD(&(obj->hard_links));
 		INIT_LIST_HEAD(&(obj->hash_link));
+		INIT_LIST_HEAD(&obj->name_link);
 		INIT_LIST_HEAD(&obj->siblings);
 
 		/* Now make the directory sane */
@@ -2060,6 +2113,11 @@ static void yaffs_init_tnodes_and_objs(struct yaffs_dev *dev)
 		INIT_LIST_HEAD(&dev->obj_bucket[i].list);
 		dev->obj_bucket[i].count = 0;
 	}
+
+	for (i = 0; i < YAFFS_NNAME_BUCKETS; i++)
+		INIT_LIST_HEAD(&dev->name_bucket[i]);
+	spin_lock_init(&dev->name_lock);
+	dev->name_index_ready = 0;
 }
 
 struct yaffs_obj *yaffs_find_or_create_by_number(struct yaffs_dev *dev,
@@ -4466,15 +4524,36 @@ static void yaffs_empty_l_n_f(struct yaffs_dev *dev)
 }
 
 
+static int yaffs_obj_name_matches(struct yaffs_obj *obj, const YCHAR * name)
+{
+	YCHAR buffer[YAFFS_MAX_NAME_LENGTH + 1];
+
+	yaffs_get_obj_name(obj, buffer, YAFFS_MAX_NAME_LENGTH + 1);
+	return strncmp(name, buffer, YAFFS_MAX_NAME_LENGTH) == 0;
+}
+
+/* The name index can stand in for a walk of the children if each child's
+ * name is in memory and its sum reflects the name yaffs_get_obj_name()
+ * will return.
+ */
+static int yaffs_obj_name_indexable(struct yaffs_obj *obj)
+{
+	if (obj->obj_id == YAFFS_OBJECTID_LOSTNFOUND)
+		return 1;
+	return !obj->lazy_loaded && obj->sum && obj->hdr_chunk > 0;
+}
+
 struct yaffs_obj *yaffs_find_by_name(struct yaffs_obj *directory,
 				     const YCHAR * name)
 {
 	int sum;
+	int indexable = 1;
 
 	struct list_head *i;
-	YCHAR buffer[YAFFS_MAX_NAME_LENGTH + 1];
+	struct yaffs_dev *dev;
 
 	struct yaffs_obj *l;
+	struct yaffs_obj *found = NULL;
 
 	if (!name)
 		return NULL;
@@ -4493,8 +4572,34 @@ struct yaffs_obj *yaffs_find_by_name(struct yaffs_obj *directory,
 		YBUG();
 	}
 
+	dev = directory->my_dev;
 	sum = yaffs_calc_name_sum(name);
 
+	if (directory->names_indexed) {
+		dev->name_index_hits++;
+
+		if (dev->lost_n_found &&
+		    dev->lost_n_found->parent == directory &&
+		    !strcmp(name, YAFFS_LOSTNFOUND_NAME))
+			return dev->lost_n_found;
+
+		list_for_each(i, &dev->name_bucket[yaffs_name_hash_fn(directory, sum)]) {
+			l = list_entry(i, struct yaffs_obj, name_link);
+
+			if (l->parent == directory &&
+			    l->sum == sum &&
+			    l->obj_id != YAFFS_OBJECTID_LOSTNFOUND &&
+			    yaffs_obj_name_matches(l, name))
+				return l;
+		}
+		return NULL;
+	}
+
+	/* Index not usable yet. Walk all the children, loading their
+	 * details as we go, and enable the index if they all check out.
+	 */
+	dev->name_index_scans++;
+
 	list_for_each(i, &directory->variant.dir_variant.children) {
 		if (i) {
 			l = list_entry(i, struct yaffs_obj, siblings);
@@ -4504,25 +4609,115 @@ struct yaffs_obj *yaffs_find_by_name(struct yaffs_obj *directory,
 
 			yaffs_check_obj_details_loaded(l);
 
+			if (!yaffs_obj_name_indexable(l))
+				indexable = 0;
+
+			if (found)
+				continue;
+
 			/* Special case for lost-n-found */
 			if (l->obj_id == YAFFS_OBJECTID_LOSTNFOUND) {
 				if (!strcmp(name, YAFFS_LOSTNFOUND_NAME))
-					return l;
+					found = l;
 			} else if (l->sum == sum
 				   || l->hdr_chunk <= 0) {
 				/* LostnFound chunk called Objxxx
 				 * Do a real check
 				 */
-				yaffs_get_obj_name(l, buffer,
-						   YAFFS_MAX_NAME_LENGTH + 1);
-				if (strncmp
-				    (name, buffer, YAFFS_MAX_NAME_LENGTH) == 0)
-					return l;
+				if (yaffs_obj_name_matches(l, name))
+					found = l;
 			}
 		}
 	}
 
-	return NULL;
+	if (indexable && dev->name_index_ready) {
+		spin_lock(&dev->name_lock);
+		directory->names_indexed = 1;
+		spin_unlock(&dev->name_lock);
+	}
+
+	return found;
+}
+
+/*
+ * yaffs_find_by_name_fast() answers a lookup from the name index without
+ * the gross lock. It only decides when everything it needs is in memory:
+ * the directory is indexed and every candidate has a short name. Returns
+ * 1 if *found is the answer, 0 if the caller must use yaffs_find_by_name()
+ * under the gross lock.
+ */
+int yaffs_find_by_name_fast(struct yaffs_obj *directory, const YCHAR * name,
+			    struct yaffs_obj **found)
+{
+	int sum;
+	int decided = 1;
+
+	struct list_head *i;
+	struct yaffs_dev *dev = directory->my_dev;
+
+	struct yaffs_obj *l;
+
+	*found = NULL;
+
+	if (!name || directory->variant_type != YAFFS_OBJECT_TYPE_DIRECTORY)
+		return 0;
+
+	sum = yaffs_calc_name_sum(name);
+
+	spin_lock(&dev->name_lock);
+
+	if (!directory->names_indexed) {
+		decided = 0;
+		goto out;
+	}
+
+	if (dev->lost_n_found &&
+	    dev->lost_n_found->parent == directory &&
+	    !strcmp(name, YAFFS_LOSTNFOUND_NAME)) {
+		*found = dev->lost_n_found;
+		goto out;
+	}
+
+	list_for_each(i, &dev->name_bucket[yaffs_name_hash_fn(directory, sum)]) {
+		l = list_entry(i, struct yaffs_obj, name_link);
+
+		if (l->parent != directory ||
+		    l->sum != sum ||
+		    l->obj_id == YAFFS_OBJECTID_LOSTNFOUND)
+			continue;
+
+		if (l->being_created || l->lazy_loaded) {
+			decided = 0;
+			break;
+		}
+#ifndef CONFIG_YAFFS_NO_SHORT_NAMES
+		if (l->short_name[0]) {
+			if (strncmp(name, l->short_name,
+				    YAFFS_MAX_NAME_LENGTH) == 0) {
+				*found = l;
+				break;
+			}
+			continue;
+		}
+#endif
+		/* Long names only live on NAND */
+		decided = 0;
+		break;
+	}
+
+	/* Hard links need their equivalent object, which may need loading */
+	if (decided && *found &&
+	    (*found)->variant_type == YAFFS_OBJECT_TYPE_HARDLINK)
+		decided = 0;
+
+out:
+	if (decided)
+		dev->name_fast_lookups++;
+	else
+		*found = NULL;
+	spin_unlock(&dev->name_lock);
+
+	return decided;
 }
 
 /* GetEquivalentObject dereferences any hard links to get to the
@@ -5063,6 +5258,11 @@ int yaffs_guts_initialise(struct yaffs_dev *dev)
 	if (!dev->is_checkpointed && dev->blocks_in_checkpt > 0)
 		yaffs2_checkpt_invalidate(dev);
 
+	/* Scanning and checkpoint restore can leave children lazy loaded
+	 * after they were linked in, so only trust the index from here on.
+	 */
+	dev->name_index_ready = 1;
+
 	yaffs_trace(YAFFS_TRACE_TRACING,
 	  "yaffs: yaffs_guts_initialise() done.");
 	return YAFFS_OK;
@@ -56,6 +56,7 @@
 #define YAFFS_ALLOCATION_NLINKS		100
 
 #define YAFFS_NOBJECT_BUCKETS		256
+#define YAFFS_NNAME_BUCKETS		512
 
 #define YAFFS_OBJECT_SPACE		0x40000
 #define YAFFS_MAX_OBJECT_ID		(YAFFS_OBJECT_SPACE -1)
@@ -398,6 +399,7 @@ struct yaffs_obj {
 
 	u8 xattr_known:1;	/* We know if this has object has xattribs or not. */
 	u8 has_xattr:1;		/* This object has xattribs. Valid if xattr_known. */
+	u8 names_indexed:1;	/* Directory: every child is in the name index */
 
 	u8 serial;		/* serial number of chunk in NAND. Cached here */
 	u16 sum;		/* sum of the name to speed searching */
@@ -405,6 +407,7 @@ struct yaffs_obj {
 	struct yaffs_dev *my_dev;	/* The device I'm on */
 
 	struct list_head hash_link;	/* list of objects in this hash bucket */
+	struct list_head name_link;	/* list of objects in this name bucket */
 
 	struct list_head hard_links;	/* all the equivalent hard linked objects */
 
@@ -656,6 +659,14 @@ struct yaffs_dev {
 	struct yaffs_obj_bucket obj_bucket[YAFFS_NOBJECT_BUCKETS];
 	u32 bucket_finder;
 
+	/* Directory child index, hashed on (parent, name sum).
+	 * name_lock guards the buckets, obj->parent, obj->sum and
+	 * obj->short_name against lookups done without the gross lock.
+	 */
+	struct list_head name_bucket[YAFFS_NNAME_BUCKETS];
+	spinlock_t name_lock;
+	int name_index_ready;
+
 	int n_free_chunks;
 
 	/* Garbage collection control */
@@ -734,6 +745,9 @@ struct yaffs_dev {
 	u32 n_unmarked_deletions;
 	u32 refresh_count;
 	u32 cache_hits;
+	u32 name_index_hits;
+	u32 name_index_scans;
+	u32 name_fast_lookups;
 
 };
 
@@ -822,6 +836,8 @@ struct yaffs_obj *yaffs_create_dir(struct yaffs_obj *parent, const YCHAR * name,
 				   u32 mode, u32 uid, u32 gid);
 struct yaffs_obj *yaffs_find_by_name(struct yaffs_obj *the_dir,
 				     const YCHAR * name);
+int yaffs_find_by_name_fast(struct yaffs_obj *the_dir, const YCHAR * name,
+			    struct yaffs_obj **found);
 struct yaffs_obj *yaffs_find_by_number(struct yaffs_dev *dev, u32 number);
 
 /* Link operations */
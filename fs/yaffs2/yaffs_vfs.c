@@ -372,20 +372,27 @@ static struct dentry *yaffs_lookup(struct inode *dir, struct dentry *dentry,
 
 	struct yaffs_dev *dev = yaffs_inode_to_obj(dir)->my_dev;
 
-	if (current != yaffs_dev_to_lc(dev)->readdir_process)
-		yaffs_gross_lock(dev);
-
 	yaffs_trace(YAFFS_TRACE_OS,
 		"yaffs_lookup for %d:%s",
 		yaffs_inode_to_obj(dir)->obj_id, dentry->d_name.name);
 
-	obj = yaffs_find_by_name(yaffs_inode_to_obj(dir), dentry->d_name.name);
+	/* Most lookups can be answered from the name index without
+	 * waiting for the gross lock.
+	 */
+	if (!yaffs_find_by_name_fast(yaffs_inode_to_obj(dir),
+				     dentry->d_name.name, &obj)) {
+		if (current != yaffs_dev_to_lc(dev)->readdir_process)
+			yaffs_gross_lock(dev);
 
-	obj = yaffs_get_equivalent_obj(obj);	/* in case it was a hardlink */
+		obj = yaffs_find_by_name(yaffs_inode_to_obj(dir),
+					 dentry->d_name.name);
 
-	/* Can't hold gross lock when calling yaffs_get_inode() */
-	if (current != yaffs_dev_to_lc(dev)->readdir_process)
-		yaffs_gross_unlock(dev);
+		obj = yaffs_get_equivalent_obj(obj);	/* in case it was a hardlink */
+
+		/* Can't hold gross lock when calling yaffs_get_inode() */
+		if (current != yaffs_dev_to_lc(dev)->readdir_process)
+			yaffs_gross_unlock(dev);
+	}
 
 	if (obj) {
 		yaffs_trace(YAFFS_TRACE_OS,
@@ -2484,6 +2491,13 @@ static char *yaffs_dump_dev_part1(char *buf, struct yaffs_dev *dev)
 	    sprintf(buf, "n_tags_ecc_unfixed.... %u\n",
 		    dev->n_tags_ecc_unfixed);
 	buf += sprintf(buf, "cache_hits............ %u\n", dev->cache_hits);
+	buf +=
+	    sprintf(buf, "name_index_hits....... %u\n", dev->name_index_hits);
+	buf +=
+	    sprintf(buf, "name_index_scans...... %u\n", dev->name_index_scans);
+	buf +=
+	    sprintf(buf, "name_fast_lookups..... %u\n",
+		    dev->name_fast_lookups);
 	buf +=
 	    sprintf(buf, "n_deleted_files....... %u\n", dev->n_deleted_files);
 	buf +=
@@ -25,6 +25,7 @@
 #include <linux/vmalloc.h>
 #include <linux/xattr.h>
 #include <linux/list.h>
+#include <linux/spinlock.h>
 #include <linux/types.h>
 #include <linux/fs.h>
 #include <linux/stat.h>
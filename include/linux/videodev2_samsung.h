@@ -78,6 +78,8 @@ enum v4l2_photometry_mode {
 #define V4L2_CID_OVERLAY_VADDR2		(V4L2_CID_PRIVATE_BASE + 8)
 #define V4L2_CID_OVLY_MODE		(V4L2_CID_PRIVATE_BASE + 9)
 #define V4L2_CID_DST_INFO		(V4L2_CID_PRIVATE_BASE + 10)
+/* S_CTRL with a capture buffer index, returns a shared buffer fd */
+#define V4L2_CID_EXPORT_BUF		(V4L2_CID_PRIVATE_BASE + 11)
 /* UMP secure id control */
 #define V4L2_CID_GET_PHY_SRC_YADDR 	(V4L2_CID_PRIVATE_BASE + 12)
 #define V4L2_CID_GET_PHY_SRC_CADDR 	(V4L2_CID_PRIVATE_BASE + 13)
@@ -618,6 +620,12 @@ struct v4l2_recognition {
 #define VIDIOC_S_RECOGNITION	_IOWR('V', 85, struct v4l2_recognition)
 #define VIDIOC_G_RECOGNITION	_IOR('V', 86, struct v4l2_recognition)
 
+/*
+ * V4L2_MEMORY_USERPTR output buffers: m.userptr carries a shared buffer
+ * fd (see plat/media-buf.h) instead of a struct fimc_buf pointer.
+ */
+#define V4L2_BUF_FLAG_SHARED_FD	0x10000000
+
 /* We use this struct as the v4l2_streamparm raw_data for
  * VIDIOC_G_PARM and VIDIOC_S_PARM
  */
@@ -687,6 +687,22 @@ static struct file_operations ashmem_fops = {
 	.compat_ioctl = ashmem_ioctl,
 };
 
+/*
+ * ashmem_file_size - size of the region behind @file, or 0 if @file is not
+ * an ashmem file.  Lets drivers that pass descriptors around, like binder,
+ * account for the memory they hand over by reference.
+ */
+size_t ashmem_file_size(struct file *file)
+{
+	struct ashmem_area *asma;
+
+	if (file->f_op != &ashmem_fops)
+		return 0;
+	asma = file->private_data;
+	return asma->size;
+}
+EXPORT_SYMBOL(ashmem_file_size);
+
 static struct miscdevice ashmem_misc = {
 	.minor = MISC_DYNAMIC_MINOR,
 	.name = "ashmem",
@@ -122,6 +122,162 @@ bool debug_log(short unsigned int level)
 	return false;
 }
 
+/*
+ * Register shadow
+ *
+ * Keep a copy of what was last written to the registers the extensions
+ * read back or rewrite, so that an update costs no I2C read and only
+ * sends what actually changes. Every write going through wm8994_write()
+ * lands here; a software reset or a failed transfer forgets the values.
+ * The codec never changes any of these registers on its own.
+ */
+#define SHADOW_REGS		(WM8994_SIDETONE + 1)
+#define SHADOW_BLOCK_MAX	(WM8994_AIF1_DAC1_EQ_BAND_5_PG - \
+				 WM8994_AIF1_DAC1_EQ_GAINS_1 + 1)
+
+static unsigned short shadow[SHADOW_REGS];
+static DECLARE_BITMAP(shadow_valid, SHADOW_REGS);
+
+static struct {
+	unsigned int reads;
+	unsigned int hits;
+	unsigned int skipped;
+	unsigned int blocks;
+} shadow_stats;
+
+static bool shadow_cacheable(unsigned int reg)
+{
+	return (reg >= WM8994_LEFT_LINE_INPUT_1_2_VOLUME
+		&& reg <= WM8994_OUTPUT_MIXER_2)
+	    || (reg >= WM8994_FLL1_CONTROL_1 && reg <= WM8994_FLL1_CONTROL_5)
+	    || (reg >= WM8994_AIF1_ADC1_LEFT_VOLUME
+		&& reg <= WM8994_AIF2_EQ_BAND_5_PG)
+	    || (reg >= WM8994_DAC1_LEFT_VOLUME && reg <= WM8994_SIDETONE);
+}
+
+static void shadow_store(unsigned int reg, unsigned short value)
+{
+	if (reg == WM8994_SOFTWARE_RESET) {
+		bitmap_zero(shadow_valid, SHADOW_REGS);
+		return;
+	}
+
+	if (!shadow_cacheable(reg))
+		return;
+
+	shadow[reg] = value;
+	set_bit(reg, shadow_valid);
+}
+
+static bool shadow_same(unsigned int reg, unsigned short value)
+{
+	return shadow_cacheable(reg) && test_bit(reg, shadow_valid)
+	    && shadow[reg] == value;
+}
+
+void wm8994_extensions_write_failed(unsigned int reg)
+{
+	if (shadow_cacheable(reg))
+		clear_bit(reg, shadow_valid);
+}
+
+static unsigned short shadow_read(unsigned int reg)
+{
+	unsigned short val;
+
+	if (shadow_cacheable(reg) && test_bit(reg, shadow_valid)) {
+		shadow_stats.hits++;
+		return shadow[reg];
+	}
+
+	shadow_stats.reads++;
+	val = wm8994_read(codec, reg);
+	shadow_store(reg, val);
+
+	return val;
+}
+
+// write a register only if the codec doesn't hold this value already
+static void shadow_update(unsigned int reg, unsigned short value)
+{
+	if (shadow_same(reg, value)) {
+		shadow_stats.skipped++;
+		return;
+	}
+
+	wm8994_write(codec, reg, value);
+}
+
+/*
+ * Send count consecutive registers starting at reg in a single I2C
+ * transfer, relying on the control interface address auto-increment
+ * (AUTO_INC, on by default). Nothing is sent when none of them changed.
+ * With trim, only the span between the first and the last changed
+ * register goes out; leave it off when a later register latches the
+ * earlier ones (volume update bits).
+ * The values bypass the write hook: callers pass final values.
+ */
+static int shadow_write_block(unsigned int reg, const unsigned short *val,
+			      int count, bool trim)
+{
+	u8 data[2 + 2 * SHADOW_BLOCK_MAX];
+	int first = 0;
+	int last = count - 1;
+	int len;
+	int ret;
+	int i;
+
+	if (WARN_ON(count > SHADOW_BLOCK_MAX))
+		return -EINVAL;
+
+	while (first <= last && shadow_same(reg + first, val[first]))
+		first++;
+	while (last >= first && shadow_same(reg + last, val[last]))
+		last--;
+
+	if (first > last) {
+		shadow_stats.skipped += count;
+		return 0;
+	}
+
+	if (trim) {
+		shadow_stats.skipped += count - (last - first + 1);
+	} else {
+		first = 0;
+		last = count - 1;
+	}
+
+	data[0] = ((reg + first) & 0xff00) >> 8;
+	data[1] = (reg + first) & 0x00ff;
+	for (i = first; i <= last; i++) {
+		data[2 + 2 * (i - first)] = val[i] >> 8;
+		data[3 + 2 * (i - first)] = val[i] & 0x00ff;
+	}
+	len = 2 + 2 * (last - first + 1);
+
+	if (debug_log(LOG_VERBOSE))
+		printk("wm8994_extensions: block write 0x%03X-0x%03X\n",
+		       reg + first, reg + last);
+
+	ret = codec->hw_write(codec->control_data, data, len);
+
+	for (i = first; i <= last; i++) {
+		if (ret == len)
+			shadow_store(reg + i, val[i]);
+		else
+			wm8994_extensions_write_failed(reg + i);
+	}
+
+	if (ret != len) {
+		pr_err("wm8994_extensions: i2c block write problem at 0x%03X\n",
+		       reg + first);
+		return ret < 0 ? ret : -EIO;
+	}
+
+	shadow_stats.blocks++;
+	return 0;
+}
+
 #ifdef CONFIG_SND_WM8994_EXTENSIONS_HP_LEVEL_CONTROL
 int hpvol(int channel)
 {
@@ -143,18 +299,18 @@ int hpvol(int channel)
 
 void write_hpvol(unsigned short l, unsigned short r)
 {
-	unsigned short val;
+	unsigned short val[2];
 
 	// we don't need the Volume Update flag when sending the first volume
-	val = (WM8994_HPOUT1L_MUTE_N | l);
-	val |= WM8994_HPOUT1L_ZC;
-	wm8994_write(codec, WM8994_LEFT_OUTPUT_VOLUME, val);
+	val[0] = (WM8994_HPOUT1L_MUTE_N | l);
+	val[0] |= WM8994_HPOUT1L_ZC;
 
 	// this time we write the right volume plus the Volume Update flag.
-	// This way, both volume are set at the same time
-	val = (WM8994_HPOUT1_VU | WM8994_HPOUT1R_MUTE_N | r);
-	val |= WM8994_HPOUT1L_ZC;
-	wm8994_write(codec, WM8994_RIGHT_OUTPUT_VOLUME, val);
+	// This way, both volume are set at the same time, on a zero cross
+	val[1] = (WM8994_HPOUT1_VU | WM8994_HPOUT1R_MUTE_N | r);
+	val[1] |= WM8994_HPOUT1L_ZC;
+
+	shadow_write_block(WM8994_LEFT_OUTPUT_VOLUME, val, 2, false);
 }
 
 void update_hpvol(bool with_fade)
@@ -184,7 +340,7 @@ void update_hpvol(bool with_fade)
 
 	// read previous levels
 	for (i = 0; i < 2; i++) {
-		val = wm8994_read(codec, hp_level_registers[i]);
+		val = shadow_read(hp_level_registers[i]);
 		val &= ~(WM8994_HPOUT1_VU_MASK);
 		val &= ~(WM8994_HPOUT1L_ZC_MASK);
 		val &= ~(WM8994_HPOUT1L_MUTE_N_MASK);
@@ -221,8 +377,10 @@ void update_hpvol(bool with_fade)
 		write_hpvol(hpvol(0) - steps, hpvol(1) - steps);
 		bypass_write_extension = false;
 
+		// the zero cross detection smooths each step, the
+		// sleep only paces them
 		if (steps != 0)
-			udelay(1000);
+			usleep_range(1000, 1500);
 	}
 
 }
@@ -607,9 +765,9 @@ unsigned short osr128_get_value(unsigned short val)
 void update_osr128(bool with_mute)
 {
 	unsigned short val;
-	val = osr128_get_value(wm8994_read(codec, WM8994_OVERSAMPLING));
+	val = osr128_get_value(shadow_read(WM8994_OVERSAMPLING));
 	bypass_write_extension = true;
-	wm8994_write(codec, WM8994_OVERSAMPLING, val);
+	shadow_update(WM8994_OVERSAMPLING, val);
 	bypass_write_extension = false;
 }
 
@@ -626,9 +784,9 @@ unsigned short fll_tuning_get_value(unsigned short val)
 void update_fll_tuning(bool with_mute)
 {
 	unsigned short val;
-	val = fll_tuning_get_value(wm8994_read(codec, WM8994_FLL1_CONTROL_4));
+	val = fll_tuning_get_value(shadow_read(WM8994_FLL1_CONTROL_4));
 	bypass_write_extension = true;
-	wm8994_write(codec, WM8994_FLL1_CONTROL_4, val);
+	shadow_update(WM8994_FLL1_CONTROL_4, val);
 	bypass_write_extension = false;
 }
 #endif
@@ -653,20 +811,17 @@ unsigned short mono_downmix_get_value(unsigned short val, bool can_reverse)
 void update_mono_downmix(bool with_mute)
 {
 	unsigned short val1, val2, val3;
-	val1 = mono_downmix_get_value(wm8994_read
-				      (codec, WM8994_AIF1_DAC1_FILTERS_1),
+	val1 = mono_downmix_get_value(shadow_read(WM8994_AIF1_DAC1_FILTERS_1),
 				      true);
-	val2 = mono_downmix_get_value(wm8994_read
-				      (codec, WM8994_AIF1_DAC2_FILTERS_1),
+	val2 = mono_downmix_get_value(shadow_read(WM8994_AIF1_DAC2_FILTERS_1),
 				      true);
-	val3 = mono_downmix_get_value(wm8994_read
-				      (codec, WM8994_AIF2_DAC_FILTERS_1),
+	val3 = mono_downmix_get_value(shadow_read(WM8994_AIF2_DAC_FILTERS_1),
 				      true);
 
 	bypass_write_extension = true;
-	wm8994_write(codec, WM8994_AIF1_DAC1_FILTERS_1, val1);
-	wm8994_write(codec, WM8994_AIF1_DAC2_FILTERS_1, val2);
-	wm8994_write(codec, WM8994_AIF2_DAC_FILTERS_1, val3);
+	shadow_update(WM8994_AIF1_DAC1_FILTERS_1, val1);
+	shadow_update(WM8994_AIF1_DAC2_FILTERS_1, val2);
+	shadow_update(WM8994_AIF2_DAC_FILTERS_1, val3);
 	bypass_write_extension = false;
 }
 
@@ -689,14 +844,12 @@ unsigned short dac_direct_get_value(unsigned short val, bool can_reverse)
 void update_dac_direct(bool with_mute)
 {
 	unsigned short val1, val2;
-	val1 = dac_direct_get_value(wm8994_read(codec,
-						WM8994_OUTPUT_MIXER_1), true);
-	val2 = dac_direct_get_value(wm8994_read(codec,
-						WM8994_OUTPUT_MIXER_2), true);
+	val1 = dac_direct_get_value(shadow_read(WM8994_OUTPUT_MIXER_1), true);
+	val2 = dac_direct_get_value(shadow_read(WM8994_OUTPUT_MIXER_2), true);
 
 	bypass_write_extension = true;
-	wm8994_write(codec, WM8994_OUTPUT_MIXER_1, val1);
-	wm8994_write(codec, WM8994_OUTPUT_MIXER_2, val2);
+	shadow_update(WM8994_OUTPUT_MIXER_1, val1);
+	shadow_update(WM8994_OUTPUT_MIXER_2, val2);
 	bypass_write_extension = false;
 }
 
@@ -731,24 +884,49 @@ unsigned short digital_gain_get_value(unsigned short val)
 
 void update_digital_gain(bool with_mute)
 {
-	unsigned short val1, val2;
-	val1 = digital_gain_get_value(wm8994_read(codec,
-						WM8994_AIF1_DAC1_LEFT_VOLUME));
-	val2 = digital_gain_get_value(wm8994_read(codec,
-						WM8994_AIF1_DAC1_RIGHT_VOLUME));
+	unsigned short val[2];
+	val[0] = digital_gain_get_value(
+			shadow_read(WM8994_AIF1_DAC1_LEFT_VOLUME));
+	val[1] = digital_gain_get_value(
+			shadow_read(WM8994_AIF1_DAC1_RIGHT_VOLUME));
 
-	bypass_write_extension = true;
-	wm8994_write(codec, WM8994_AIF1_DAC1_LEFT_VOLUME,
-		     WM8994_DAC1_VU | val1);
-	wm8994_write(codec, WM8994_AIF1_DAC1_RIGHT_VOLUME,
-		     WM8994_DAC1_VU | val2);
-	bypass_write_extension = false;
+	val[0] |= WM8994_DAC1_VU;
+	val[1] |= WM8994_DAC1_VU;
+	shadow_write_block(WM8994_AIF1_DAC1_LEFT_VOLUME, val, 2, false);
+}
+
+// fill the two EQ gain registers for the given band gains
+static void eq_gains_get_values(const short *gains, unsigned short *val)
+{
+	val[0] =
+	    ((gains[0] + 12) << WM8994_AIF1DAC1_EQ_B1_GAIN_SHIFT) |
+	    ((gains[1] + 12) << WM8994_AIF1DAC1_EQ_B2_GAIN_SHIFT) |
+	    ((gains[2] + 12) << WM8994_AIF1DAC1_EQ_B3_GAIN_SHIFT) |
+	    headphone_eq;
+
+	val[1] =
+	    ((gains[3] + 12) << WM8994_AIF1DAC1_EQ_B4_GAIN_SHIFT) |
+	    ((gains[4] + 12) << WM8994_AIF1DAC1_EQ_B5_GAIN_SHIFT);
+}
+
+// fill the band coefficient registers, in register order
+static int eq_bands_get_values(unsigned short *val)
+{
+	int i;
+	int j;
+	int k = 0;
+
+	for (i = 0; i < ARRAY_SIZE(eq_band_values); i++)
+		for (j = 0; j < eq_bands[i]; j++)
+			val[k++] = eq_band_values[i][j];
+
+	return k;
 }
 
 void update_headphone_eq(bool update_bands)
 {
-	int gains_1;
-	int gains_2;
+	unsigned short val[SHADOW_BLOCK_MAX];
+	int count = 2;
 
 	if (!is_path_media_or_fm_no_call_no_record()) {
 		// don't apply the EQ
@@ -760,79 +938,147 @@ void update_headphone_eq(bool update_bands)
 		       eq_gains[0], eq_gains[1], eq_gains[2],
 		       eq_gains[3], eq_gains[4]);
 
-	gains_1 =
-	    ((eq_gains[0] + 12) << WM8994_AIF1DAC1_EQ_B1_GAIN_SHIFT) |
-	    ((eq_gains[1] + 12) << WM8994_AIF1DAC1_EQ_B2_GAIN_SHIFT) |
-	    ((eq_gains[2] + 12) << WM8994_AIF1DAC1_EQ_B3_GAIN_SHIFT) |
-	    headphone_eq;
+	eq_gains_get_values(eq_gains, val);
 
-	gains_2 =
-	    ((eq_gains[3] + 12) << WM8994_AIF1DAC1_EQ_B4_GAIN_SHIFT) |
-	    ((eq_gains[4] + 12) << WM8994_AIF1DAC1_EQ_B5_GAIN_SHIFT);
+	// don't send EQ configuration if its not enabled
+	if (headphone_eq && update_bands)
+		count += eq_bands_get_values(val + 2);
 
-	wm8994_write(codec, WM8994_AIF1_DAC1_EQ_GAINS_1, gains_1);
-	wm8994_write(codec, WM8994_AIF1_DAC1_EQ_GAINS_2, gains_2);
+	// gains and bands follow each other: a whole preset is a single
+	// transfer, carrying only the registers that differ
+	shadow_write_block(WM8994_AIF1_DAC1_EQ_GAINS_1, val, count, true);
+}
 
-	// don't send EQ configuration if its not enabled
-	if (!headphone_eq)
+void update_headphone_eq_bands()
+{
+	unsigned short val[SHADOW_BLOCK_MAX];
+	int count;
+
+	if (debug_log(LOG_INFOS))
+		printk("wm8994_extensions: send EQ Bands\n");
+
+	count = eq_bands_get_values(val);
+	shadow_write_block(WM8994_AIF1_DAC1_EQ_BAND_1_A, val, count, true);
+}
+
+/*
+ * Loading new coefficients into a running EQ jumps the filter response
+ * and clicks. When the EQ currently colours the sound, let the AIF1DAC1
+ * soft mute ramp the signal down, swap the bands and ramp it back up.
+ * The fast mute ramp lasts up to 10.7ms at 48kHz, a bit more at 44.1kHz.
+ */
+#define EQ_SOFT_MUTE_MS		12
+
+static void update_headphone_eq_bands_muted(void)
+{
+	unsigned short val[SHADOW_BLOCK_MAX];
+	unsigned short flat[2];
+	unsigned short gains_1, gains_2, filters;
+	short zero[ARRAY_SIZE(eq_gains)] = { 0 };
+	int count;
+	int i;
+
+	count = eq_bands_get_values(val);
+	for (i = 0; i < count; i++)
+		if (!shadow_same(WM8994_AIF1_DAC1_EQ_BAND_1_A + i, val[i]))
+			break;
+	if (i == count)
 		return;
 
-	if (update_bands)
+	eq_gains_get_values(zero, flat);
+	gains_1 = shadow_read(WM8994_AIF1_DAC1_EQ_GAINS_1);
+	gains_2 = shadow_read(WM8994_AIF1_DAC1_EQ_GAINS_2);
+	filters = shadow_read(WM8994_AIF1_DAC1_FILTERS_1);
+
+	if (!(gains_1 & WM8994_AIF1DAC1_EQ_ENA)
+	    || (filters & WM8994_AIF1DAC1_MUTE)
+	    || ((gains_1 & ~WM8994_AIF1DAC1_EQ_ENA)
+		== (flat[0] & ~WM8994_AIF1DAC1_EQ_ENA)
+		&& gains_2 == flat[1])) {
 		update_headphone_eq_bands();
+		return;
+	}
+
+	if (debug_log(LOG_INFOS))
+		printk("wm8994_extensions: EQ Bands swap under soft mute\n");
+
+	/*
+	 * bypass_write_extension is global: only hold it for our own
+	 * writes, so the main driver keeps going through the hooks while
+	 * the ramps run.
+	 */
+	bypass_write_extension = true;
+	wm8994_write(codec, WM8994_AIF1_DAC1_FILTERS_1,
+		     (filters & ~WM8994_AIF1DAC1_MUTERATE) |
+		     WM8994_AIF1DAC1_MUTE |
+		     WM8994_AIF1DAC1_UNMUTE_RAMP);
+	bypass_write_extension = false;
+	msleep(EQ_SOFT_MUTE_MS);
+
+	update_headphone_eq_bands();
+
+	bypass_write_extension = true;
+	wm8994_write(codec, WM8994_AIF1_DAC1_FILTERS_1,
+		     (filters & ~WM8994_AIF1DAC1_MUTERATE) |
+		     WM8994_AIF1DAC1_UNMUTE_RAMP);
+	bypass_write_extension = false;
+	shadow_update(WM8994_AIF1_DAC1_FILTERS_1, filters);
+	msleep(EQ_SOFT_MUTE_MS);
 }
 
-void update_headphone_eq_bands()
+// walk every band towards target in 1dB steps, all bands together
+static void smooth_apply_eq_gains(const short *target)
 {
+	bool done = false;
 	int i;
-	int j;
-	int k = 0;
-	int first_reg = WM8994_AIF1_DAC1_EQ_BAND_1_A;
 
-	for (i = 0; i < ARRAY_SIZE(eq_band_values); i++) {
-		if (debug_log(LOG_INFOS))
-			printk("wm8994_extensions: send EQ Band %d\n", i + 1);
+	while (!done) {
+		done = true;
+		for (i = 0; i < ARRAY_SIZE(eq_gains); i++) {
+			if (eq_gains[i] == target[i])
+				continue;
 
-		for (j = 0; j < eq_bands[i]; j++) {
-			wm8994_write(codec,
-				     first_reg + k, eq_band_values[i][j]);
-			k++;
+			if (eq_gains[i] < target[i])
+				eq_gains[i]++;
+			else
+				eq_gains[i]--;
+			done = false;
 		}
+
+		if (!done)
+			update_headphone_eq(false);
 	}
 }
 
 void smooth_apply_eq_band_gain(int band, int start, int end, bool current_state)
 {
+	short target[ARRAY_SIZE(eq_gains)];
+
 	if (debug_log(LOG_INFOS))
 		printk("wm8994_extensions: EQ smooth transition for Band %d "
 		       "from %d to %d\n", band + 1, start, end);
 
 	if (start == end) {
-		if (end != 0)
-			update_headphone_eq(true);
-		else
-			update_headphone_eq(false);
+		update_headphone_eq(false);
+		if (end != 0 && headphone_eq)
+			update_headphone_eq_bands_muted();
 		return;
 	}
 
 	if (current_state)
-		update_headphone_eq_bands();
-
-	while (start != end) {
-		if (start < end)
-			start++;
-		else
-			start--;
+		update_headphone_eq_bands_muted();
 
-		eq_gains[band] = start;
-		update_headphone_eq(false);
-	}
+	memcpy(target, eq_gains, sizeof(target));
+	target[band] = end;
+	eq_gains[band] = start;
+	smooth_apply_eq_gains(target);
 }
 
 void update_stereo_expansion(bool with_mute)
 {
 	short unsigned int val;
 
-	val = wm8994_read(codec, WM8994_AIF1_DAC1_FILTERS_2);
+	val = shadow_read(WM8994_AIF1_DAC1_FILTERS_2);
 	if (stereo_expansion) {
 		val &= ~(WM8994_AIF1DAC1_3D_GAIN_MASK);
 		val |= (stereo_expansion_gain << WM8994_AIF1DAC1_3D_GAIN_SHIFT);
@@ -840,7 +1086,7 @@ void update_stereo_expansion(bool with_mute)
 	val &= ~(WM8994_AIF1DAC1_3D_ENA_MASK);
 	val |= (stereo_expansion << WM8994_AIF1DAC1_3D_ENA_SHIFT);
 
-	wm8994_write(codec, WM8994_AIF1_DAC1_FILTERS_2, val);
+	shadow_update(WM8994_AIF1_DAC1_FILTERS_2, val);
 }
 
 void load_current_eq_values()
@@ -852,14 +1098,14 @@ void load_current_eq_values()
 
 	for (i = 0; i < ARRAY_SIZE(eq_band_values); i++)
 		for (j = 0; j < eq_bands[i]; j++) {
-			eq_band_values[i][j] =
-			    wm8994_read(codec, first_reg + k);
+			eq_band_values[i][j] = shadow_read(first_reg + k);
 			k++;
 		}
 }
 
 void apply_saturation_prevention_drc()
 {
+	unsigned short drc[4];
 	unsigned short val;
 	unsigned short drc_gain = 0;
 	int i;
@@ -884,8 +1130,13 @@ void apply_saturation_prevention_drc()
 	// configure the DRC to avoid saturation: not actually compress signal
 	// gain is unmodified. Should affect only what's higher than 0 dBFS
 
+	// the four DRC registers are contiguous: compute them all and only
+	// send what changed, in one transfer
+	for (i = 0; i < ARRAY_SIZE(drc); i++)
+		drc[i] = shadow_read(WM8994_AIF1_DRC1_1 + i);
+
 	// tune Attack & Decacy values
-	val = wm8994_read(codec, WM8994_AIF1_DRC1_2);
+	val = drc[1];
 	val &= ~(WM8994_AIF1DRC1_ATK_MASK);
 	val &= ~(WM8994_AIF1DRC1_DCY_MASK);
 	val |= (0x1 << WM8994_AIF1DRC1_ATK_SHIFT);
@@ -895,14 +1146,12 @@ void apply_saturation_prevention_drc()
 	val &= ~(WM8994_AIF1DRC1_MAXGAIN_MASK);
 	val |= (0x3 << WM8994_AIF1DRC1_MAXGAIN_SHIFT);
 
-	wm8994_write(codec, WM8994_AIF1_DRC1_2, val);
+	drc[1] = val;
 
 	// Above knee: flat (what really avoid the saturation)
-	val = wm8994_read(codec, WM8994_AIF1_DRC1_3);
-	val |= (0x5 << WM8994_AIF1DRC1_HI_COMP_SHIFT);
-	wm8994_write(codec, WM8994_AIF1_DRC1_3, val);
+	drc[2] |= (0x5 << WM8994_AIF1DRC1_HI_COMP_SHIFT);
 
-	val = wm8994_read(codec, WM8994_AIF1_DRC1_1);
+	val = drc[0];
 	// disable Quick Release and Anti Clip
 	// both do do more harm than good for this particular usage
 	val &= ~(WM8994_AIF1DRC1_QR_MASK);
@@ -911,9 +1160,9 @@ void apply_saturation_prevention_drc()
 	// enable DRC
 	val &= ~(WM8994_AIF1DAC1_DRC_ENA_MASK);
 	val |= WM8994_AIF1DAC1_DRC_ENA;
-	wm8994_write(codec, WM8994_AIF1_DRC1_1, val);
+	drc[0] = val;
 
-	val = wm8994_read(codec, WM8994_AIF1_DRC1_4);
+	val = drc[3];
 	val &= ~(WM8994_AIF1DRC1_KNEE_IP_MASK);
 
 	if (digital_gain >= 0) {
@@ -928,7 +1177,9 @@ void apply_saturation_prevention_drc()
 			       digital_gain, step, i, i * step);
 
 	}
-	wm8994_write(codec, WM8994_AIF1_DRC1_4, val);
+	drc[3] = val;
+
+	shadow_write_block(WM8994_AIF1_DRC1_1, drc, ARRAY_SIZE(drc), true);
 }
 
 /*
@@ -1382,31 +1633,36 @@ static ssize_t headphone_eq_store(struct device *dev,
 {
 	unsigned short state;
 	bool current_state;
-	int i;
 	short eq_gains_copy[ARRAY_SIZE(eq_gains)];
+	short zero[ARRAY_SIZE(eq_gains)] = { 0 };
 
 	if (sscanf(buf, "%hu", &state) == 1) {
 		current_state = state == 0 ? false : true;
 		if (debug_log(LOG_INFOS))
 			printk("wm8994_extensions: EQ activation: %u\n", state);
 
-		if (current_state) {
-			// fade from 0dB each EQ band
+		if (current_state == headphone_eq) {
+			// nothing to fade, only resend what may have changed
+			update_headphone_eq(false);
+			if (headphone_eq)
+				update_headphone_eq_bands_muted();
+		} else if (current_state) {
+			// enable flat with the bands loaded, then fade every
+			// band from 0dB at once
+			memcpy(eq_gains_copy, eq_gains, sizeof(eq_gains));
+			memset(eq_gains, 0, sizeof(eq_gains));
 			headphone_eq = current_state;
-			for (i = 0; i < ARRAY_SIZE(eq_bands); i++)
-				smooth_apply_eq_band_gain(i, 0, eq_gains[i],
-							  current_state);
+			update_headphone_eq(true);
+			smooth_apply_eq_gains(eq_gains_copy);
 		} else {
-			// fade to 0dB each EQ band
-			for (i = 0; i < ARRAY_SIZE(eq_bands); i++) {
-				eq_gains_copy[i] = eq_gains[i];
-				smooth_apply_eq_band_gain(i, eq_gains[i], 0,
-							  current_state);
-			}
-			// restore original gains in driver memory not codec
-			for (i = 0; i < ARRAY_SIZE(eq_bands); i++)
-				eq_gains[i] = eq_gains_copy[i];
+			// fade every band to 0dB at once
+			memcpy(eq_gains_copy, eq_gains, sizeof(eq_gains));
+			smooth_apply_eq_gains(zero);
+			// restore original gains in driver memory, then
+			// disable the now flat EQ
+			memcpy(eq_gains, eq_gains_copy, sizeof(eq_gains));
 			headphone_eq = current_state;
+			update_headphone_eq(false);
 		}
 	}
 	return size;
@@ -1519,6 +1775,18 @@ static ssize_t stereo_expansion_gain_store(struct device *dev,
 	return size;
 }
 
+static ssize_t register_shadow_stats_show(struct device *dev,
+					  struct device_attribute *attr,
+					  char *buf)
+{
+	return sprintf(buf, "i2c reads: %u\n"
+		       "shadow reads: %u\n"
+		       "skipped writes: %u\n"
+		       "block writes: %u\n",
+		       shadow_stats.reads, shadow_stats.hits,
+		       shadow_stats.skipped, shadow_stats.blocks);
+}
+
 #ifdef CONFIG_SND_WM8994_EXTENSIONS_DEVELOPMENT
 static ssize_t show_wm8994_register_dump(struct device *dev,
 					 struct device_attribute *attr,
@@ -1776,6 +2044,10 @@ static DEVICE_ATTR(mono_downmix, S_IRUGO | S_IWUGO,
 		   mono_downmix_show,
 		   mono_downmix_store);
 
+static DEVICE_ATTR(register_shadow_stats, S_IRUGO,
+		   register_shadow_stats_show,
+		   NULL);
+
 #ifdef CONFIG_SND_WM8994_EXTENSIONS_DEVELOPMENT
 static DEVICE_ATTR(wm8994_register_dump, S_IRUGO,
 		   show_wm8994_register_dump,
@@ -1838,6 +2110,7 @@ static struct attribute *wm8994_extensions_attributes[] = {
 	&dev_attr_stereo_expansion.attr,
 	&dev_attr_stereo_expansion_gain.attr,
 	&dev_attr_mono_downmix.attr,
+	&dev_attr_register_shadow_stats.attr,
 #ifdef CONFIG_SND_WM8994_EXTENSIONS_DEVELOPMENT
 	&dev_attr_wm8994_register_dump.attr,
 	&dev_attr_wm8994_write.attr,
@@ -1958,8 +2231,10 @@ unsigned int wm8994_extensions_write(struct snd_soc_codec *codec_,
 	DECLARE_WM8994(codec_);
 
 	// global kill switch
-	if (!enable)
+	if (!enable) {
+		shadow_store(reg, value);
 		return value;
+	}
 
 	// modify some registers before those being written to the codec
 	// be sure our pointer to codec is up to date
@@ -2114,6 +2389,8 @@ unsigned int wm8994_extensions_write(struct snd_soc_codec *codec_,
 		);
 #endif
 #endif
+	shadow_store(reg, value);
+
         return value;
 }
 
@@ -42,6 +42,7 @@ bool is_path(int unified_path);
 bool is_path_media_or_fm_no_call_no_record(void);
 unsigned int wm8994_extensions_write(struct snd_soc_codec *codec,
 				      unsigned int reg, unsigned int value);
+void wm8994_extensions_write_failed(unsigned int reg);
 void wm8994_extensions_fmradio_headset(void);
 void wm8994_extensions_pcm_probe(struct snd_soc_codec *codec);
 void wm8994_extensions_pcm_remove(void);
@@ -202,6 +202,9 @@ int wm8994_write(struct snd_soc_codec *codec, unsigned int reg,
 		return 0;
 	else {
 		pr_err("i2c write problem occured\n");
+#ifdef CONFIG_SND_WM8994_EXTENSIONS
+		wm8994_extensions_write_failed(reg);
+#endif
 		return ret;
 	}
 }
@@ -1371,10 +1374,12 @@ static int wm8994_startup(struct snd_pcm_substream *substream,
 	struct snd_soc_codec *codec = codec_dai->codec;
 	struct wm8994_priv *wm8994 = snd_soc_codec_get_drvdata(codec);
 
-	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
+	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK) {
 		wm8994->stream_state |=  PCM_STREAM_PLAYBACK;
-	else
+		wm8994->playback_streams++;
+	} else {
 		wm8994->stream_state |= PCM_STREAM_CAPTURE;
+	}
 
 
 	if (wm8994->power_state == CODEC_OFF) {
@@ -1398,6 +1403,17 @@ static int wm8994_startup(struct snd_pcm_substream *substream,
 static void wm8994_shutdown(struct snd_pcm_substream *substream,
 			    struct snd_soc_dai *codec_dai)
 {
+	struct wm8994_priv *wm8994 =
+		snd_soc_codec_get_drvdata(codec_dai->codec);
+
+	/* Keep the playback path up while the other PCM still plays */
+	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK &&
+	    wm8994->playback_streams && --wm8994->playback_streams) {
+		DEBUG_LOG("%u playback stream(s) still open",
+				wm8994->playback_streams);
+		return;
+	}
+
 	wm8994_shutdown_codec(substream, codec_dai->codec);
 }
 
@@ -169,6 +169,7 @@ struct wm8994_priv {
 	unsigned int hw_version;
 	unsigned int codec_state;
 	unsigned int  stream_state;
+	unsigned int playback_streams;	/* open on the deep and fast PCMs */
 	enum audio_path cur_path;
 	enum mic_path rec_path;
 	enum fmradio_path fmradio_path;
@@ -25,6 +25,7 @@
 #include <mach/dma.h>
 
 #include "dma.h"
+#include "s3c-idma.h"
 
 #define ST_RUNNING		(1<<0)
 #define ST_OPENED		(1<<1)
@@ -413,11 +414,12 @@ static void dma_free_dma_buffers(struct snd_pcm *pcm)
 
 	pr_debug("Entered %s\n", __func__);
 
-#ifdef CONFIG_S5P_INTERNAL_DMA
-	for (stream = 1; stream < 2; stream++) {
-#else
 	for (stream = 0; stream < 2; stream++) {
-#endif
+		/* playback buffer belongs to the internal DMA */
+		if (stream == SNDRV_PCM_STREAM_PLAYBACK &&
+		    s5p_idma_pcm_playback(pcm))
+			continue;
+
 		substream = pcm->streams[stream].substream;
 		if (!substream)
 			continue;
@@ -446,14 +448,13 @@ static int dma_new(struct snd_card *card,
 	if (!card->dev->coherent_dma_mask)
 		card->dev->coherent_dma_mask = 0xffffffff;
 
-#ifndef CONFIG_S5P_INTERNAL_DMA
-	if (dai->driver->playback.channels_min) {
+	if (dai->driver->playback.channels_min &&
+	    !s5p_idma_pcm_playback(pcm)) {
 		ret = preallocate_dma_buffer(pcm,
 			SNDRV_PCM_STREAM_PLAYBACK);
 		if (ret)
 			goto out;
 	}
-#endif
 	if (dai->driver->capture.channels_min) {
 		ret = preallocate_dma_buffer(pcm,
 			SNDRV_PCM_STREAM_CAPTURE);
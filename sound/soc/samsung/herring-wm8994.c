@@ -11,6 +11,7 @@
 
 #include <linux/platform_device.h>
 #include <linux/clk.h>
+#include <linux/mutex.h>
 #include <sound/core.h>
 #include <sound/pcm.h>
 #include <sound/pcm_params.h>
@@ -20,6 +21,7 @@
 #include <plat/regs-iis.h>
 #include "../codecs/wm8994.h"
 #include "s3c-dma.h"
+#include "s3c-idma.h"
 #include "s5pc1xx-i2s.h"
 //#include "s3c-i2s-v2.h"
 
@@ -35,10 +37,20 @@
 #define debug_msg(x...)
 #endif
 
+/*
+ * PCM devices with playback hw_params in place, bit per device, and the
+ * format and rate the link was set up for. Both PCMs go through here, so
+ * all of it is under playback_lock.
+ */
+static DEFINE_MUTEX(playback_lock);
+static unsigned long playback_configured;
+static snd_pcm_format_t playback_format;
+static unsigned int playback_rate;
+
 /*  BLC(bits-per-channel) --> BFS(bit clock shud be >= FS*(Bit-per-channel)*2)*/
 /*  BFS --> RFS(must be a multiple of BFS)                                  */
 /*  RFS & SRC_CLK --> Prescalar Value(SRC_CLK / RFS_VAL / fs - 1)           */
-int smdkc110_hw_params(struct snd_pcm_substream *substream,
+static int smdkc110_set_link(struct snd_pcm_substream *substream,
 	struct snd_pcm_hw_params *params)
 {
 	struct snd_soc_pcm_runtime *rtd = substream->private_data;
@@ -283,26 +295,96 @@ int smdkc110_hw_params(struct snd_pcm_substream *substream,
 
 }
 
+int smdkc110_hw_params(struct snd_pcm_substream *substream,
+	struct snd_pcm_hw_params *params)
+{
+	unsigned long bit = 1 << substream->pcm->device;
+	int ret;
+
+	if (substream->stream != SNDRV_PCM_STREAM_PLAYBACK)
+		return smdkc110_set_link(substream, params);
+
+	/* The deep buffer and fast devices share one I2S link. Once either
+	 * is configured for playback the clocks are already set, and
+	 * reprogramming them under a running stream would glitch, so the
+	 * other one has to use the same format and rate. */
+	mutex_lock(&playback_lock);
+
+	if (playback_configured & ~bit) {
+		if (params_format(params) != playback_format ||
+		    params_rate(params) != playback_rate) {
+			printk(KERN_ERR "smdkc110_wm8994_hw_params : "
+				"pcm%d does not match the running stream\n",
+				substream->pcm->device);
+			ret = -EINVAL;
+		} else {
+			ret = 0;
+		}
+	} else {
+		ret = smdkc110_set_link(substream, params);
+		if (ret == 0) {
+			playback_format = params_format(params);
+			playback_rate = params_rate(params);
+		}
+	}
+
+	if (ret == 0)
+		playback_configured |= bit;
+
+	mutex_unlock(&playback_lock);
+
+	return ret;
+}
+
+static int smdkc110_hw_free(struct snd_pcm_substream *substream)
+{
+	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK) {
+		mutex_lock(&playback_lock);
+		playback_configured &= ~(1 << substream->pcm->device);
+		mutex_unlock(&playback_lock);
+	}
+
+	return 0;
+}
+
 /* machine stream operations */
 static struct snd_soc_ops smdkc110_ops = {
 	.hw_params = smdkc110_hw_params,
+	.hw_free = smdkc110_hw_free,
 };
 
-/* digital audio interface glue - connects codec <--> CPU */
-static struct snd_soc_dai_link smdkc1xx_dai = {
-	.name = "herring",
-	.stream_name = "WM8994 HiFi Playback",
-	.cpu_dai_name = "samsung-i2s.0",
-	.codec_dai_name = "WM8994 PAIFRX",
-	.platform_name = "samsung-audio",
-	.codec_name = "wm8994-samsung-codec.4-001a",
-	.ops = &smdkc110_ops,
+/* digital audio interface glue - connects codec <--> CPU
+ *
+ * Both links drive the same I2S0 <--> AIF1 connection. The first is the
+ * deep buffer device (LP audio buffer via the secondary FIFO); the second
+ * is the low latency device (primary FIFO, small system DMA ring). The
+ * order fixes the PCM device numbers, see S5P_I2S_PCM_DEEP/FAST.
+ */
+static struct snd_soc_dai_link smdkc1xx_dai[] = {
+	[S5P_I2S_PCM_DEEP] = {
+		.name = "herring",
+		.stream_name = "WM8994 HiFi Playback",
+		.cpu_dai_name = "samsung-i2s.0",
+		.codec_dai_name = "WM8994 PAIFRX",
+		.platform_name = "samsung-audio",
+		.codec_name = "wm8994-samsung-codec.4-001a",
+		.ops = &smdkc110_ops,
+	},
+	[S5P_I2S_PCM_FAST] = {
+		.name = "herring-fast",
+		.stream_name = "WM8994 Fast Playback",
+		.cpu_dai_name = "samsung-i2s.0",
+		.codec_dai_name = "WM8994 PAIFRX",
+		.platform_name = "samsung-audio",
+		.codec_name = "wm8994-samsung-codec.4-001a",
+		.ops = &smdkc110_ops,
+	},
 };
 
 static struct snd_soc_card smdkc100 = {
 	.name = "smdkc110",
-	.dai_link = &smdkc1xx_dai,
-	.num_links = 1,
+	.dai_link = smdkc1xx_dai,
+	.num_links = ARRAY_SIZE(smdkc1xx_dai),
 };
 
 #if 0
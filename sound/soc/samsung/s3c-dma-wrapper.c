@@ -14,17 +14,29 @@
 #include "dma.h"
 #include "s3c-idma.h"
 
+/*
+ * Bounds for playback on the fast PCM device. At 44.1kHz S16 stereo
+ * (176 bytes per ms) a period is at most ~6ms and the ring ~23ms, so
+ * userspace cannot accidentally open it with deep-buffer sizes.
+ */
+#define FAST_PERIOD_BYTES_MAX	(1 * 1024)
+#define FAST_BUFFER_BYTES_MAX	(4 * 1024)
+
+static struct snd_soc_platform_driver *
+s3c_wrpdma_platform(struct snd_pcm_substream *substream)
+{
+	if (s5p_idma_substream(substream))
+		return &idma_soc_platform;
+
+	return &samsung_asoc_platform;
+}
+
 static int s3c_wrpdma_hw_params(struct snd_pcm_substream *substream,
 		struct snd_pcm_hw_params *params)
 {
 	struct snd_soc_platform_driver *platform;
 
-#ifdef CONFIG_S5P_INTERNAL_DMA
-	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
-		platform = &idma_soc_platform;
-	else
-#endif
-		platform = &samsung_asoc_platform;
+	platform = s3c_wrpdma_platform(substream);
 
 	if (platform->ops->hw_params)
 		return platform->ops->hw_params(substream, params);
@@ -36,12 +48,7 @@ static int s3c_wrpdma_hw_free(struct snd_pcm_substream *substream)
 {
 	struct snd_soc_platform_driver *platform;
 
-#ifdef CONFIG_S5P_INTERNAL_DMA
-	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
-		platform = &idma_soc_platform;
-	else
-#endif
-		platform = &samsung_asoc_platform;
+	platform = s3c_wrpdma_platform(substream);
 
 	if (platform->ops->hw_free)
 		return platform->ops->hw_free(substream);
@@ -53,12 +60,7 @@ static int s3c_wrpdma_prepare(struct snd_pcm_substream *substream)
 {
 	struct snd_soc_platform_driver *platform;
 
-#ifdef CONFIG_S5P_INTERNAL_DMA
-	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
-		platform = &idma_soc_platform;
-	else
-#endif
-		platform = &samsung_asoc_platform;
+	platform = s3c_wrpdma_platform(substream);
 
 	if (platform->ops->prepare)
 		return platform->ops->prepare(substream);
@@ -70,12 +72,7 @@ static int s3c_wrpdma_trigger(struct snd_pcm_substream *substream, int cmd)
 {
 	struct snd_soc_platform_driver *platform;
 
-#ifdef CONFIG_S5P_INTERNAL_DMA
-	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
-		platform = &idma_soc_platform;
-	else
-#endif
-		platform = &samsung_asoc_platform;
+	platform = s3c_wrpdma_platform(substream);
 
 	if (platform->ops->trigger)
 		return platform->ops->trigger(substream, cmd);
@@ -87,12 +84,7 @@ static snd_pcm_uframes_t s3c_wrpdma_pointer(struct snd_pcm_substream *substream)
 {
 	struct snd_soc_platform_driver *platform;
 
-#ifdef CONFIG_S5P_INTERNAL_DMA
-	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
-		platform = &idma_soc_platform;
-	else
-#endif
-		platform = &samsung_asoc_platform;
+	platform = s3c_wrpdma_platform(substream);
 
 	if (platform->ops->pointer)
 		return platform->ops->pointer(substream);
@@ -103,30 +95,45 @@ static snd_pcm_uframes_t s3c_wrpdma_pointer(struct snd_pcm_substream *substream)
 static int s3c_wrpdma_open(struct snd_pcm_substream *substream)
 {
 	struct snd_soc_platform_driver *platform;
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	int ret;
 
-#ifdef CONFIG_S5P_INTERNAL_DMA
-	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
-		platform = &idma_soc_platform;
-	else
-#endif
-		platform = &samsung_asoc_platform;
+	platform = s3c_wrpdma_platform(substream);
 
-	if (platform->ops->open)
-		return platform->ops->open(substream);
-	else
+	if (platform->ops->open) {
+		ret = platform->ops->open(substream);
+		if (ret < 0)
+			return ret;
+	}
+
+	if (substream->stream != SNDRV_PCM_STREAM_PLAYBACK ||
+	    substream->pcm->device != S5P_I2S_PCM_FAST)
 		return 0;
+
+	ret = snd_pcm_hw_constraint_minmax(runtime,
+			SNDRV_PCM_HW_PARAM_PERIOD_BYTES, 0,
+			FAST_PERIOD_BYTES_MAX);
+	if (ret < 0)
+		goto err;
+
+	ret = snd_pcm_hw_constraint_minmax(runtime,
+			SNDRV_PCM_HW_PARAM_BUFFER_BYTES, 0,
+			FAST_BUFFER_BYTES_MAX);
+	if (ret < 0)
+		goto err;
+
+	return 0;
+err:
+	if (platform->ops->close)
+		platform->ops->close(substream);
+	return ret;
 }
 
 static int s3c_wrpdma_close(struct snd_pcm_substream *substream)
 {
 	struct snd_soc_platform_driver *platform;
 
-#ifdef CONFIG_S5P_INTERNAL_DMA
-	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
-		platform = &idma_soc_platform;
-	else
-#endif
-		platform = &samsung_asoc_platform;
+	platform = s3c_wrpdma_platform(substream);
 
 	if (platform->ops->close)
 		return platform->ops->close(substream);
@@ -139,12 +146,7 @@ static int s3c_wrpdma_ioctl(struct snd_pcm_substream *substream,
 {
 	struct snd_soc_platform_driver *platform;
 
-#ifdef CONFIG_S5P_INTERNAL_DMA
-	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
-		platform = &idma_soc_platform;
-	else
-#endif
-		platform = &samsung_asoc_platform;
+	platform = s3c_wrpdma_platform(substream);
 
 	if (platform->ops->ioctl)
 		return platform->ops->ioctl(substream, cmd, arg);
@@ -157,12 +159,7 @@ static int s3c_wrpdma_mmap(struct snd_pcm_substream *substream,
 {
 	struct snd_soc_platform_driver *platform;
 
-#ifdef CONFIG_S5P_INTERNAL_DMA
-	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
-		platform = &idma_soc_platform;
-	else
-#endif
-		platform = &samsung_asoc_platform;
+	platform = s3c_wrpdma_platform(substream);
 
 	if (platform->ops->mmap)
 		return platform->ops->mmap(substream, vma);
@@ -191,7 +188,7 @@ static void s3c_wrpdma_pcm_free(struct snd_pcm *pcm)
 
 #ifdef CONFIG_S5P_INTERNAL_DMA
 	idma_platform = &idma_soc_platform;
-	if (idma_platform->pcm_free)
+	if (s5p_idma_pcm_playback(pcm) && idma_platform->pcm_free)
 		idma_platform->pcm_free(pcm);
 #endif
 	gdma_platform = &samsung_asoc_platform;
@@ -208,11 +205,13 @@ static int s3c_wrpdma_pcm_new(struct snd_card *card,
 #endif
 
 	/* sec_fifo i/f always use internal h/w buffers
-	 * irrespective of the xfer method (iDMA or SysDMA) */
+	 * irrespective of the xfer method (iDMA or SysDMA).
+	 * The fast device plays through the primary FIFO and
+	 * gets its ring from the system DMA platform instead. */
 
 #ifdef CONFIG_S5P_INTERNAL_DMA
 	idma_platform = &idma_soc_platform;
-	if (idma_platform->pcm_new)
+	if (s5p_idma_pcm_playback(pcm) && idma_platform->pcm_new)
 		idma_platform->pcm_new(card, dai, pcm);
 #endif
 	gdma_platform  = &samsung_asoc_platform;
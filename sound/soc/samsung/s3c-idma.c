@@ -14,6 +14,8 @@
 #include <linux/platform_device.h>
 #include <linux/dma-mapping.h>
 #include <linux/slab.h>
+#include <linux/jiffies.h>
+#include <linux/math64.h>
 #include <sound/pcm.h>
 #include <sound/pcm_params.h>
 #include <sound/soc.h>
@@ -82,7 +84,8 @@ static const struct snd_pcm_hardware s3c_idma_hardware = {
 	.channels_max = 2,
 	.buffer_bytes_max = MAX_LP_BUFF,
 	.period_bytes_min = 128,
-	.period_bytes_max = 16 * 1024,
+	/* allow two periods per LP buffer so the ARM wakes rarely */
+	.period_bytes_max = MAX_LP_BUFF / 2,
 	.periods_min = 2,
 	.periods_max = 128,
 	.fifo_size = 64,
@@ -96,6 +99,10 @@ struct lpam_i2s_pdata {
 	dma_addr_t	end;
 	dma_addr_t	period;
 
+	/* wakeup accounting for the deep buffer mode */
+	unsigned long	wakeups;
+	unsigned long	run_start;
+	unsigned long	run_jiffies;
 };
 
 	/********************
@@ -117,14 +124,27 @@ static void s3c_idma_getpos(dma_addr_t *src)
 		(readl(s3c_idma.regs + S5P_IISTRNCNT) & 0xffffff) * 4;
 }
 
-void i2sdma_getpos(dma_addr_t *src)
+/*
+ * Bytes the internal DMA still has to play before it raises its next
+ * period interrupt, or UINT_MAX when it is not playing. cpuidle uses
+ * this to stay out of deep idle right before an audio wakeup.
+ */
+unsigned int i2sdma_bytes_to_irq(void)
 {
-	if (audio_clk_gated == 0 && i2s_trigger_stop == 0)
-		*src = LP_TXBUFF_ADDR +
-			(readl(s3c_idma.regs + S5P_IISTRNCNT) & 0xffffff) * 4;
-	else
-		*src = LP_TXBUFF_ADDR;
+	dma_addr_t src, irq;
+	unsigned int size;
+
+	if (audio_clk_gated || i2s_trigger_stop || !s3c_idma.dma_prd)
+		return UINT_MAX;
 
+	s3c_idma_getpos(&src);
+	irq = readl(s3c_idma.regs + S5P_IISADDR0);
+	size = s3c_idma.dma_end - LP_TXBUFF_ADDR;
+
+	if (irq >= src)
+		return irq - src;
+
+	return irq + size - src;
 }
 
 static int s3c_idma_enqueue(void *token)
@@ -153,7 +173,7 @@ static int s3c_idma_enqueue(void *token)
 	val = readl(s3c_idma.regs + S5P_IISSIZE);
 	val &= ~(S5P_IISSIZE_TRNMSK << S5P_IISSIZE_SHIFT);
 
-	val |= ((((s3c_idma.dma_end & 0x1ffff) >> 2) &
+	val |= ((((s3c_idma.dma_end - LP_TXBUFF_ADDR) >> 2) &
 			S5P_IISSIZE_TRNMSK) << S5P_IISSIZE_SHIFT);
 	writel(val, s3c_idma.regs + S5P_IISSIZE);
 
@@ -277,12 +297,15 @@ static int s3c_idma_trigger(struct snd_pcm_substream *substream, int cmd)
 	case SNDRV_PCM_TRIGGER_START:
 	case SNDRV_PCM_TRIGGER_PAUSE_RELEASE:
 		prtd->state |= ST_RUNNING;
+		prtd->run_start = jiffies;
 		s3c_idma_ctrl(LPAM_DMA_START);
 		break;
 
 	case SNDRV_PCM_TRIGGER_SUSPEND:
 	case SNDRV_PCM_TRIGGER_STOP:
 	case SNDRV_PCM_TRIGGER_PAUSE_PUSH:
+		if (prtd->state & ST_RUNNING)
+			prtd->run_jiffies += jiffies - prtd->run_start;
 		prtd->state &= ~ST_RUNNING;
 		s3c_idma_ctrl(LPAM_DMA_STOP);
 		break;
@@ -343,8 +366,11 @@ static int s3c_idma_mmap(struct snd_pcm_substream *substream,
 
 static irqreturn_t s3c_iis_irq(int irqno, void *dev_id)
 {
+	struct lpam_i2s_pdata *prtd = dev_id;
 	u32 iiscon, iisahb, val, addr;
 
+	prtd->wakeups++;
+
 	/* dump_i2s(); */
 	iisahb  = readl(s3c_idma.regs + S5P_IISAHB);
 	iiscon  = readl(s3c_idma.regs + S3C2412_IISCON);
@@ -424,6 +450,21 @@ static int s3c_idma_open(struct snd_pcm_substream *substream)
 	return 0;
 }
 
+static void s3c_idma_report(struct lpam_i2s_pdata *prtd,
+			    struct snd_pcm_runtime *runtime)
+{
+	unsigned int msecs = jiffies_to_msecs(prtd->run_jiffies);
+
+	if (!msecs)
+		return;
+
+	pr_info("%s: %lu wakeups in %u.%03us of playback, %llu/min, "
+		"period %zd bytes\n", __func__, prtd->wakeups,
+		msecs / 1000, msecs % 1000,
+		div_u64((u64)prtd->wakeups * 60000, msecs),
+		frames_to_bytes(runtime, runtime->period_size));
+}
+
 static int s3c_idma_close(struct snd_pcm_substream *substream)
 {
 	struct snd_pcm_runtime *runtime = substream->runtime;
@@ -435,6 +476,8 @@ static int s3c_idma_close(struct snd_pcm_substream *substream)
 
 	if (!prtd)
 		pr_err("s3c_idma_close called with prtd == NULL\n");
+	else
+		s3c_idma_report(prtd, runtime);
 
 	kfree(prtd);
 
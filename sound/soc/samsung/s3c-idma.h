@@ -29,6 +29,30 @@
 #define LPAM_DMA_STOP    0
 #define LPAM_DMA_START   1
 
+/*
+ * The herring card registers the I2S0 DAI twice. Playback on the first
+ * PCM device goes through the secondary FIFO and the internal DMA into
+ * the LP audio buffer, which suits large buffers. The second device is
+ * the fast path: primary FIFO, system DMA and small periods.
+ */
+#define S5P_I2S_PCM_DEEP	0
+#define S5P_I2S_PCM_FAST	1
+
+static inline bool s5p_idma_pcm_playback(struct snd_pcm *pcm)
+{
+#ifdef CONFIG_S5P_INTERNAL_DMA
+	return pcm->device != S5P_I2S_PCM_FAST;
+#else
+	return false;
+#endif
+}
+
+static inline bool s5p_idma_substream(struct snd_pcm_substream *substream)
+{
+	return substream->stream == SNDRV_PCM_STREAM_PLAYBACK &&
+		s5p_idma_pcm_playback(substream->pcm);
+}
+
 extern struct snd_soc_platform_driver idma_soc_platform;
 extern int i2s_trigger_stop;
 extern bool audio_clk_gated ;
@@ -33,6 +33,7 @@
 #include <mach/regs-clock.h>
 #include <linux/wakelock.h>
 #include "s3c-dma.h"
+#include "s3c-idma.h"
 #include "s5pc1xx-i2s.h"
 
 /*
@@ -58,7 +59,8 @@ static struct snd_soc_dai_driver s3c64xx_i2s_dai_driver[MAX_I2SV3];
 bool audio_clk_gated;	/* At first, clock & i2s0_pd is enabled in probe() */
 //EXPORT_SYMBOL_GPL(s3c64xx_i2s_dai);
 
-/* For I2S Clock/Power Gating */
+/* For I2S Clock/Power Gating: open streams in each direction. The deep
+ * buffer and fast PCM devices can both hold a playback stream. */
 static int tx_clk_enabled ;
 static int rx_clk_enabled ;
 static int reg_saved_ok ;
@@ -199,15 +201,11 @@ static int s5p_i2s_wr_hw_params(struct snd_pcm_substream *substream,
 		struct snd_pcm_hw_params *params,
 		struct snd_soc_dai *dai)
 {
-#ifdef CONFIG_S5P_INTERNAL_DMA
-	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
+	if (s5p_idma_substream(substream))
 		s5p_i2s_hw_params(substream, params, dai);
 	else
 		s3c2412_i2s_hw_params(substream, params, dai);
 
-#else
-	s3c2412_i2s_hw_params(substream, params, dai);
-#endif
 	return 0;
 }
 
@@ -471,15 +469,11 @@ exit_err:
 static int s5p_i2s_wr_trigger(struct snd_pcm_substream *substream,
 		int cmd, struct snd_soc_dai *dai)
 {
-#ifdef CONFIG_S5P_INTERNAL_DMA
-	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
+	if (s5p_idma_substream(substream))
 		s5p_i2s_trigger(substream, cmd, dai);
 	else
 		s3c2412_i2s_trigger(substream, cmd, dai);
 
-#else
-	s3c2412_i2s_trigger(substream, cmd, dai);
-#endif
 	return 0;
 }
 
@@ -758,10 +752,10 @@ static int s5p_i2s_wr_startup(struct snd_pcm_substream *substream,
 
 	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK) {
 		pr_debug("Inside..%s..for playback stream\n" , __func__);
-		tx_clk_enabled = 1;
+		tx_clk_enabled++;
 	} else {
 		pr_debug("Inside..%s..for capture stream\n" , __func__);
-		rx_clk_enabled = 1;
+		rx_clk_enabled++;
 		iiscon = readl(i2s->regs + S3C2412_IISCON);
 		if (iiscon & S3C2412_IISCON_RXDMA_ACTIVE)
 			return 0;
@@ -779,10 +773,26 @@ static int s5p_i2s_wr_startup(struct snd_pcm_substream *substream,
 		writel(iisfic, i2s->regs + S3C2412_IISFIC);
 	}
 
-#ifdef CONFIG_S5P_INTERNAL_DMA
-	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
+	if (s5p_idma_substream(substream)) {
 		s5p_i2s_startup(dai);
-#endif
+	} else if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK) {
+		/* fast path: start from an empty primary FIFO */
+		iiscon = readl(i2s->regs + S3C2412_IISCON);
+		if (iiscon & S3C2412_IISCON_TXDMA_ACTIVE)
+			return 0;
+
+		iisfic = readl(i2s->regs + S3C2412_IISFIC);
+		iisfic |= S3C2412_IISFIC_TXFLUSH;
+		writel(iisfic, i2s->regs + S3C2412_IISFIC);
+
+		do {
+			cpu_relax();
+		} while ((__raw_readl(i2s->regs + S3C2412_IISFIC) >> 8) & 0x7f);
+
+		iisfic = readl(i2s->regs + S3C2412_IISFIC);
+		iisfic &= ~S3C2412_IISFIC_TXFLUSH;
+		writel(iisfic, i2s->regs + S3C2412_IISFIC);
+	}
 	dump_reg(i2s);
 	return 0;
 }
@@ -794,7 +804,7 @@ static void s5p_i2s_wr_shutdown(struct snd_pcm_substream *substream,
 
 	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK) {
 		pr_debug("Inside %s for playback stream\n" , __func__);
-		tx_clk_enabled = 0;
+		tx_clk_enabled--;
 	} else {
 		pr_debug("Inside..%s..for capture stream\n" , __func__);
 		if (readl(i2s->regs + S3C2412_IISCON) & (1<<26)) {
@@ -806,7 +816,7 @@ static void s5p_i2s_wr_shutdown(struct snd_pcm_substream *substream,
 			writel(readl(i2s->regs + S3C2412_IISFIC) | (1<<7) ,
 					i2s->regs + S3C2412_IISFIC);
 		}
-		rx_clk_enabled = 0;
+		rx_clk_enabled--;
 	}
 
 	if (!tx_clk_enabled && !rx_clk_enabled) {